@@ -28,6 +28,7 @@
 #include "BattlescapeState.h"
 #include "../Savegame/Tile.h"
 #include "Pathfinding.h"
+#include "../Engine/Parallel.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Logger.h"
 #include "../Engine/Game.h"
@@ -208,6 +209,7 @@ void AIModule::think(BattleAction *action)
 	_attackAction->weapon = action->weapon;
 	_attackAction->number = action->number;
 	_escapeAction->number = action->number;
+	_spottingUnits.clear();
 	_knownEnemies = countKnownTargets();
 	_visibleEnemies = selectNearestTarget();
 	_spottingEnemies = getSpottingUnits(_unit->getPosition());
@@ -687,19 +689,49 @@ void AIModule::setupAmbush()
 		const int COVER_BONUS = 25;
 		const int FAST_PASS_THRESHOLD = 80;
 		Position origin = _save->getTileEngine()->getSightOriginVoxel(_aggroTarget);
+		auto isCandidate = [&](Node *node)
+		{
+			Position pos = node->getPosition();
+			Tile *tile = _save->getTile(pos);
+			return !(node->isDummy() || tile == 0 || Position::distance2d(pos, _unit->getPosition()) > 10 || pos.z != _unit->getPosition().z || tile->getDangerous() ||
+				std::find(_reachableWithAttack.begin(), _reachableWithAttack.end(), _save->getTileIndex(pos))  == _reachableWithAttack.end());
+		};
+
+		// check which nodes the enemy can see ahead on the worker threads
+		std::vector<char> targetable;
+		if (useWorkers())
+		{
+			std::vector<Node*> *nodes = _save->getNodes();
+			targetable.resize(nodes->size(), 0);
+			_save->getTileEngine()->forEachParallel(nodes->size(),
+				[&](size_t i, TileEngine *tileEngine)
+				{
+					if (isCandidate(nodes->at(i)))
+					{
+						Position target;
+						Position nodeOrigin = origin;
+						targetable[i] = tileEngine->canTargetUnit(&nodeOrigin, _save->getTile(nodes->at(i)->getPosition()), &target, _aggroTarget, false, _unit);
+					}
+				}
+			);
+			std::vector<Position> hidden;
+			for (size_t i = 0; i < nodes->size(); ++i)
+			{
+				if (!targetable[i] && isCandidate(nodes->at(i)))
+				{
+					hidden.push_back(nodes->at(i)->getPosition());
+				}
+			}
+			prepareSpottingUnits(hidden);
+		}
 
 		// we'll use node positions for this, as it gives map makers a good degree of control over how the units will use the environment.
 		for (std::vector<Node*>::const_iterator i = _save->getNodes()->begin(); i != _save->getNodes()->end(); ++i)
 		{
-			if ((*i)->isDummy())
-			{
-				continue;
-			}
+			if (!isCandidate(*i))
+				continue; // just ignore unreachable tiles
 			Position pos = (*i)->getPosition();
 			Tile *tile = _save->getTile(pos);
-			if (tile == 0 || Position::distance2d(pos, _unit->getPosition()) > 10 || pos.z != _unit->getPosition().z || tile->getDangerous() ||
-				std::find(_reachableWithAttack.begin(), _reachableWithAttack.end(), _save->getTileIndex(pos))  == _reachableWithAttack.end())
-				continue; // just ignore unreachable tiles
 
 			if (_traceAI)
 			{
@@ -710,7 +742,8 @@ void AIModule::setupAmbush()
 
 			// make sure we can't be seen here.
 			Position target;
-			if (!_save->getTileEngine()->canTargetUnit(&origin, tile, &target, _aggroTarget, false, _unit) && !getSpottingUnits(pos))
+			bool canTarget = targetable.empty() ? _save->getTileEngine()->canTargetUnit(&origin, tile, &target, _aggroTarget, false, _unit) : targetable[i - _save->getNodes()->begin()];
+			if (!canTarget && !getSpottingUnits(pos))
 			{
 				_save->getPathfinding()->calculate(_unit, pos);
 				int ambushTUs = _save->getPathfinding()->getTotalTUCost();
@@ -911,6 +944,18 @@ void AIModule::setupEscape()
 	std::vector<Position> randomTileSearch = _save->getTileSearch();
 	RNG::shuffle(randomTileSearch);
 
+	if (useWorkers())
+	{
+		// count the spotters of the systematic search ahead on the worker threads
+		std::vector<Position> positions;
+		positions.push_back(_unit->lastCover);
+		for (size_t i = 0; i < randomTileSearch.size() && i < 121; ++i)
+		{
+			positions.push_back(_unit->getPosition() + Position(randomTileSearch[i].x, randomTileSearch[i].y, 0));
+		}
+		prepareSpottingUnits(positions);
+	}
+
 	while (tries < 150 && !coverFound)
 	{
 		_escapeAction->target = _unit->getPosition(); // start looking in a direction away from the enemy
@@ -1101,10 +1146,70 @@ int AIModule::countKnownTargets() const
 
 /*
  * counts how many enemies (xcom only) are spotting any given position.
+ * Positions counted ahead by prepareSpottingUnits() are taken from there.
  * @param pos the Position to check for spotters.
  * @return spotters.
  */
 int AIModule::getSpottingUnits(const Position& pos) const
+{
+	if (!_spottingUnits.empty() && _save->getTile(pos))
+	{
+		std::unordered_map<int, int>::const_iterator it = _spottingUnits.find(_save->getTileIndex(pos));
+		if (it != _spottingUnits.end())
+		{
+			return it->second;
+		}
+	}
+	return countSpottingUnits(pos, _save->getTileEngine());
+}
+
+/**
+ * Checks if there are worker threads to share the position searches with.
+ * Without them the searches check one position after another as before,
+ * as they often stop early once a good enough one is found.
+ * @return True if the checks should be done ahead on the worker threads.
+ */
+bool AIModule::useWorkers() const
+{
+	return Parallel::getThreadCount() > 1;
+}
+
+/**
+ * Counts the spotters of several positions at once, spread over the
+ * worker threads. Counting only traces lines of fire, so the results are
+ * the same as counting them one by one later.
+ * @param positions Positions to check.
+ */
+void AIModule::prepareSpottingUnits(const std::vector<Position> &positions)
+{
+	std::vector<Position> todo;
+	for (std::vector<Position>::const_iterator i = positions.begin(); i != positions.end(); ++i)
+	{
+		if (_save->getTile(*i) && _spottingUnits.insert(std::make_pair(_save->getTileIndex(*i), 0)).second)
+		{
+			todo.push_back(*i);
+		}
+	}
+	std::vector<int> spotters(todo.size());
+	_save->getTileEngine()->forEachParallel(todo.size(),
+		[&](size_t i, TileEngine *tileEngine)
+		{
+			spotters[i] = countSpottingUnits(todo[i], tileEngine);
+		}
+	);
+	for (size_t i = 0; i < todo.size(); ++i)
+	{
+		_spottingUnits[_save->getTileIndex(todo[i])] = spotters[i];
+	}
+}
+
+/*
+ * counts how many enemies (xcom only) are spotting any given position.
+ * @param pos the Position to check for spotters.
+ * @param tileEngine Tile engine used for the line of fire checks.
+ * @return spotters.
+ */
+int AIModule::countSpottingUnits(const Position& pos, TileEngine *tileEngine) const
 {
 	// if we don't actually occupy the position being checked, we need to do a virtual LOF check.
 	bool checking = pos != _unit->getPosition();
@@ -1115,19 +1220,19 @@ int AIModule::getSpottingUnits(const Position& pos) const
 		{
 			int dist = Position::distance2d(pos, (*i)->getPosition());
 			if (dist > 20) continue;
-			Position originVoxel = _save->getTileEngine()->getSightOriginVoxel(*i);
+			Position originVoxel = tileEngine->getSightOriginVoxel(*i);
 			originVoxel.z -= 2;
 			Position targetVoxel;
 			if (checking)
 			{
-				if (_save->getTileEngine()->canTargetUnit(&originVoxel, _save->getTile(pos), &targetVoxel, *i, false, _unit))
+				if (tileEngine->canTargetUnit(&originVoxel, _save->getTile(pos), &targetVoxel, *i, false, _unit))
 				{
 					tally++;
 				}
 			}
 			else
 			{
-				if (_save->getTileEngine()->canTargetUnit(&originVoxel, _save->getTile(pos), &targetVoxel, *i, false))
+				if (tileEngine->canTargetUnit(&originVoxel, _save->getTile(pos), &targetVoxel, *i, false))
 				{
 					tally++;
 				}
@@ -1822,20 +1927,60 @@ bool AIModule::findFirePoint()
 	bool extendedFireModeChoiceEnabled = _save->getBattleGame()->getMod()->getAIExtendedFireModeChoice();
 	int bestScore = 0;
 	_attackAction->type = BA_RETHINK;
-	for (std::vector<Position>::const_iterator i = randomTileSearch.begin(); i != randomTileSearch.end(); ++i)
+	auto getCandidate = [&](const Position &offset) -> Tile*
 	{
-		Position pos = _unit->getPosition() + *i;
-		Tile *tile = _save->getTile(pos);
+		Tile *tile = _save->getTile(_unit->getPosition() + offset);
 		if (tile == 0  ||
-			std::find(_reachableWithAttack.begin(), _reachableWithAttack.end(), _save->getTileIndex(pos))  == _reachableWithAttack.end())
-			continue;
-		int score = 0;
+			std::find(_reachableWithAttack.begin(), _reachableWithAttack.end(), _save->getTileIndex(tile->getPosition()))  == _reachableWithAttack.end())
+			return 0;
+		return tile;
+	};
+	auto getOrigin = [&](Tile *tile)
+	{
 		// i should really make a function for this
-		Position origin = pos.toVoxel() +
+		return tile->getPosition().toVoxel() +
 			// 4 because -2 is eyes and 2 below that is the rifle (or at least that's my understanding)
 			Position(8,8, _unit->getHeight() + _unit->getFloatHeight() - tile->getTerrainLevel() - 4);
+	};
+
+	// check the lines of fire and the spotters ahead on the worker threads
+	std::vector<char> targetable;
+	if (useWorkers())
+	{
+		targetable.resize(randomTileSearch.size(), 0);
+		_save->getTileEngine()->forEachParallel(randomTileSearch.size(),
+			[&](size_t i, TileEngine *tileEngine)
+			{
+				if (Tile *tile = getCandidate(randomTileSearch[i]))
+				{
+					Position origin = getOrigin(tile);
+					Position scan;
+					targetable[i] = tileEngine->canTargetUnit(&origin, _aggroTarget->getTile(), &scan, _unit, false);
+				}
+			}
+		);
+		std::vector<Position> positions;
+		for (size_t i = 0; i < randomTileSearch.size(); ++i)
+		{
+			if (targetable[i])
+			{
+				positions.push_back(_unit->getPosition() + randomTileSearch[i]);
+			}
+		}
+		prepareSpottingUnits(positions);
+	}
+
+	for (std::vector<Position>::const_iterator i = randomTileSearch.begin(); i != randomTileSearch.end(); ++i)
+	{
+		Position pos = _unit->getPosition() + *i;
+		Tile *tile = getCandidate(*i);
+		if (tile == 0)
+			continue;
+		int score = 0;
+		Position origin = getOrigin(tile);
 
-		if (_save->getTileEngine()->canTargetUnit(&origin, _aggroTarget->getTile(), &target, _unit, false))
+		bool canTarget = targetable.empty() ? _save->getTileEngine()->canTargetUnit(&origin, _aggroTarget->getTile(), &target, _unit, false) : targetable[i - randomTileSearch.begin()];
+		if (canTarget)
 		{
 			_save->getPathfinding()->calculate(_unit, pos);
 			// can move here
@@ -21,6 +21,7 @@
 #include "BattlescapeGame.h"
 #include "Position.h"
 #include "../Savegame/BattleUnit.h"
+#include <unordered_map>
 #include <vector>
 
 
@@ -32,6 +33,7 @@ class BattleUnit;
 struct BattleAction;
 class BattlescapeState;
 class Node;
+class TileEngine;
 
 enum AIMode { AI_PATROL, AI_AMBUSH, AI_COMBAT, AI_ESCAPE };
 /**
@@ -55,11 +57,18 @@ private:
 	std::vector<int> _reachable, _reachableWithAttack, _wasHitBy;
 	BattleActionType _reserve;
 	UnitFaction _targetFaction;
+	std::unordered_map<int, int> _spottingUnits;
 
 	bool selectPointNearTargetLeeroy(BattleUnit *target) const;
 	int selectNearestTargetLeeroy();
 	void meleeActionLeeroy();
 	void dont_think(BattleAction *action);
+	/// Counts the known XCom units able to see a position, using a specific tile engine.
+	int countSpottingUnits(const Position& pos, TileEngine *tileEngine) const;
+	/// Counts the spotters of several positions at once on the worker threads.
+	void prepareSpottingUnits(const std::vector<Position> &positions);
+	/// Checks if the worker threads should take part in the searches.
+	bool useWorkers() const;
 public:
 	/// Creates a new AIModule linked to the game and a certain unit.
 	AIModule(SavedBattleGame *save, BattleUnit *unit, Node *node);
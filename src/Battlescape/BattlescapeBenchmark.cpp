@@ -0,0 +1,917 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BattlescapeBenchmark.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <yaml-cpp/yaml.h>
+#include "BattlescapeGame.h"
+#include "BattlescapeState.h"
+#include "InfoboxOKState.h"
+#include "InfoboxState.h"
+#include "NextTurnState.h"
+#include "Pathfinding.h"
+#include "TileEngine.h"
+#include "../Engine/CrossPlatform.h"
+#include "../Engine/Exception.h"
+#include "../Engine/Game.h"
+#include "../Engine/Logger.h"
+#include "../Engine/Options.h"
+#include "../Engine/Profiler.h"
+#include "../Engine/RNG.h"
+#include "../Engine/Script.h"
+#include "../Engine/ShaderKernels.h"
+#include "../Engine/Surface.h"
+#include "../Engine/SurfaceSet.h"
+#include "../Mod/Armor.h"
+#include "../Mod/Mod.h"
+#include "../Savegame/BattleItem.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/BinarySave.h"
+#include "../Savegame/Node.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/SavedGame.h"
+#include "../Savegame/Tile.h"
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+/// Number of logic steps after which a side is considered stuck.
+const int MAX_STEPS_PER_SIDE = 1000000;
+
+const char *sideName(UnitFaction side)
+{
+	switch (side)
+	{
+	case FACTION_PLAYER: return "player";
+	case FACTION_HOSTILE: return "hostile";
+	default: return "neutral";
+	}
+}
+
+/**
+ * Compares two YAML nodes, ignoring the order of map keys and tags.
+ * @param a First node.
+ * @param b Second node.
+ * @return True if they hold the same data.
+ */
+bool sameNode(const YAML::Node &a, const YAML::Node &b)
+{
+	if (a.Type() != b.Type())
+	{
+		return false;
+	}
+	switch (a.Type())
+	{
+	case YAML::NodeType::Scalar:
+		return a.Scalar() == b.Scalar();
+	case YAML::NodeType::Sequence:
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (!sameNode(a[i], b[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	case YAML::NodeType::Map:
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (YAML::const_iterator i = a.begin(); i != a.end(); ++i)
+		{
+			const YAML::Node &other = b[i->first.Scalar()];
+			if (!other || !sameNode(i->second, other))
+			{
+				return false;
+			}
+		}
+		return true;
+	default:
+		return true;
+	}
+}
+
+/**
+ * Compares the documents of two YAML saves.
+ * @param a First save.
+ * @param b Second save.
+ * @return True if they hold the same data.
+ */
+bool sameSave(const std::string &a, const std::string &b)
+{
+	std::vector<YAML::Node> docsA = YAML::LoadAll(a), docsB = YAML::LoadAll(b);
+	if (docsA.size() != docsB.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < docsA.size(); ++i)
+	{
+		if (!sameNode(docsA[i], docsB[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Fills a battle with random fire, smoke and light, then scans and
+ * clears them over the whole map, the way a new turn and the lighting do.
+ * @param battle Battle to scan.
+ * @param dense Use the arrays of the tile store instead of the tile objects.
+ * @param repeat Number of scans.
+ * @param time Receives the time spent scanning.
+ * @return Checksum of the values seen.
+ */
+uint64_t scanTiles(SavedBattleGame *battle, bool dense, int repeat, uint64_t &time)
+{
+	int size = battle->getMapSizeXYZ();
+	RNG::setSeed(size);
+	for (int i = 0; i < size; ++i)
+	{
+		Tile *tile = battle->getTile(i);
+		tile->setFire(RNG::percent(5) ? RNG::generate(1, 3) : 0);
+		tile->setSmoke(RNG::percent(10) ? RNG::generate(1, 15) : 0);
+		for (int layer = 0; layer < LL_MAX; ++layer)
+		{
+			tile->resetLight((LightLayers)layer);
+			tile->addLight(RNG::generate(0, 15), (LightLayers)layer);
+		}
+	}
+
+	uint64_t sum = 0;
+	uint64_t start = Profiler::now();
+	TileStore *store = battle->getTileStore();
+	for (int r = 0; r < repeat; ++r)
+	{
+		if (dense)
+		{
+			const Uint8 *fire = store->getFire();
+			const Uint8 *smoke = store->getSmoke();
+			for (int i = 0; i < size; ++i)
+			{
+				sum += fire[i] + smoke[i];
+			}
+			const Uint8 *light[LL_MAX];
+			for (int layer = 0; layer < LL_MAX; ++layer)
+			{
+				light[layer] = store->getLight((LightLayers)layer);
+			}
+			for (int i = 0; i < size; ++i)
+			{
+				sum += std::max(std::max(light[LL_AMBIENT][i], light[LL_FIRE][i]), std::max(light[LL_ITEMS][i], light[LL_UNITS][i]));
+			}
+			store->resetLight(LL_ITEMS, 0, size);
+		}
+		else
+		{
+			for (int i = 0; i < size; ++i)
+			{
+				Tile *tile = battle->getTile(i);
+				sum += tile->getFire() + tile->getSmoke();
+			}
+			for (int i = 0; i < size; ++i)
+			{
+				sum += battle->getTile(i)->getLightMulti(LL_UNITS);
+			}
+			for (int i = 0; i < size; ++i)
+			{
+				battle->getTile(i)->resetLightMulti(LL_ITEMS);
+			}
+		}
+	}
+	time = Profiler::now() - start;
+	return sum;
+}
+
+}
+
+/**
+ * Sets up the benchmark from the command line options:
+ * -benchmark NAME -benchmarkSave FILE -benchmarkTurns N -benchmarkRepeat N -benchmarkSeed SEED
+ * @param game Pointer to the core game.
+ */
+BattlescapeBenchmark::BattlescapeBenchmark(Game *game) : _game(game), _turns(10), _repeat(10), _seed(0), _state(0), _finished(false), _validArgs(true)
+{
+	_name = Options::getBenchmark();
+	_saveName = Options::getCommandLineArg("benchmarkSave");
+	try
+	{
+		_turns = std::stoi(Options::getCommandLineArg("benchmarkTurns", "10"));
+		_repeat = std::stoi(Options::getCommandLineArg("benchmarkRepeat", "10"));
+		_seed = std::stoull(Options::getCommandLineArg("benchmarkSeed", "0"));
+	}
+	catch (const std::logic_error &)
+	{
+		// std::invalid_argument or std::out_of_range
+		_validArgs = false;
+	}
+}
+
+/**
+ * Deletes any states left over by the battle.
+ */
+BattlescapeBenchmark::~BattlescapeBenchmark()
+{
+	_game->cleanupStates();
+}
+
+/**
+ * Gets the battle being benchmarked.
+ * @return Pointer to the saved battle, or 0 before loading.
+ */
+SavedBattleGame *BattlescapeBenchmark::getSave() const
+{
+	return _game->getSavedGame() ? _game->getSavedGame()->getSavedBattle() : 0;
+}
+
+/**
+ * Runs the benchmark requested on the command line.
+ * @return True if it ran to the end.
+ */
+bool BattlescapeBenchmark::run()
+{
+	if (!_validArgs)
+	{
+		Log(LOG_ERROR) << "Benchmark options need numbers: -benchmarkTurns N -benchmarkRepeat N -benchmarkSeed SEED";
+		return false;
+	}
+	if (_saveName.empty())
+	{
+		Log(LOG_ERROR) << "Benchmark needs a save file, use -benchmarkSave FILE";
+		return false;
+	}
+	Profiler::enabled = true;
+	_game->loadMods();
+	_game->loadLanguages();
+	if (!loadBattle())
+	{
+		return false;
+	}
+
+	if (_name == "battle")
+	{
+		return runBattle();
+	}
+	else if (_name == "pathfinding")
+	{
+		return runPathfinding();
+	}
+	else if (_name == "lighting")
+	{
+		return runLighting();
+	}
+	else if (_name == "tracing")
+	{
+		return runTracing();
+	}
+	else if (_name == "tiles")
+	{
+		return runTiles();
+	}
+	else if (_name == "save")
+	{
+		return runSaving();
+	}
+	else if (_name == "blit")
+	{
+		return runBlitting();
+	}
+	Log(LOG_ERROR) << "Unknown benchmark: " << _name;
+	return false;
+}
+
+/**
+ * Loads the save file and builds the battlescape the same way
+ * loading a game does, but doesn't start the state machine.
+ * @return True if the save contains a battle.
+ */
+bool BattlescapeBenchmark::loadBattle()
+{
+	SavedGame *save = new SavedGame();
+	try
+	{
+		save->load(_saveName, _game->getMod(), _game->getLanguage());
+	}
+	catch (Exception &e)
+	{
+		Log(LOG_ERROR) << "Failed to load " << _saveName << ": " << e.what();
+		delete save;
+		return false;
+	}
+	catch (YAML::Exception &e)
+	{
+		Log(LOG_ERROR) << "Failed to load " << _saveName << ": " << e.what();
+		delete save;
+		return false;
+	}
+	_game->setSavedGame(save);
+	if (save->getSavedBattle() == 0)
+	{
+		Log(LOG_ERROR) << _saveName << " is not a battlescape save";
+		return false;
+	}
+	if (_seed != 0)
+	{
+		RNG::setSeed(_seed);
+	}
+	Log(LOG_INFO) << "Benchmark seed: " << RNG::getSeed();
+
+	SavedBattleGame *battle = save->getSavedBattle();
+	battle->loadMapResources(_game->getMod());
+	Options::baseXResolution = Options::baseXBattlescape;
+	Options::baseYResolution = Options::baseYBattlescape;
+	_state = new BattlescapeState;
+	_game->setState(_state);
+	battle->setBattleState(_state);
+	_state->getBattleGame()->init();
+	return true;
+}
+
+/**
+ * Closes the screens the battle logic pushed on top of the battlescape,
+ * as if the player clicked through them.
+ * @return False if the battle is over.
+ */
+bool BattlescapeBenchmark::handlePushedStates()
+{
+	while (!_game->isState(_state))
+	{
+		State *top = _game->getTopState();
+		if (NextTurnState *nextTurn = dynamic_cast<NextTurnState*>(top))
+		{
+			BattlescapeTally tally = _state->getBattleGame()->tallyUnits();
+			if (tally.liveAliens == 0 || tally.liveSoldiers == 0)
+			{
+				// closing would start the debriefing
+				return false;
+			}
+			nextTurn->close();
+		}
+		else if (dynamic_cast<InfoboxState*>(top) || dynamic_cast<InfoboxOKState*>(top))
+		{
+			_game->popState();
+		}
+		else
+		{
+			// debriefing, next stage briefing or cutscene
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Runs the battle logic of the current side until it ends its turn.
+ * The player side ends its turn right away.
+ * @return False if the logic got stuck.
+ */
+bool BattlescapeBenchmark::playSide()
+{
+	SavedBattleGame *battle = getSave();
+	BattlescapeGame *battleGame = _state->getBattleGame();
+	UnitFaction side = battle->getSide();
+	int turn = battle->getTurn();
+
+	for (int step = 0; step < MAX_STEPS_PER_SIDE; ++step)
+	{
+		if (!handlePushedStates())
+		{
+			_finished = true;
+			return true;
+		}
+		if (battle->getSide() != side || battle->getTurn() != turn)
+		{
+			return true;
+		}
+		if (side == FACTION_PLAYER && !battleGame->isBusy())
+		{
+			battleGame->requestEndTurn(false);
+		}
+		battleGame->think();
+		battleGame->handleState();
+	}
+	Log(LOG_ERROR) << "Benchmark: " << sideName(side) << " side of turn " << turn << " did not end after " << MAX_STEPS_PER_SIDE << " steps";
+	return false;
+}
+
+/**
+ * Plays the requested number of turns and logs the timings.
+ * Every side of every turn gets its own report.
+ * @return True if the battle ran without getting stuck.
+ */
+bool BattlescapeBenchmark::runBattle()
+{
+	SavedBattleGame *battle = getSave();
+	uint64_t total = 0;
+	int startTurn = battle->getTurn();
+	while (!_finished && battle->getTurn() < startTurn + _turns)
+	{
+		UnitFaction side = battle->getSide();
+		int turn = battle->getTurn();
+
+		Profiler::reset();
+		uint64_t start = Profiler::now();
+		if (!playSide())
+		{
+			return false;
+		}
+		uint64_t elapsed = Profiler::now() - start;
+		total += elapsed;
+
+		std::ostringstream ss;
+		ss << "Benchmark turn " << turn << " " << sideName(side) << ": " << elapsed / 1000.0 << "ms" << std::endl;
+		Profiler::report(ss);
+		Log(LOG_INFO) << ss.str();
+	}
+	Log(LOG_INFO) << "Benchmark finished: " << battle->getTurn() - startTurn << " turns in " << total / 1000.0 << "ms"
+		<< (_finished ? " (battle over)" : "");
+	Log(LOG_INFO) << "Benchmark fingerprint: " << std::hex << getFingerprint() << " rng: " << RNG::getSeed() << std::dec;
+	return true;
+}
+
+/**
+ * Runs the reachability and path searches of every unit to every
+ * spawn node, the way the AI uses them, first with the reference
+ * full reset and binary heap, then with the search workspace and
+ * bucket queue. Both must reach the same tiles and find paths of the
+ * same cost, the route may differ where nodes tie.
+ * @return True if both searches agree.
+ */
+bool BattlescapeBenchmark::runPathfinding()
+{
+	SavedBattleGame *battle = getSave();
+	Pathfinding *pathfinding = battle->getPathfinding();
+	std::vector<BattleUnit*> units;
+	for (BattleUnit *unit : *battle->getUnits())
+	{
+		if (!unit->isOut() && unit->getTile())
+		{
+			units.push_back(unit);
+		}
+	}
+
+	uint64_t times[2] = { 0, 0 };
+	std::vector<std::vector<int> > reachable[2];
+	std::vector<int> costs[2];
+	std::vector<std::vector<int> > paths[2];
+	for (int mode = 0; mode < 2; ++mode)
+	{
+		pathfinding->setReferenceSearch(mode == 0);
+		uint64_t start = Profiler::now();
+		for (int repeat = 0; repeat < _repeat; ++repeat)
+		{
+			reachable[mode].clear();
+			costs[mode].clear();
+			paths[mode].clear();
+			// every repeat has to search again
+			pathfinding->invalidateReachable();
+			for (BattleUnit *unit : units)
+			{
+				std::vector<int> tiles = pathfinding->findReachable(unit, BattleActionCost());
+				std::sort(tiles.begin(), tiles.end());
+				reachable[mode].push_back(tiles);
+				for (Node *node : *battle->getNodes())
+				{
+					pathfinding->calculate(unit, node->getPosition());
+					bool found = pathfinding->getStartDirection() != -1;
+					costs[mode].push_back(found ? pathfinding->getTotalTUCost() : -1);
+					paths[mode].push_back(pathfinding->getPath());
+				}
+			}
+		}
+		times[mode] = Profiler::now() - start;
+		pathfinding->abortPath();
+	}
+	pathfinding->setReferenceSearch(false);
+
+	Log(LOG_INFO) << "Benchmark pathfinding: " << units.size() << " units, " << battle->getNodes()->size() << " nodes, " << _repeat << " times";
+	Log(LOG_INFO) << "Benchmark pathfinding reference: " << times[0] / 1000.0 << "ms";
+	Log(LOG_INFO) << "Benchmark pathfinding workspace: " << times[1] / 1000.0 << "ms";
+	if (reachable[0] != reachable[1] || costs[0] != costs[1])
+	{
+		Log(LOG_ERROR) << "Benchmark pathfinding: searches found different results";
+		return false;
+	}
+	int different = 0;
+	for (size_t i = 0; i < paths[0].size(); ++i)
+	{
+		if (paths[0][i] != paths[1][i])
+		{
+			++different;
+		}
+	}
+	if (different != 0)
+	{
+		// the heap orders nodes of the same cost by its layout, the buckets by insertion
+		Log(LOG_WARNING) << "Benchmark pathfinding: " << different << " paths take a different route of the same cost";
+	}
+	return true;
+}
+
+/**
+ * Moves every unit one tile and back, updating the unit lights the way
+ * walking does, first with the full recalculation of the light layers,
+ * then with the incremental one. Night missions with a lot of flares
+ * on the ground show the difference best.
+ * @return True if both modes give the same shading.
+ */
+bool BattlescapeBenchmark::runLighting()
+{
+	SavedBattleGame *battle = getSave();
+	TileEngine *tileEngine = battle->getTileEngine();
+	bool incremental = Options::oxceIncrementalLighting;
+	int flares = 0;
+	for (int i = 0; i < battle->getMapSizeXYZ(); ++i)
+	{
+		for (BattleItem *item : *battle->getTile(i)->getInventory())
+		{
+			if (item->getGlow())
+			{
+				++flares;
+				break;
+			}
+		}
+	}
+
+	uint64_t times[2] = { 0, 0 };
+	std::vector<int> shades[2];
+	for (int mode = 0; mode < 2; ++mode)
+	{
+		Options::oxceIncrementalLighting = (mode == 1);
+		tileEngine->calculateLighting(LL_AMBIENT, TileEngine::invalid, 0, true);
+		tileEngine->calculateLighting(LL_ITEMS);
+		uint64_t start = Profiler::now();
+		for (int repeat = 0; repeat < _repeat; ++repeat)
+		{
+			for (BattleUnit *unit : *battle->getUnits())
+			{
+				Position pos = unit->getPosition();
+				Position next = pos + Position(1, 0, 0);
+				if (unit->isOut() || !battle->getTile(next))
+				{
+					continue;
+				}
+				unit->setPosition(next, false);
+				tileEngine->calculateLighting(LL_UNITS, next, 2);
+				unit->setPosition(pos, false);
+				tileEngine->calculateLighting(LL_UNITS, pos, 2);
+			}
+		}
+		times[mode] = Profiler::now() - start;
+		for (int i = 0; i < battle->getMapSizeXYZ(); ++i)
+		{
+			shades[mode].push_back(battle->getTile(i)->getShade());
+		}
+	}
+	Options::oxceIncrementalLighting = incremental;
+
+	int different = 0;
+	for (size_t i = 0; i < shades[0].size(); ++i)
+	{
+		if (shades[0][i] != shades[1][i])
+		{
+			++different;
+		}
+	}
+	Log(LOG_INFO) << "Benchmark lighting: " << battle->getUnits()->size() << " units, " << flares << " tiles with flares, " << _repeat << " times";
+	Log(LOG_INFO) << "Benchmark lighting full: " << times[0] / 1000.0 << "ms";
+	Log(LOG_INFO) << "Benchmark lighting incremental: " << times[1] / 1000.0 << "ms";
+	if (different != 0)
+	{
+		Log(LOG_ERROR) << "Benchmark lighting: " << different << " tiles with different shading";
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Traces the exposure of every unit to every other unit and a throw
+ * arc between them, the way the AI scores its targets, first checking
+ * every voxel, then skipping the clear tiles. Both must hit the same.
+ * @return True if both modes give the same results.
+ */
+bool BattlescapeBenchmark::runTracing()
+{
+	SavedBattleGame *battle = getSave();
+	TileEngine *tileEngine = battle->getTileEngine();
+	std::vector<BattleUnit*> units;
+	for (BattleUnit *unit : *battle->getUnits())
+	{
+		if (!unit->isOut() && unit->getTile())
+		{
+			units.push_back(unit);
+		}
+	}
+
+	uint64_t times[2] = { 0, 0 };
+	std::vector<int> results[2];
+	std::vector<Position> trajectory;
+	for (int mode = 0; mode < 2; ++mode)
+	{
+		tileEngine->setReferenceTracing(mode == 0);
+		uint64_t start = Profiler::now();
+		for (int repeat = 0; repeat < _repeat; ++repeat)
+		{
+			results[mode].clear();
+			for (BattleUnit *unit : units)
+			{
+				Position origin = tileEngine->getSightOriginVoxel(unit);
+				for (BattleUnit *target : units)
+				{
+					if (target == unit)
+					{
+						continue;
+					}
+					results[mode].push_back(tileEngine->checkVoxelExposure(&origin, target->getTile(), unit, target));
+					Position targetVoxel = target->getPosition().toVoxel() + Position(8, 8, 2 - target->getTile()->getTerrainLevel());
+					trajectory.clear();
+					results[mode].push_back(tileEngine->calculateParabolaVoxel(origin, targetVoxel, false, &trajectory, unit, 1.5, Position(0, 0, 0)));
+					for (const Position &p : trajectory)
+					{
+						results[mode].push_back(p.x);
+						results[mode].push_back(p.y);
+						results[mode].push_back(p.z);
+					}
+				}
+			}
+		}
+		times[mode] = Profiler::now() - start;
+	}
+	tileEngine->setReferenceTracing(false);
+
+	Log(LOG_INFO) << "Benchmark tracing: " << units.size() << " units, " << _repeat << " times";
+	Log(LOG_INFO) << "Benchmark tracing every voxel: " << times[0] / 1000.0 << "ms";
+	Log(LOG_INFO) << "Benchmark tracing skipping clear tiles: " << times[1] / 1000.0 << "ms";
+	if (results[0] != results[1])
+	{
+		Log(LOG_ERROR) << "Benchmark tracing: traces hit different voxels";
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Compares scanning the fire, smoke and light of the whole map through
+ * the tile objects and through the tile store, on the loaded battle and
+ * on an empty 100x100x8 map. Both must see the same values.
+ * @return True if both ways give the same results.
+ */
+bool BattlescapeBenchmark::runTiles()
+{
+	SavedBattleGame sized(_game->getMod(), _game->getLanguage());
+	sized.initMap(100, 100, 8);
+	SavedBattleGame *battles[] = { getSave(), &sized };
+	bool same = true;
+	for (SavedBattleGame *battle : battles)
+	{
+		uint64_t times[2] = { 0, 0 };
+		uint64_t sums[2];
+		for (int mode = 0; mode < 2; ++mode)
+		{
+			sums[mode] = scanTiles(battle, mode == 1, _repeat, times[mode]);
+		}
+		Log(LOG_INFO) << "Benchmark tiles: " << battle->getMapSizeX() << "x" << battle->getMapSizeY() << "x" << battle->getMapSizeZ() << ", " << _repeat << " times";
+		Log(LOG_INFO) << "Benchmark tiles objects: " << times[0] / 1000.0 << "ms";
+		Log(LOG_INFO) << "Benchmark tiles store: " << times[1] / 1000.0 << "ms";
+		if (sums[0] != sums[1])
+		{
+			Log(LOG_ERROR) << "Benchmark tiles: different results " << sums[0] << " and " << sums[1];
+			same = false;
+		}
+	}
+	return same;
+}
+
+/**
+ * Saves and loads the game in both save formats, logging the time
+ * each one takes, and checks that converting between them doesn't
+ * lose anything.
+ * @return True if both formats hold the same game.
+ */
+bool BattlescapeBenchmark::runSaving()
+{
+	const std::string names[2] = { "_benchmark_yaml.tmp", "_benchmark_binary.tmp" };
+	bool binary = Options::oxceBinarySaves;
+	uint64_t saveTimes[2] = { 0, 0 }, loadTimes[2] = { 0, 0 };
+	for (int mode = 0; mode < 2; ++mode)
+	{
+		Options::oxceBinarySaves = (mode == 1);
+		for (int repeat = 0; repeat < _repeat; ++repeat)
+		{
+			uint64_t start = Profiler::now();
+			_game->getSavedGame()->save(names[mode], _game->getMod());
+			saveTimes[mode] += Profiler::now() - start;
+
+			SavedGame loaded;
+			start = Profiler::now();
+			loaded.load(names[mode], _game->getMod(), _game->getLanguage());
+			loadTimes[mode] += Profiler::now() - start;
+		}
+	}
+	Options::oxceBinarySaves = binary;
+
+	std::string yamlPath = Options::getMasterUserFolder() + names[0];
+	std::string binaryPath = Options::getMasterUserFolder() + names[1];
+	std::vector<unsigned char> yamlData = CrossPlatform::readFileRaw(yamlPath);
+	std::vector<unsigned char> binaryData = CrossPlatform::readFileRaw(binaryPath);
+	std::string yaml((const char*)yamlData.data(), yamlData.size());
+	bool toYaml = sameSave(yaml, BinarySave::toYaml(binaryData));
+	bool roundTrip = sameSave(yaml, BinarySave::toYaml(BinarySave::fromYaml(yaml)));
+	CrossPlatform::deleteFile(yamlPath);
+	CrossPlatform::deleteFile(binaryPath);
+
+	Log(LOG_INFO) << "Benchmark save: " << getSave()->getUnits()->size() << " units, " << getSave()->getItems()->size() << " items, " << _repeat << " times";
+	Log(LOG_INFO) << "Benchmark save YAML: " << yamlData.size() << " bytes, save " << saveTimes[0] / 1000.0 << "ms, load " << loadTimes[0] / 1000.0 << "ms";
+	Log(LOG_INFO) << "Benchmark save binary: " << binaryData.size() << " bytes, save " << saveTimes[1] / 1000.0 << "ms, load " << loadTimes[1] / 1000.0 << "ms";
+	if (!toYaml)
+	{
+		Log(LOG_WARNING) << "Benchmark save: binary save converted to YAML is different from the YAML save";
+	}
+	if (!roundTrip)
+	{
+		Log(LOG_WARNING) << "Benchmark save: YAML save converted to binary and back is different";
+	}
+	return toYaml && roundTrip;
+}
+
+/**
+ * Blits all frames of BIGOBS.PCK and of the sprite sheets of the units
+ * in the battle with every shade, once for each set of blit kernels the
+ * CPU supports, logging the time each one takes. The item sprites also
+ * get recolored, the unit sprites go through the unscripted path of
+ * ScriptWorkerBlit like UnitSprite does.
+ * @return True if all kernels draw the same pixels.
+ */
+bool BattlescapeBenchmark::runBlitting()
+{
+	std::vector<std::string> sheets;
+	for (BattleUnit *unit : *getSave()->getUnits())
+	{
+		const std::string &sheet = unit->getArmor()->getSpriteSheet();
+		if (std::find(sheets.begin(), sheets.end(), sheet) == sheets.end())
+		{
+			sheets.push_back(sheet);
+		}
+	}
+	SurfaceSet *items = _game->getMod()->getSurfaceSet("BIGOBS.PCK");
+	std::vector<SurfaceSet*> units;
+	size_t frames = items->getTotalFrames();
+	for (const std::string &sheet : sheets)
+	{
+		SurfaceSet *set = _game->getMod()->getSurfaceSet(sheet, false);
+		if (set)
+		{
+			units.push_back(set);
+			frames += set->getTotalFrames();
+		}
+	}
+
+	// sprites get clipped on all sides now and then
+	Surface dest(320, 200);
+	auto hashDest = [&](uint64_t hash)
+	{
+		SurfaceRaw<const Uint8> raw(&dest);
+		for (int y = 0; y < raw.getHeight(); ++y)
+		{
+			const Uint8 *row = raw.getBuffer() + y * raw.getPitch();
+			for (int x = 0; x < raw.getWidth(); ++x)
+			{
+				hash ^= row[x];
+				hash *= 1099511628211ULL;
+			}
+		}
+		return hash;
+	};
+	auto position = [](size_t frame, int &x, int &y)
+	{
+		x = (int)(frame * 37 % 352) - 16;
+		y = (int)(frame * 23 % 232) - 16;
+	};
+
+	const ShaderKernels::Level supported = ShaderKernels::getSupportedLevel();
+	uint64_t times[ShaderKernels::LEVEL_MAX] = { };
+	uint64_t hashes[ShaderKernels::LEVEL_MAX] = { };
+	for (int level = ShaderKernels::LEVEL_SCALAR; level <= supported; ++level)
+	{
+		ShaderKernels::setLevel((ShaderKernels::Level)level);
+		uint64_t hash = 14695981039346656037ULL;
+		for (int repeat = 0; repeat < _repeat; ++repeat)
+		{
+			dest.clear();
+			uint64_t start = Profiler::now();
+			size_t frame = 0;
+			for (size_t i = 0; i < items->getTotalFrames(); ++i, ++frame)
+			{
+				Surface *sprite = items->getFrame(i);
+				if (!sprite)
+				{
+					continue;
+				}
+				int x, y;
+				position(frame, x, y);
+				for (int shade = 0; shade < 16; ++shade)
+				{
+					sprite->blitNShade(&dest, x, y, shade);
+					sprite->blitNShade(&dest, x + 8, y, shade, false, shade + 1);
+				}
+			}
+			for (SurfaceSet *set : units)
+			{
+				for (size_t i = 0; i < set->getTotalFrames(); ++i, ++frame)
+				{
+					Surface *sprite = set->getFrame(i);
+					if (!sprite)
+					{
+						continue;
+					}
+					int x, y;
+					position(frame, x, y);
+					ScriptWorkerBlit work;
+					for (int shade = 0; shade < 16; ++shade)
+					{
+						work.executeBlit(sprite, &dest, x, y, shade);
+					}
+				}
+			}
+			times[level] += Profiler::now() - start;
+			hash = hashDest(hash);
+		}
+		hashes[level] = hash;
+	}
+	ShaderKernels::setLevel(supported);
+
+	Log(LOG_INFO) << "Benchmark blit: " << frames << " frames from BIGOBS.PCK and " << units.size() << " unit sprite sheets, " << _repeat << " times";
+	bool same = true;
+	for (int level = ShaderKernels::LEVEL_SCALAR; level <= supported; ++level)
+	{
+		Log(LOG_INFO) << "Benchmark blit " << ShaderKernels::getLevelName((ShaderKernels::Level)level) << ": " << times[level] / 1000.0 << "ms";
+		if (hashes[level] != hashes[ShaderKernels::LEVEL_SCALAR])
+		{
+			Log(LOG_WARNING) << "Benchmark blit: " << ShaderKernels::getLevelName((ShaderKernels::Level)level) << " kernels draw different pixels than the scalar ones";
+			same = false;
+		}
+	}
+	return same;
+}
+
+/**
+ * Hashes the state of all units and the random generator,
+ * so two runs with the same seed can be checked for divergence.
+ * @return FNV-1a hash of the battle state.
+ */
+uint64_t BattlescapeBenchmark::getFingerprint() const
+{
+	uint64_t hash = 14695981039346656037ULL;
+	auto add = [&](int64_t value)
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 1099511628211ULL;
+		}
+	};
+	for (BattleUnit *unit : *getSave()->getUnits())
+	{
+		add(unit->getId());
+		add(unit->getPosition().x);
+		add(unit->getPosition().y);
+		add(unit->getPosition().z);
+		add(unit->getHealth());
+		add(unit->getStunlevel());
+		add(unit->getTimeUnits());
+		add(unit->getEnergy());
+		add(unit->getStatus());
+		add(unit->getFaction());
+	}
+	add(getSave()->getTurn());
+	add(RNG::getSeed());
+	return hash;
+}
+
+}
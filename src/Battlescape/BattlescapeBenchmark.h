@@ -0,0 +1,80 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <stdint.h>
+
+namespace OpenXcom
+{
+
+class Game;
+class BattlescapeState;
+class SavedBattleGame;
+
+/**
+ * Headless driver for the battlescape logic, started with "-benchmark".
+ * Loads a saved battle and plays it without drawing anything,
+ * logging the time spent per turn and in the engine subsystems.
+ * With a fixed seed two runs of the same build give the same fingerprint,
+ * so the timings of different builds can be compared.
+ */
+class BattlescapeBenchmark
+{
+private:
+	Game *_game;
+	std::string _name, _saveName;
+	int _turns, _repeat;
+	uint64_t _seed;
+	BattlescapeState *_state;
+	bool _finished, _validArgs;
+
+	/// Loads the save and sets up the battle.
+	bool loadBattle();
+	/// Dismisses any screens the battle pushed over the battlescape.
+	bool handlePushedStates();
+	/// Plays the current side until the turn passes to the next one.
+	bool playSide();
+	/// Plays the battle for the requested number of turns.
+	bool runBattle();
+	/// Compares the pathfinding searches with the reference ones.
+	bool runPathfinding();
+	/// Compares the incremental lighting with the full recalculation.
+	bool runLighting();
+	/// Compares the line tracing with the reference one.
+	bool runTracing();
+	/// Compares scanning the map through the tiles and the tile store.
+	bool runTiles();
+	/// Compares saving and loading in YAML and binary.
+	bool runSaving();
+	/// Compares the blit kernels on real sprites.
+	bool runBlitting();
+	/// Gets a hash of the battle state, to compare runs.
+	uint64_t getFingerprint() const;
+public:
+	/// Creates a benchmark from the command line options.
+	BattlescapeBenchmark(Game *game);
+	/// Cleans up the benchmark.
+	~BattlescapeBenchmark();
+	/// Runs the requested benchmark.
+	bool run();
+	/// Gets the battle being benchmarked.
+	SavedBattleGame *getSave() const;
+};
+
+}
@@ -51,6 +51,7 @@
 #include "../Mod/RuleSoldier.h"
 #include "../Mod/Armor.h"
 #include "../Engine/Options.h"
+#include "../Engine/Profiler.h"
 #include "../Engine/RNG.h"
 #include "InfoboxState.h"
 #include "InfoboxOKState.h"
@@ -178,7 +179,7 @@ bool BattleActionCost::spendTU(std::string *message)
 BattlescapeGame::BattlescapeGame(SavedBattleGame *save, BattlescapeState *parentState) :
 	_save(save), _parentState(parentState),
 	_playerPanicHandled(true), _AIActionCounter(0), _AISecondMove(false), _playedAggroSound(false),
-	_endTurnRequested(false), _endConfirmationHandled(false), _allEnemiesNeutralized(false)
+	_endTurnRequested(false), _endConfirmationHandled(false), _allEnemiesNeutralized(false), _onlyMovingChanged(false)
 {
 
 	_currentAction.actor = 0;
@@ -337,12 +338,15 @@ void BattlescapeGame::handleAI(BattleUnit *unit)
 	BattleAction action;
 	action.actor = unit;
 	action.number = _AIActionCounter;
-	unit->think(&action);
-
-	if (action.type == BA_RETHINK)
 	{
-		_parentState->debug("Rethink");
+		Profiler::Scope profile("AIModule::think", unit->getId());
 		unit->think(&action);
+
+		if (action.type == BA_RETHINK)
+		{
+			_parentState->debug("Rethink");
+			unit->think(&action);
+		}
 	}
 
 	_AIActionCounter = action.number;
@@ -1091,12 +1095,29 @@ void BattlescapeGame::handleState()
 		}
 		else
 		{
+			_onlyMovingChanged = false;
 			_states.front()->think();
 		}
-		getMap()->invalidate(); // redraw map
+		if (_onlyMovingChanged)
+		{
+			getMap()->invalidateMoving(); // redraw moving things only
+		}
+		else
+		{
+			getMap()->invalidate(); // redraw map
+		}
 	}
 }
 
+/**
+ * Tells that the think() of the current state only moved units, the
+ * projectile or the explosions, so the map can redraw just their areas.
+ */
+void BattlescapeGame::setOnlyMovingChanged()
+{
+	_onlyMovingChanged = true;
+}
+
 /**
  * Pushes a state to the front of the queue and starts it.
  * @param bs Battlestate.
@@ -2112,6 +2133,7 @@ BattleUnit *BattlescapeGame::convertUnit(BattleUnit *unit)
 	newUnit->setDirection(unit->getDirection());
 	newUnit->clearTimeUnits();
 	getSave()->getUnits()->push_back(newUnit);
+	getSave()->invalidateUnitGrid();
 	newUnit->setAIModule(new AIModule(getSave(), newUnit, 0));
 	newUnit->setVisible(visible);
 
@@ -2232,6 +2254,7 @@ void BattlescapeGame::spawnNewUnit(BattleActionAttack attack, Position position)
 		newUnit->setDirection(unitDirection);
 		newUnit->clearTimeUnits();
 		getSave()->getUnits()->push_back(newUnit);
+		getSave()->invalidateUnitGrid();
 		if (faction != FACTION_PLAYER)
 		{
 			newUnit->setAIModule(new AIModule(getSave(), newUnit, 0));
@@ -2307,6 +2330,7 @@ void BattlescapeGame::removeSummonedPlayerUnits()
 			(*unit)->setTile(nullptr, _save);
 			delete (*unit);
 			unit = _save->getUnits()->erase(unit);
+			_save->invalidateUnitGrid();
 		}
 	}
 
@@ -2327,6 +2351,7 @@ void BattlescapeGame::removeSummonedPlayerUnits()
 		newUnit->setAIModule(new AIModule(_save, newUnit, 0));
 		newUnit->markAsResummonedFakeCivilian();
 		_save->getUnits()->push_back(newUnit);
+		_save->invalidateUnitGrid();
 	}
 }
 
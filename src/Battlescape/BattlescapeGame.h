@@ -169,6 +169,7 @@ private:
 	bool _endTurnRequested;
 	bool _endConfirmationHandled;
 	bool _allEnemiesNeutralized;
+	bool _onlyMovingChanged;
 
 	SingleRun _endTurnProcessed;
 	SingleRun _triggerProcessed;
@@ -200,6 +201,8 @@ public:
 	bool playableUnitSelected() const;
 	/// Handles states timer.
 	void handleState();
+	/// Tells that the current state only moved units, projectiles or explosions.
+	void setOnlyMovingChanged();
 	/// Pushes a state to the front of the list.
 	void statePushFront(BattleState *bs);
 	/// Pushes a state to second on the list.
@@ -1255,6 +1255,7 @@ BattleUnit *BattlescapeGenerator::addXCOMUnit(BattleUnit *unit)
 		if (unit->hasInventory())
 		{
 			_save->getUnits()->push_back(unit);
+			_save->invalidateUnitGrid();
 			_save->initUnit(unit);
 			return unit;
 		}
@@ -1270,6 +1271,7 @@ BattleUnit *BattlescapeGenerator::addXCOMUnit(BattleUnit *unit)
 				_craftInventoryTile = _save->getTile(node->getPosition());
 				unit->setDirection(RNG::generate(0, 7));
 				_save->getUnits()->push_back(unit);
+				_save->invalidateUnitGrid();
 				_save->initUnit(unit);
 				return unit;
 			}
@@ -1280,6 +1282,7 @@ BattleUnit *BattlescapeGenerator::addXCOMUnit(BattleUnit *unit)
 					_craftInventoryTile = _save->getTile(unit->getPosition());
 					unit->setDirection(RNG::generate(0, 7));
 					_save->getUnits()->push_back(unit);
+					_save->invalidateUnitGrid();
 					_save->initUnit(unit);
 					return unit;
 				}
@@ -1315,6 +1318,7 @@ BattleUnit *BattlescapeGenerator::addXCOMUnit(BattleUnit *unit)
 					if (_save->setUnitPosition(unit, pos))
 					{
 						_save->getUnits()->push_back(unit);
+						_save->invalidateUnitGrid();
 						_save->initUnit(unit);
 						unit->setDirection(dir);
 						return unit;
@@ -1332,6 +1336,7 @@ BattleUnit *BattlescapeGenerator::addXCOMUnit(BattleUnit *unit)
 					{
 						_save->initUnit(unit);
 						_save->getUnits()->push_back(unit);
+						_save->invalidateUnitGrid();
 						return unit;
 					}
 				}
@@ -1525,6 +1530,7 @@ BattleUnit *BattlescapeGenerator::addAlien(Unit *rules, int alienRank, bool outs
 		// we only add a unit if it has a node to spawn on.
 		// (stops them spawning at 0,0,0)
 		_save->getUnits()->push_back(unit);
+		_save->invalidateUnitGrid();
 	}
 	else
 	{
@@ -1543,6 +1549,7 @@ BattleUnit *BattlescapeGenerator::addAlien(Unit *rules, int alienRank, bool outs
 				unit->setDirection(RNG::generate(0,7));
 
 			_save->getUnits()->push_back(unit);
+			_save->invalidateUnitGrid();
 		}
 		else
 		{
@@ -1573,12 +1580,14 @@ BattleUnit *BattlescapeGenerator::addCivilian(Unit *rules, int nodeRank)
 		// we only add a unit if it has a node to spawn on.
 		// (stops them spawning at 0,0,0)
 		_save->getUnits()->push_back(unit);
+		_save->invalidateUnitGrid();
 	}
 	else if (placeUnitNearFriend(unit))
 	{
 		unit->setAIModule(new AIModule(_save, unit, node));
 		unit->setDirection(RNG::generate(0,7));
 		_save->getUnits()->push_back(unit);
+		_save->invalidateUnitGrid();
 	}
 	else
 	{
@@ -2112,14 +2121,23 @@ void BattlescapeGenerator::explodePowerSources()
 			_save->getTileEngine()->explode({ }, pos, 180+RNG::generate(0,70), _save->getMod()->getDamageType(DT_HE), 10);
 		}
 	}
-	Tile *t = _save->getTileEngine()->checkForTerrainExplosions();
-	while (t)
+	// chained explosions go off in waves, the ones they set off wait for the next wave
+	std::vector<Tile*> wave;
+	_save->getTileEngine()->getTerrainExplosions(wave);
+	while (!wave.empty())
 	{
-		int power = t->getExplosive();
-		t->setExplosive(0, 0, true);
-		Position p = t->getPosition().toVoxel() + Position(8,8,0);
-		_save->getTileEngine()->explode({ }, p, power, _game->getMod()->getDamageType(DT_HE), power / 10);
-		t = _save->getTileEngine()->checkForTerrainExplosions();
+		for (Tile *t : wave)
+		{
+			int power = t->getExplosive();
+			if (power == 0)
+			{
+				continue;
+			}
+			t->setExplosive(0, 0, true);
+			Position p = t->getPosition().toVoxel() + Position(8,8,0);
+			_save->getTileEngine()->explode({ }, p, power, _game->getMod()->getDamageType(DT_HE), power / 10);
+		}
+		_save->getTileEngine()->getTerrainExplosions(wave);
 	}
 }
 
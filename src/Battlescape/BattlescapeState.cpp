@@ -823,6 +823,8 @@ void BattlescapeState::think()
 {
 	static bool popped = false;
 
+	SaveGameState::checkBackgroundSave(OPT_BATTLESCAPE, _palette);
+
 	if (_gameTimer->isRunning())
 	{
 		if (_popups.empty())
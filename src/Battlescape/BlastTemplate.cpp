@@ -0,0 +1,120 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BlastTemplate.h"
+#include <cmath>
+#include "../fmath.h"
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+/// Distance from a tile border below which a step is worked out from the real center.
+const double BORDER_MARGIN = 1e-6;
+
+/**
+ * Gets the tile offset of a ray coordinate, and checks if it's too
+ * close to a tile border to be the same for every center.
+ * @param distance Distance along the axis from the middle of the center tile.
+ * @param exact Set to true when the offset must be worked out from the center.
+ * @return Tile offset.
+ */
+int getOffset(double distance, bool &exact)
+{
+	double pos = 0.5 + distance;
+	double tile = floor(pos);
+	if (pos - tile < BORDER_MARGIN || tile + 1.0 - pos < BORDER_MARGIN)
+	{
+		exact = true;
+	}
+	return (int)tile;
+}
+
+}
+
+/**
+ * Creates the ray fan with the same angles and steps the explosions
+ * always used: every 5 degrees vertically and 3 horizontally.
+ * @param length Number of steps along each ray.
+ */
+BlastTemplate::BlastTemplate(int length) : _length(std::max(length, 0))
+{
+	for (int fi = -90; fi <= 90; fi += STEP_FI)
+	{
+		for (int te = 0; te <= 360; te += STEP_TE)
+		{
+			Ray ray;
+			ray.te = te;
+			ray.cosTe = cos(Deg2Rad(te));
+			ray.sinTe = sin(Deg2Rad(te));
+			ray.sinFi = sin(Deg2Rad(fi));
+			ray.cosFi = cos(Deg2Rad(fi));
+			_rays.push_back(ray);
+		}
+	}
+
+	_offsets.resize(_rays.size() * _length * 3);
+	_exact.resize(_rays.size() * _length);
+	for (size_t i = 0; i < _rays.size(); ++i)
+	{
+		const Ray &ray = _rays[i];
+		for (int l = 1; l <= _length; ++l)
+		{
+			size_t step = i * _length + l - 1;
+			bool exact = false;
+			_offsets[step * 3 + 0] = getOffset(l * ray.sinTe * ray.cosFi, exact);
+			_offsets[step * 3 + 1] = getOffset(l * ray.cosTe * ray.cosFi, exact);
+			_offsets[step * 3 + 2] = getOffset(l * ray.sinFi, exact);
+			_exact[step] = exact;
+		}
+	}
+}
+
+/**
+ * Cleans up the ray fan.
+ */
+BlastTemplate::~BlastTemplate()
+{
+
+}
+
+/**
+ * Gets the tile a ray reaches after some steps.
+ * @param ray Index of the ray.
+ * @param step Number of steps, from 1 to the length.
+ * @param center Tile at the center of the explosion.
+ * @return Position of the tile, can be outside the map.
+ */
+Position BlastTemplate::getStep(size_t ray, int step, Position center) const
+{
+	size_t i = ray * _length + step - 1;
+	if (_exact[i])
+	{
+		const Ray &r = _rays[ray];
+		double l = step;
+		return Position(
+			int(floor(center.x + 0.5 + l * r.sinTe * r.cosFi)),
+			int(floor(center.y + 0.5 + l * r.cosTe * r.cosFi)),
+			int(floor(center.z + 0.5 + l * r.sinFi)));
+	}
+	return center + Position(_offsets[i * 3 + 0], _offsets[i * 3 + 1], _offsets[i * 3 + 2]);
+}
+
+}
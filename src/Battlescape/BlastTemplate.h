@@ -0,0 +1,66 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vector>
+#include <SDL_types.h>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Geometry of the ray fan of an explosion, the tiles each ray goes
+ * through relative to the center, up to a given length. It's the same
+ * for all explosions, so it's made once and only walked afterwards.
+ * The few steps that fall right on a tile border are worked out again
+ * from the real center, so rounding gives the same tiles as before.
+ */
+class BlastTemplate
+{
+public:
+	/// Angle between the vertical rays, in degrees.
+	static const int STEP_FI = 5;
+	/// Angle between the horizontal rays, in degrees.
+	static const int STEP_TE = 3;
+private:
+	struct Ray
+	{
+		int te;
+		double sinTe, cosTe, sinFi, cosFi;
+	};
+	int _length;
+	std::vector<Ray> _rays;
+	std::vector<Sint16> _offsets;
+	std::vector<Uint8> _exact;
+public:
+	/// Creates the ray fan up to a length.
+	BlastTemplate(int length);
+	/// Cleans up the ray fan.
+	~BlastTemplate();
+	/// Gets the length of the rays, in tiles.
+	int getLength() const { return _length; }
+	/// Gets the number of rays.
+	size_t getRayCount() const { return _rays.size(); }
+	/// Gets the horizontal angle of a ray, in degrees.
+	int getAngle(size_t ray) const { return _rays[ray].te; }
+	/// Gets the tile a ray reaches after some steps.
+	Position getStep(size_t ray, int step, Position center) const;
+};
+
+}
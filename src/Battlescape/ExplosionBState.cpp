@@ -365,8 +365,12 @@ void ExplosionBState::think()
 {
 	if (!_parent->getMap()->getBlastFlash())
 	{
+		bool exploded = false;
 		if (_parent->getMap()->getExplosions()->empty())
+		{
 			explode();
+			exploded = true;
+		}
 
 		for (std::list<Explosion*>::iterator i = _parent->getMap()->getExplosions()->begin(); i != _parent->getMap()->getExplosions()->end();)
 		{
@@ -385,6 +389,11 @@ void ExplosionBState::think()
 				++i;
 			}
 		}
+		if (!exploded)
+		{
+			// only the animations moved on
+			_parent->setOnlyMovingChanged();
+		}
 	}
 }
 
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Map.h"
+#include <cstring>
 #include "Camera.h"
 #include "UnitSprite.h"
 #include "ItemSprite.h"
@@ -32,6 +33,7 @@
 #include "../Engine/Timer.h"
 #include "../Engine/Language.h"
 #include "../Engine/Palette.h"
+#include "../Engine/Profiler.h"
 #include "../Engine/Game.h"
 #include "../Engine/Screen.h"
 #include "../Engine/ShaderDraw.h"
@@ -98,7 +100,7 @@ Map::Map(Game *game, int width, int height, int x, int y, int visibleMapHeight)
 	_game(game), _arrow(0), _anyIndicator(false), _isAltPressed(false),
 	_selectorX(0), _selectorY(0), _mouseX(0), _mouseY(0), _cursorType(CT_NORMAL), _cursorSize(1), _animFrame(0),
 	_projectile(0), _followProjectile(true), _projectileInFOV(false), _explosionInFOV(false), _launch(false), _visibleMapHeight(visibleMapHeight),
-	_unitDying(false), _smoothingEngaged(false), _flashScreen(false), _bgColor(15), _projectileSet(0), _showObstacles(false)
+	_unitDying(false), _smoothingEngaged(false), _flashScreen(false), _bgColor(15), _projectileSet(0), _redrawMoving(false), _showObstacles(false)
 {
 	_iconHeight = _game->getMod()->getInterface("battlescape")->getElement("icons")->h;
 	_iconWidth = _game->getMod()->getInterface("battlescape")->getElement("icons")->w;
@@ -238,29 +240,16 @@ void Map::think()
 }
 
 /**
- * Draws the whole map, part by part.
+ * Draws the whole map, part by part. When only some areas were marked
+ * as dirty and the view didn't change, only those areas get redrawn.
  */
 void Map::draw()
 {
-	if (!_redraw)
+	if (!_redraw && _dirtyAreas.empty() && !_redrawMoving)
 	{
 		return;
 	}
 
-	// normally we'd call for a Surface::draw();
-	// but we don't want to clear the background with colour 0, which is transparent (aka black)
-	// we use colour 15 because that actually corresponds to the colour we DO want in all variations of the xcom and tftd palettes.
-	// Note: un-hardcoded the color from 15 to ruleset value, default 15
-	_redraw = false;
-	ShaderDrawFunc(
-		[](Uint8& dest, Uint8 color)
-		{
-			dest = color;
-		},
-		ShaderSurface(this),
-		ShaderScalar<Uint8>(Palette::blockOffset(0) + _bgColor)
-	);
-
 	Tile *t;
 
 	_projectileInFOV = _save->getDebugMode();
@@ -286,7 +275,45 @@ void Map::draw()
 		}
 	}
 
-	if ((_save->getSelectedUnit() && _save->getSelectedUnit()->getVisible()) || _unitDying || _save->getSide() == FACTION_PLAYER || _save->getDebugMode() || _projectileInFOV || _explosionInFOV)
+	bool terrainVisible = (_save->getSelectedUnit() && _save->getSelectedUnit()->getVisible()) || _unitDying || _save->getSide() == FACTION_PLAYER || _save->getDebugMode() || _projectileInFOV || _explosionInFOV;
+	if (terrainVisible)
+	{
+		followProjectile();
+	}
+
+	MapViewState view = getViewState(terrainVisible);
+	std::vector<SDL_Rect> moving;
+	getMovingAreas(moving);
+	if (_redrawMoving)
+	{
+		_dirtyAreas.insert(_dirtyAreas.end(), _movingAreas.begin(), _movingAreas.end());
+		_dirtyAreas.insert(_dirtyAreas.end(), moving.begin(), moving.end());
+	}
+	_movingAreas.swap(moving);
+	_redrawMoving = false;
+
+	if (!_redraw && Options::oxcePartialMapRedraw && terrainVisible && view == _drawnView && drawAreas())
+	{
+		return;
+	}
+
+	// normally we'd call for a Surface::draw();
+	// but we don't want to clear the background with colour 0, which is transparent (aka black)
+	// we use colour 15 because that actually corresponds to the colour we DO want in all variations of the xcom and tftd palettes.
+	// Note: un-hardcoded the color from 15 to ruleset value, default 15
+	_redraw = false;
+	_dirtyAreas.clear();
+	_drawnView = view;
+	ShaderDrawFunc(
+		[](Uint8& dest, Uint8 color)
+		{
+			dest = color;
+		},
+		ShaderSurface(this),
+		ShaderScalar<Uint8>(Palette::blockOffset(0) + _bgColor)
+	);
+
+	if (terrainVisible)
 	{
 		drawTerrain(this);
 	}
@@ -294,6 +321,307 @@ void Map::draw()
 	{
 		_message->blit(this->getSurface());
 	}
+
+	if (Options::oxceMapRedrawOverlay)
+	{
+		SDL_Rect all = { 0, 0, (Uint16)getWidth(), (Uint16)getHeight() };
+		drawRedrawOverlay(std::vector<SDL_Rect>(1, all), getWidth() * getHeight());
+	}
+}
+
+/**
+ * Redraws the dirty areas of the map. Each area is drawn on its own small
+ * surface with the camera moved to match, so everything gets clipped to it,
+ * then copied over the map.
+ * @return False if the areas are too big and the whole map should be redrawn instead.
+ */
+bool Map::drawAreas()
+{
+	std::vector<SDL_Rect> areas;
+	for (SDL_Rect rect : _dirtyAreas)
+	{
+		// clip to the map
+		int x1 = std::max<int>(rect.x, 0), y1 = std::max<int>(rect.y, 0);
+		int x2 = std::min<int>(rect.x + rect.w, getWidth()), y2 = std::min<int>(rect.y + rect.h, getHeight());
+		if (x1 >= x2 || y1 >= y2)
+		{
+			continue;
+		}
+		rect.x = x1;
+		rect.y = y1;
+		rect.w = x2 - x1;
+		rect.h = y2 - y1;
+
+		// merge with any overlapping area, which can in turn overlap others
+		for (size_t i = 0; i < areas.size();)
+		{
+			const SDL_Rect &other = areas[i];
+			if (rect.x < other.x + other.w && other.x < rect.x + rect.w && rect.y < other.y + other.h && other.y < rect.y + rect.h)
+			{
+				x1 = std::min<int>(rect.x, other.x);
+				y1 = std::min<int>(rect.y, other.y);
+				x2 = std::max<int>(rect.x + rect.w, other.x + other.w);
+				y2 = std::max<int>(rect.y + rect.h, other.y + other.h);
+				rect.x = x1;
+				rect.y = y1;
+				rect.w = x2 - x1;
+				rect.h = y2 - y1;
+				areas.erase(areas.begin() + i);
+				i = 0;
+			}
+			else
+			{
+				++i;
+			}
+		}
+		areas.push_back(rect);
+	}
+
+	int pixels = 0;
+	for (auto &rect : areas)
+	{
+		pixels += rect.w * rect.h;
+	}
+	if (pixels * 2 > getWidth() * getHeight())
+	{
+		return false;
+	}
+	_dirtyAreas.clear();
+	Profiler::count("Map::drawAreas redraws");
+	Profiler::count("Map::drawAreas pixels", pixels);
+
+	const Position offset = _camera->getMapOffset();
+	for (auto &rect : areas)
+	{
+		Surface area(rect.w, rect.h);
+		area.setPalette(getPalette());
+		ShaderDrawFunc(
+			[](Uint8& dest, Uint8 color)
+			{
+				dest = color;
+			},
+			ShaderSurface(&area),
+			ShaderScalar<Uint8>(Palette::blockOffset(0) + _bgColor)
+		);
+		_camera->setMapOffset(Position(offset.x - rect.x, offset.y - rect.y, offset.z));
+		drawTerrain(&area);
+		_camera->setMapOffset(offset);
+
+		lock();
+		for (int y = 0; y < rect.h; ++y)
+		{
+			memcpy(getRaw(rect.x, rect.y + y), area.getRaw(0, y), rect.w);
+		}
+		unlock();
+	}
+
+	if (Options::oxceMapRedrawOverlay)
+	{
+		drawRedrawOverlay(areas, pixels);
+	}
+	return true;
+}
+
+/**
+ * Outlines the areas redrawn in this frame and shows how much
+ * of the map they cover, in percent.
+ * @param areas Redrawn areas.
+ * @param pixels Number of pixels redrawn.
+ */
+void Map::drawRedrawOverlay(const std::vector<SDL_Rect> &areas, int pixels)
+{
+	const Uint8 color = Palette::blockOffset(1) + 1;
+	for (auto &rect : areas)
+	{
+		drawRect(rect.x, rect.y, rect.w, 1, color);
+		drawRect(rect.x, rect.y + rect.h - 1, rect.w, 1, color);
+		drawRect(rect.x, rect.y, 1, rect.h, color);
+		drawRect(rect.x + rect.w - 1, rect.y, 1, rect.h, color);
+	}
+	NumberText text(20, 5, 0, 0);
+	text.setPalette(getPalette());
+	text.setBordered(true);
+	text.setColor(color);
+	text.setValue(pixels * 100 / std::max(getWidth() * getHeight(), 1));
+	text.draw();
+	text.blitNShade(this, 2, 2, 0);
+}
+
+/**
+ * Draws the dirty areas of the map before it's blitted,
+ * as they aren't covered by the regular redraw flag.
+ * @param surface Pointer to surface to blit onto.
+ */
+void Map::blit(SDL_Surface *surface)
+{
+	if (!_redraw && (!_dirtyAreas.empty() || _redrawMoving))
+	{
+		draw();
+	}
+	InteractiveSurface::blit(surface);
+}
+
+/**
+ * Marks an area of the map for redraw, without redrawing the rest.
+ * @param area Area in map surface coordinates.
+ */
+void Map::invalidateArea(const SDL_Rect &area)
+{
+	_dirtyAreas.push_back(area);
+}
+
+/**
+ * Marks the screen area of a square of tiles for redraw,
+ * including anything standing on them or drawn over them.
+ * @param pos Position of the first tile.
+ * @param size Number of tiles on each side of the square.
+ */
+void Map::invalidateTiles(Position pos, int size)
+{
+	Position first, last;
+	_camera->convertMapToScreen(pos, &first);
+	_camera->convertMapToScreen(pos + Position(size - 1, size - 1, 0), &last);
+	first += _camera->getMapOffset();
+	last += _camera->getMapOffset();
+	SDL_Rect area;
+	area.x = first.x - (size - 1) * _spriteWidth / 2 - _spriteWidth / 2;
+	area.y = first.y - _spriteHeight;
+	area.w = (size + 1) * _spriteWidth;
+	area.h = last.y - first.y + 2 * _spriteHeight;
+	invalidateArea(area);
+}
+
+/**
+ * Marks the last and the current areas of the moving units, projectile
+ * and explosions for redraw. Used when only they have changed.
+ */
+void Map::invalidateMoving()
+{
+	_redrawMoving = true;
+}
+
+/**
+ * Compares two view states of the map.
+ * @param other The other state.
+ * @return True if they are the same.
+ */
+bool MapViewState::operator==(const MapViewState &other) const
+{
+	return mapOffset == other.mapOffset && animFrame == other.animFrame &&
+		fadeShade == other.fadeShade && nvColor == other.nvColor && debugVisionMode == other.debugVisionMode &&
+		cursorType == other.cursorType && cursorSize == other.cursorSize &&
+		selectedUnit == other.selectedUnit && waypoints == other.waypoints && side == other.side &&
+		terrainVisible == other.terrainVisible && showAllLayers == other.showAllLayers &&
+		altPressed == other.altPressed && mouseOverIcons == other.mouseOverIcons &&
+		pathPreviewed == other.pathPreviewed && showObstacles == other.showObstacles && debugMode == other.debugMode;
+}
+
+/**
+ * Gets everything that changes the whole map view at once.
+ * @param terrainVisible Is the terrain shown, instead of the hidden movement screen?
+ * @return The current view state.
+ */
+MapViewState Map::getViewState(bool terrainVisible) const
+{
+	MapViewState view;
+	view.mapOffset = _camera->getMapOffset();
+	view.animFrame = _animFrame;
+	view.fadeShade = _fadeShade;
+	view.nvColor = _nvColor;
+	view.debugVisionMode = _debugVisionMode;
+	view.cursorType = _cursorType;
+	view.cursorSize = _cursorSize;
+	view.selectedUnit = _save->getSelectedUnit();
+	view.waypoints = _waypoints.size();
+	view.side = _save->getSide();
+	view.terrainVisible = terrainVisible;
+	view.showAllLayers = _camera->getShowAllLayers();
+	view.altPressed = _game->isAltPressed(true);
+	view.mouseOverIcons = _save->getBattleState()->getMouseOverIcons();
+	view.pathPreviewed = _save->getPathfinding()->isPathPreviewed();
+	view.showObstacles = _showObstacles;
+	view.debugMode = _save->getDebugMode();
+	return view;
+}
+
+/**
+ * Gets the screen areas covered by everything in motion: walking
+ * and flying units, the projectile with its trail and shadow, and
+ * the explosions.
+ * @param areas Gets the areas added.
+ */
+void Map::getMovingAreas(std::vector<SDL_Rect> &areas) const
+{
+	Position screen;
+	for (auto *unit : *_save->getUnits())
+	{
+		if ((unit->getStatus() != STATUS_WALKING && unit->getStatus() != STATUS_FLYING) || unit->getPosition() == TileEngine::invalid)
+		{
+			continue;
+		}
+		int size = unit->getArmor()->getSize();
+		_camera->convertMapToScreen(unit->getPosition(), &screen);
+		screen += _camera->getMapOffset() + calculateWalkingOffset(unit).ScreenOffset;
+		SDL_Rect area;
+		area.x = screen.x - size * _spriteWidth / 2;
+		area.y = screen.y - _spriteHeight;
+		area.w = (size + 1) * _spriteWidth;
+		area.h = (size + 2) * _spriteHeight;
+		areas.push_back(area);
+	}
+
+	if (_projectile)
+	{
+		// covers both bullets and thrown items, with their shadows
+		int part = _projectile->getItem() ? 1 : BULLET_SPRITES - 1;
+		for (int i = 0; i <= part; ++i)
+		{
+			Position voxel = _projectile->getPosition(1 - i);
+			for (int shadow = 0; shadow < 2; ++shadow)
+			{
+				if (shadow)
+				{
+					voxel.z = _save->getTileEngine()->castedShade(voxel);
+				}
+				_camera->convertVoxelToScreen(voxel, &screen);
+				SDL_Rect area;
+				area.x = screen.x - _spriteWidth / 2 - 2;
+				area.y = screen.y - _spriteHeight / 2 - 8;
+				area.w = _spriteWidth + 4;
+				area.h = _spriteHeight + 8;
+				areas.push_back(area);
+			}
+		}
+	}
+
+	for (auto *explosion : _explosions)
+	{
+		if (explosion->getCurrentFrame() < 0)
+		{
+			continue;
+		}
+		SurfaceSet *set = _game->getMod()->getSurfaceSet(explosion->isBig() ? "X1.PCK" : explosion->isHit() ? "HIT.PCK" : "SMOKE.PCK");
+		SurfaceRaw<const Uint8> sprite = set->getFrame(explosion->getCurrentFrame());
+		if (!sprite)
+		{
+			continue;
+		}
+		_camera->convertVoxelToScreen(explosion->getPosition(), &screen);
+		SDL_Rect area;
+		area.w = sprite.getWidth();
+		area.h = sprite.getHeight();
+		if (explosion->isBig())
+		{
+			area.x = screen.x - area.w / 2;
+			area.y = screen.y - area.h / 2;
+		}
+		else
+		{
+			area.x = screen.x - 15;
+			area.y = screen.y - (explosion->isHit() ? 25 : 15);
+		}
+		areas.push_back(area);
+	}
 }
 
 /**
@@ -638,6 +966,127 @@ void Map::drawUnit(UnitSprite &unitSprite, Tile *unitTile, Tile *currTile, Posit
 	unitSprite.draw(bu, part, tileScreenPosition.x + offsets.ScreenOffset.x, tileScreenPosition.y + offsets.ScreenOffset.y, shade, mask, _isAltPressed);
 }
 
+/**
+ * Gets the range of tiles covered by the projectile and its trail.
+ * @param low Gets the lowest tile coordinates.
+ * @param high Gets the highest tile coordinates.
+ */
+void Map::getProjectileTiles(Position &low, Position &high) const
+{
+	int bulletLowX=16000, bulletLowY=16000, bulletLowZ=16000, bulletHighX=0, bulletHighY=0, bulletHighZ=0;
+	int part = _projectile->getItem() ? 0 : BULLET_SPRITES-1;
+	for (int i = 0; i <= part; ++i)
+	{
+		if (_projectile->getPosition(1-i).x < bulletLowX)
+			bulletLowX = _projectile->getPosition(1-i).x;
+		if (_projectile->getPosition(1-i).y < bulletLowY)
+			bulletLowY = _projectile->getPosition(1-i).y;
+		if (_projectile->getPosition(1-i).z < bulletLowZ)
+			bulletLowZ = _projectile->getPosition(1-i).z;
+		if (_projectile->getPosition(1-i).x > bulletHighX)
+			bulletHighX = _projectile->getPosition(1-i).x;
+		if (_projectile->getPosition(1-i).y > bulletHighY)
+			bulletHighY = _projectile->getPosition(1-i).y;
+		if (_projectile->getPosition(1-i).z > bulletHighZ)
+			bulletHighZ = _projectile->getPosition(1-i).z;
+	}
+	// divide by 16 to go from voxel to tile position
+	bulletLowX = bulletLowX / 16;
+	bulletLowY = bulletLowY / 16;
+	bulletLowZ = bulletLowZ / 24;
+	bulletHighX = bulletHighX / 16;
+	bulletHighY = bulletHighY / 16;
+	bulletHighZ = bulletHighZ / 24;
+	low = Position(bulletLowX, bulletLowY, bulletLowZ);
+	high = Position(bulletHighX, bulletHighY, bulletHighZ);
+}
+
+/**
+ * Keeps the camera on the projectile while it's being followed,
+ * centering it back when the projectile leaves the screen.
+ */
+void Map::followProjectile()
+{
+	if (!_projectile || !_explosions.empty())
+	{
+		return;
+	}
+	Position bulletLow, bulletHigh, bulletPositionScreen;
+	getProjectileTiles(bulletLow, bulletHigh);
+
+	// if the projectile is outside the viewport - center it back on it
+	_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
+
+	if (_projectileInFOV && _followProjectile)
+	{
+		Position newCam = _camera->getMapOffset();
+		if (newCam.z != bulletHigh.z) //switch level
+		{
+			newCam.z = bulletHigh.z;
+			if (_projectileInFOV)
+			{
+				_camera->setMapOffset(newCam);
+				_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
+			}
+		}
+		if (_smoothCamera)
+		{
+			if (_launch)
+			{
+				_launch = false;
+				if ((bulletPositionScreen.x < 1 || bulletPositionScreen.x > getWidth() - 1 ||
+					bulletPositionScreen.y < 1 || bulletPositionScreen.y > _visibleMapHeight - 1))
+				{
+					_camera->centerOnPosition(Position(bulletLow.x, bulletLow.y, bulletHigh.z), false);
+					_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
+				}
+			}
+			if (!_smoothingEngaged)
+			{
+				if (bulletPositionScreen.x < 1 || bulletPositionScreen.x > getWidth() - 1 ||
+					bulletPositionScreen.y < 1 || bulletPositionScreen.y > _visibleMapHeight - 1)
+				{
+					_smoothingEngaged = true;
+				}
+			}
+			else
+			{
+				_camera->jumpXY(getWidth() / 2 - bulletPositionScreen.x, _visibleMapHeight / 2 - bulletPositionScreen.y);
+			}
+		}
+		else
+		{
+			bool enough;
+			do
+			{
+				enough = true;
+				if (bulletPositionScreen.x < 0)
+				{
+					_camera->jumpXY(+getWidth(), 0);
+					enough = false;
+				}
+				else if (bulletPositionScreen.x > getWidth())
+				{
+					_camera->jumpXY(-getWidth(), 0);
+					enough = false;
+				}
+				else if (bulletPositionScreen.y < 0)
+				{
+					_camera->jumpXY(0, +_visibleMapHeight);
+					enough = false;
+				}
+				else if (bulletPositionScreen.y > _visibleMapHeight)
+				{
+					_camera->jumpXY(0, -_visibleMapHeight);
+					enough = false;
+				}
+				_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
+			}
+			while (!enough);
+		}
+	}
+}
+
 /**
  * Draw the terrain.
  * Keep this function as optimised as possible. It's big to minimise overhead of function calls.
@@ -653,7 +1102,7 @@ void Map::drawTerrain(Surface *surface)
 	int beginY = 0, endY = _save->getMapSizeY() - 1;
 	int beginZ = 0, endZ = _save->getMapSizeZ() - 1;
 	Position mapPosition, screenPosition, bulletPositionScreen, movingUnitPosition;
-	int bulletLowX=16000, bulletLowY=16000, bulletLowZ=16000, bulletHighX=0, bulletHighY=0, bulletHighZ=0;
+	int bulletLowX=16000, bulletLowY=16000, bulletHighX=0, bulletHighY=0;
 	int dummy;
 	BattleUnit *movingUnit = _save->getTileEngine()->getMovingUnit();
 	int tileShade, tileColor, obstacleShade;
@@ -668,101 +1117,12 @@ void Map::drawTerrain(Surface *surface)
 	// if we got bullet, get the highest x and y tiles to draw it on
 	if (_projectile && _explosions.empty())
 	{
-		int part = _projectile->getItem() ? 0 : BULLET_SPRITES-1;
-		for (int i = 0; i <= part; ++i)
-		{
-			if (_projectile->getPosition(1-i).x < bulletLowX)
-				bulletLowX = _projectile->getPosition(1-i).x;
-			if (_projectile->getPosition(1-i).y < bulletLowY)
-				bulletLowY = _projectile->getPosition(1-i).y;
-			if (_projectile->getPosition(1-i).z < bulletLowZ)
-				bulletLowZ = _projectile->getPosition(1-i).z;
-			if (_projectile->getPosition(1-i).x > bulletHighX)
-				bulletHighX = _projectile->getPosition(1-i).x;
-			if (_projectile->getPosition(1-i).y > bulletHighY)
-				bulletHighY = _projectile->getPosition(1-i).y;
-			if (_projectile->getPosition(1-i).z > bulletHighZ)
-				bulletHighZ = _projectile->getPosition(1-i).z;
-		}
-		// divide by 16 to go from voxel to tile position
-		bulletLowX = bulletLowX / 16;
-		bulletLowY = bulletLowY / 16;
-		bulletLowZ = bulletLowZ / 24;
-		bulletHighX = bulletHighX / 16;
-		bulletHighY = bulletHighY / 16;
-		bulletHighZ = bulletHighZ / 24;
-
-		// if the projectile is outside the viewport - center it back on it
-		_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
-
-		if (_projectileInFOV && _followProjectile)
-		{
-			Position newCam = _camera->getMapOffset();
-			if (newCam.z != bulletHighZ) //switch level
-			{
-				newCam.z = bulletHighZ;
-				if (_projectileInFOV)
-				{
-					_camera->setMapOffset(newCam);
-					_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
-				}
-			}
-			if (_smoothCamera)
-			{
-				if (_launch)
-				{
-					_launch = false;
-					if ((bulletPositionScreen.x < 1 || bulletPositionScreen.x > surface->getWidth() - 1 ||
-						bulletPositionScreen.y < 1 || bulletPositionScreen.y > _visibleMapHeight - 1))
-					{
-						_camera->centerOnPosition(Position(bulletLowX, bulletLowY, bulletHighZ), false);
-						_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
-					}
-				}
-				if (!_smoothingEngaged)
-				{
-					if (bulletPositionScreen.x < 1 || bulletPositionScreen.x > surface->getWidth() - 1 ||
-						bulletPositionScreen.y < 1 || bulletPositionScreen.y > _visibleMapHeight - 1)
-					{
-						_smoothingEngaged = true;
-					}
-				}
-				else
-				{
-					_camera->jumpXY(surface->getWidth() / 2 - bulletPositionScreen.x, _visibleMapHeight / 2 - bulletPositionScreen.y);
-				}
-			}
-			else
-			{
-				bool enough;
-				do
-				{
-					enough = true;
-					if (bulletPositionScreen.x < 0)
-					{
-						_camera->jumpXY(+surface->getWidth(), 0);
-						enough = false;
-					}
-					else if (bulletPositionScreen.x > surface->getWidth())
-					{
-						_camera->jumpXY(-surface->getWidth(), 0);
-						enough = false;
-					}
-					else if (bulletPositionScreen.y < 0)
-					{
-						_camera->jumpXY(0, +_visibleMapHeight);
-						enough = false;
-					}
-					else if (bulletPositionScreen.y > _visibleMapHeight)
-					{
-						_camera->jumpXY(0, -_visibleMapHeight);
-						enough = false;
-					}
-					_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
-				}
-				while (!enough);
-			}
-		}
+		Position bulletLow, bulletHigh;
+		getProjectileTiles(bulletLow, bulletHigh);
+		bulletLowX = bulletLow.x;
+		bulletLowY = bulletLow.y;
+		bulletHighX = bulletHigh.x;
+		bulletHighY = bulletHigh.y;
 	}
 
 	// get corner map coordinates to give rough boundaries in which tiles to redraw are
@@ -1754,7 +2114,10 @@ void Map::setSelectorPosition(int mx, int my)
 
 	if (oldX != _selectorX || oldY != _selectorY)
 	{
-		_redraw = true;
+		// only the cursor moved, redraw where it was and where it is now
+		int z = _camera->getViewLevel();
+		invalidateTiles(Position(oldX - _cursorSize + 1, oldY - _cursorSize + 1, z), _cursorSize);
+		invalidateTiles(Position(_selectorX - _cursorSize + 1, _selectorY - _cursorSize + 1, z), _cursorSize);
 	}
 }
 
@@ -54,6 +54,27 @@ struct UnitWalkingOffset
 	int TerrainLevelOffset;
 };
 
+/**
+ * Everything that changes the whole map view at once.
+ * The map is only partially redrawn while all of it stays the same.
+ */
+struct MapViewState
+{
+	Position mapOffset;
+	int animFrame = -1;
+	int fadeShade = 0, nvColor = 0, debugVisionMode = 0;
+	CursorType cursorType = CT_NONE;
+	int cursorSize = 0;
+	const BattleUnit *selectedUnit = nullptr;
+	size_t waypoints = 0;
+	int side = 0;
+	bool terrainVisible = false, showAllLayers = false, altPressed = false, mouseOverIcons = false;
+	bool pathPreviewed = false, showObstacles = false, debugMode = false;
+
+	/// Compares two view states.
+	bool operator==(const MapViewState &other) const;
+};
+
 /**
  * Interactive map of the battlescape.
  */
@@ -101,9 +122,18 @@ private:
 	PathPreview _previewSetting;
 	Text *_txtAccuracy;
 	SurfaceSet *_projectileSet;
+	std::vector<SDL_Rect> _dirtyAreas, _movingAreas;
+	bool _redrawMoving;
+	MapViewState _drawnView;
 
 	void drawUnit(UnitSprite &unitSprite, Tile *unitTile, Tile *currTile, Position tileScreenPosition, bool topLayer, BattleUnit* movingUnit = nullptr);
 	void drawTerrain(Surface *surface);
+	void followProjectile();
+	void getProjectileTiles(Position &low, Position &high) const;
+	MapViewState getViewState(bool terrainVisible) const;
+	void getMovingAreas(std::vector<SDL_Rect> &areas) const;
+	bool drawAreas();
+	void drawRedrawOverlay(const std::vector<SDL_Rect> &areas, int pixels);
 	int getTerrainLevel(const Position& pos, int size) const;
 	int getWallShade(TilePart part, Tile* tileFrot);
 	int _iconHeight, _iconWidth, _messageColor;
@@ -120,6 +150,14 @@ public:
 	void think() override;
 	/// Draws the surface.
 	void draw() override;
+	/// Blits the surface, redrawing the dirty areas first.
+	void blit(SDL_Surface *surface) override;
+	/// Marks an area of the map for redraw.
+	void invalidateArea(const SDL_Rect &area);
+	/// Marks the area of some tiles for redraw.
+	void invalidateTiles(Position pos, int size = 1);
+	/// Marks the moving units, projectile and explosions for redraw.
+	void invalidateMoving();
 	/// Sets the palette.
 	void setPalette(const SDL_Color *colors, int firstcolor = 0, int ncolors = 256) override;
 	/// Special handling for mouse press.
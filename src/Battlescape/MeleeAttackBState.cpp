@@ -22,6 +22,7 @@
 #include "BattlescapeState.h"
 #include "TileEngine.h"
 #include "Map.h"
+#include "Pathfinding.h"
 #include "Camera.h"
 #include "AIModule.h"
 #include "../Savegame/Tile.h"
@@ -901,6 +901,7 @@ BattleUnit* NextTurnState::addReinforcement(const ReinforcementsData &wave, Unit
 				unit->setRankInt(alienRank);
 				unit->setDirection(RNG::generate(0, 7));
 				_battleGame->getUnits()->push_back(unit);
+				_battleGame->invalidateUnitGrid();
 				unitPlaced = true;
 				break;
 			}
@@ -990,6 +991,7 @@ BattleUnit* NextTurnState::addReinforcement(const ReinforcementsData &wave, Unit
 						unit->setRankInt(alienRank);
 						unit->setDirection(RNG::generate(0, 7));
 						_battleGame->getUnits()->push_back(unit);
+						_battleGame->invalidateUnitGrid();
 						unitPlaced = true;
 						break;
 					}
@@ -1006,6 +1008,7 @@ BattleUnit* NextTurnState::addReinforcement(const ReinforcementsData &wave, Unit
 		unit->setRankInt(alienRank);
 		unit->setDirection(RNG::generate(0, 7));
 		_battleGame->getUnits()->push_back(unit);
+		_battleGame->invalidateUnitGrid();
 		unitPlaced = true;
 	}
 
@@ -25,6 +25,7 @@
 #include "../Mod/Armor.h"
 #include "../Savegame/BattleUnit.h"
 #include "../Engine/Options.h"
+#include "../Engine/Profiler.h"
 #include "BattlescapeGame.h"
 #include "TileEngine.h"
 
@@ -43,7 +44,7 @@ int Pathfinding::green = 4;
  * Sets up a Pathfinding.
  * @param save pointer to SavedBattleGame object.
  */
-Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _unit(0), _pathPreviewed(false), _strafeMove(false), _totalTUCost(0), _modifierUsed(false), _movementType(MT_WALK)
+Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _generation(0), _referenceSearch(false), _reachableVersion(0), _unit(0), _pathPreviewed(false), _strafeMove(false), _totalTUCost(0), _modifierUsed(false), _movementType(MT_WALK)
 {
 	_size = _save->getMapSizeXYZ();
 	// Initialize one node per tile
@@ -70,7 +71,27 @@ Pathfinding::~Pathfinding()
  */
 PathfindingNode *Pathfinding::getNode(Position pos)
 {
-	return &_nodes[_save->getTileIndex(pos)];
+	PathfindingNode *node = &_nodes[_save->getTileIndex(pos)];
+	if (node->getGeneration() != _generation)
+	{
+		// first use in this search
+		node->reset(_generation);
+	}
+	return node;
+}
+
+/**
+ * Starts a new search. Instead of resetting every node on the map,
+ * nodes get reset on their first use in the search.
+ */
+void Pathfinding::startSearch()
+{
+	++_generation;
+	if (_referenceSearch || _generation == 0)
+	{
+		for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
+			it->reset(_generation);
+	}
 }
 
 /**
@@ -82,6 +103,7 @@ PathfindingNode *Pathfinding::getNode(Position pos)
  */
 void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleUnit *target, int maxTUCost)
 {
+	Profiler::Scope profile("Pathfinding::calculate");
 	_totalTUCost = 0;
 	_path.clear();
 	// i'm DONE with these out of bounds errors.
@@ -156,6 +178,7 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleUnit *
  * Calculates the shortest path using a simple A-Star algorithm.
  * The unit information and movement type must have already been set.
  * The path information is set only if a valid path is found.
+ * @param openList Open set to use for the search.
  * @param startPosition The position to start from.
  * @param endPosition The position we want to reach.
  * @param target Target of the path.
@@ -163,16 +186,15 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleUnit *
  * @param maxTUCost Maximum time units the path can cost.
  * @return True if a path exists, false otherwise.
  */
-bool Pathfinding::aStarPath(Position startPosition, Position endPosition, BattleUnit *target, bool sneak, int maxTUCost)
+template<typename OpenSet>
+bool Pathfinding::aStarPath(OpenSet &openList, Position startPosition, Position endPosition, BattleUnit *target, bool sneak, int maxTUCost)
 {
-	// reset every node, so we have to check them all
-	for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
-		it->reset();
+	startSearch();
+	openList.clear();
 
 	// start position is the first one in our "open" list
 	PathfindingNode *start = getNode(startPosition);
 	start->connect(0, 0, 0, endPosition);
-	PathfindingOpenSet openList;
 	openList.push(start);
 	bool missile = (target && maxTUCost == 10000);
 	// if the open list is empty, we've reached the end
@@ -217,6 +239,26 @@ bool Pathfinding::aStarPath(Position startPosition, Position endPosition, Battle
 	return false;
 }
 
+/**
+ * Calculates the shortest path using a simple A-Star algorithm.
+ * The unit information and movement type must have already been set.
+ * The path information is set only if a valid path is found.
+ * @param startPosition The position to start from.
+ * @param endPosition The position we want to reach.
+ * @param target Target of the path.
+ * @param sneak Is the unit sneaking?
+ * @param maxTUCost Maximum time units the path can cost.
+ * @return True if a path exists, false otherwise.
+ */
+bool Pathfinding::aStarPath(Position startPosition, Position endPosition, BattleUnit *target, bool sneak, int maxTUCost)
+{
+	if (_referenceSearch)
+	{
+		return aStarPath(_heapOpenSet, startPosition, endPosition, target, sneak, maxTUCost);
+	}
+	return aStarPath(_openSet, startPosition, endPosition, target, sneak, maxTUCost);
+}
+
 /**
  * Gets the TU cost to move from 1 tile to the other (ONE STEP ONLY).
  * But also updates the endPosition, because it is possible
@@ -1140,22 +1182,20 @@ bool Pathfinding::bresenhamPath(Position origin, Position target, BattleUnit *ta
 /**
  * Locates all tiles reachable to @a *unit with a TU cost no more than @a tuMax.
  * Uses Dijkstra's algorithm.
+ * @param unvisited Open set to use for the search.
  * @param unit Pointer to the unit.
  * @param tuMax The maximum cost of the path to each tile.
- * @return An array of reachable tiles, sorted in ascending order of cost. The first tile is the start location.
+ * @param energyMax The maximum energy the path can use.
+ * @return An array of reachable nodes, sorted in ascending order of cost. The first node is the start location.
  */
-std::vector<int> Pathfinding::findReachable(BattleUnit *unit, const BattleActionCost &cost)
+template<typename OpenSet>
+std::vector<PathfindingNode*> Pathfinding::findReachable(OpenSet &unvisited, BattleUnit *unit, int tuMax, int energyMax)
 {
 	const Position start = unit->getPosition();
-	int tuMax = unit->getTimeUnits() - cost.Time;
-	int energyMax = unit->getEnergy() - cost.Energy;
-	for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
-	{
-		it->reset();
-	}
+	startSearch();
+	unvisited.clear();
 	PathfindingNode *startNode = getNode(start);
 	startNode->connect(0, 0, 0);
-	PathfindingOpenSet unvisited;
 	unvisited.push(startNode);
 	std::vector<PathfindingNode*> reachable;
 	while (!unvisited.empty())
@@ -1188,15 +1228,123 @@ std::vector<int> Pathfinding::findReachable(BattleUnit *unit, const BattleAction
 		reachable.push_back(currentNode);
 	}
 	std::sort(reachable.begin(), reachable.end(), MinNodeCosts());
+	return reachable;
+}
+
+/**
+ * Gets a hash of everything about the units that the reachable tiles depend on:
+ * where they stand, if they are out and if they are visible.
+ * @return Hash of the unit positions.
+ */
+Uint32 Pathfinding::getOccupancyHash() const
+{
+	Uint32 hash = 2166136261U;
+	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	{
+		const BattleUnit *unit = *i;
+		Uint32 values[] =
+		{
+			(Uint32)unit->getPosition().x, (Uint32)unit->getPosition().y, (Uint32)unit->getPosition().z,
+			(Uint32)unit->getStatus(), (Uint32)unit->getFaction(), (Uint32)unit->getVisible(), (Uint32)(unit->getTile() != 0),
+		};
+		for (Uint32 value : values)
+		{
+			hash = (hash ^ value) * 16777619U;
+		}
+	}
+	return hash;
+}
+
+/**
+ * Drops all the cached reachable tiles. Must be called when anything
+ * but the units changes the cost of moving around, ie. the terrain.
+ * Fire and smoke changes are picked up from the tile store on their own.
+ */
+void Pathfinding::invalidateReachable()
+{
+	++_reachableVersion;
+}
+
+/**
+ * Locates all tiles reachable to @a *unit with a TU cost no more than @a tuMax.
+ * The search with all the unit's time units and energy is done once and kept
+ * until the unit, the other units or the terrain change, then the tiles for
+ * smaller budgets are taken from it.
+ * @param unit Pointer to the unit.
+ * @param tuMax The maximum cost of the path to each tile.
+ * @param energyMax The maximum energy the path can use.
+ * @return An array of reachable tiles, sorted in ascending order of cost. The first tile is the start location.
+ */
+std::vector<int> Pathfinding::findReachableCached(BattleUnit *unit, int tuMax, int energyMax)
+{
+	ReachableCache &cache = _reachableCache[unit->getId()];
+	Uint32 occupancy = getOccupancyHash();
+	unsigned hazard = _save->getTileStore()->getHazardVersion();
+	if (cache.version != _reachableVersion || cache.hazard != hazard || cache.occupancy != occupancy ||
+		cache.position != unit->getPosition() || cache.direction != unit->getDirection() ||
+		cache.timeUnits != unit->getTimeUnits() || cache.energy != unit->getEnergy() ||
+		cache.movementType != unit->getMovementType() || cache.strafe != _strafeMove ||
+		cache.spotted != unit->getUnitsSpottedThisTurn().size())
+	{
+		cache.version = _reachableVersion;
+		cache.hazard = hazard;
+		cache.occupancy = occupancy;
+		cache.position = unit->getPosition();
+		cache.direction = unit->getDirection();
+		cache.timeUnits = unit->getTimeUnits();
+		cache.energy = unit->getEnergy();
+		cache.movementType = unit->getMovementType();
+		cache.strafe = _strafeMove;
+		cache.spotted = unit->getUnitsSpottedThisTurn().size();
+		cache.tiles.clear();
+		for (PathfindingNode *node : findReachable(_openSet, unit, cache.timeUnits, cache.energy))
+		{
+			cache.tiles.push_back(std::make_pair(_save->getTileIndex(node->getPosition()), node->getTUCost(false)));
+		}
+	}
+	else
+	{
+		Profiler::count("Pathfinding::findReachable cached");
+	}
+
+	// a smaller budget can only cut off the most expensive tiles
 	std::vector<int> tiles;
-	tiles.reserve(reachable.size());
-	for (std::vector<PathfindingNode*>::const_iterator it = reachable.begin(); it != reachable.end(); ++it)
+	tiles.reserve(cache.tiles.size());
+	for (std::vector<std::pair<int, int> >::const_iterator it = cache.tiles.begin(); it != cache.tiles.end(); ++it)
 	{
-		tiles.push_back(_save->getTileIndex((*it)->getPosition()));
+		if (it->second > tuMax || it->second / 2 > energyMax)
+		{
+			continue;
+		}
+		tiles.push_back(it->first);
 	}
 	return tiles;
 }
 
+/**
+ * Locates all tiles reachable to @a *unit with a TU cost no more than @a tuMax.
+ * Uses Dijkstra's algorithm.
+ * @param unit Pointer to the unit.
+ * @param cost Cost of the action to be done after the move.
+ * @return An array of reachable tiles, sorted in ascending order of cost. The first tile is the start location.
+ */
+std::vector<int> Pathfinding::findReachable(BattleUnit *unit, const BattleActionCost &cost)
+{
+	Profiler::Scope profile("Pathfinding::findReachable");
+	int tuMax = unit->getTimeUnits() - cost.Time;
+	int energyMax = unit->getEnergy() - cost.Energy;
+	if (_referenceSearch)
+	{
+		std::vector<int> tiles;
+		for (PathfindingNode *node : findReachable(_heapOpenSet, unit, tuMax, energyMax))
+		{
+			tiles.push_back(_save->getTileIndex(node->getPosition()));
+		}
+		return tiles;
+	}
+	return findReachableCached(unit, tuMax, energyMax);
+}
+
 /**
  * Gets the strafe move setting.
  * @return Strafe move.
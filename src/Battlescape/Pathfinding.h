@@ -17,9 +17,12 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <unordered_map>
 #include <vector>
+#include <SDL_types.h>
 #include "Position.h"
 #include "PathfindingNode.h"
+#include "PathfindingOpenSet.h"
 #include "../Mod/MapData.h"
 
 namespace OpenXcom
@@ -36,6 +39,20 @@ struct BattleActionCost;
 class Pathfinding
 {
 private:
+	/// Reachable tiles of a unit, with what they were calculated for.
+	struct ReachableCache
+	{
+		unsigned version = 0, hazard = 0;
+		Uint32 occupancy = 0;
+		Position position;
+		int direction = -1, timeUnits = -1, energy = -1;
+		MovementType movementType = MT_WALK;
+		bool strafe = false;
+		size_t spotted = 0;
+		/// Tile index and TU cost, sorted by cost.
+		std::vector<std::pair<int, int> > tiles;
+	};
+
 	constexpr static int dir_max = 10;
 	constexpr static int dir_x[dir_max] = {  0, +1, +1, +1,  0, -1, -1, -1,  0,  0};
 	constexpr static int dir_y[dir_max] = { -1, -1,  0, +1, +1, +1,  0, -1,  0,  0};
@@ -43,6 +60,12 @@ private:
 
 	SavedBattleGame *_save;
 	std::vector<PathfindingNode> _nodes;
+	unsigned _generation;
+	bool _referenceSearch;
+	PathfindingOpenSet _openSet;
+	PathfindingHeapOpenSet _heapOpenSet;
+	unsigned _reachableVersion;
+	std::unordered_map<int, ReachableCache> _reachableCache;
 	int _size;
 	BattleUnit *_unit;
 	bool _pathPreviewed;
@@ -52,12 +75,24 @@ private:
 	MovementType _movementType;
 	/// Gets the node at certain position.
 	PathfindingNode *getNode(Position pos);
+	/// Starts a new search on the nodes.
+	void startSearch();
 	/// Determines whether a tile blocks a certain movementType.
 	bool isBlocked(Tile *tile, const int part, BattleUnit *missileTarget, int bigWallExclusion = -1) const;
 	/// Tries to find a straight line path between two positions.
 	bool bresenhamPath(Position origin, Position target, BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
 	/// Tries to find a path between two positions.
 	bool aStarPath(Position origin, Position target, BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
+	/// Tries to find a path between two positions, using a specific open set.
+	template<typename OpenSet>
+	bool aStarPath(OpenSet &openList, Position origin, Position target, BattleUnit *missileTarget, bool sneak, int maxTUCost);
+	/// Gets all reachable tiles, using a specific open set.
+	template<typename OpenSet>
+	std::vector<PathfindingNode*> findReachable(OpenSet &unvisited, BattleUnit *unit, int tuMax, int energyMax);
+	/// Gets all reachable tiles, reusing the last search of the unit if nothing changed.
+	std::vector<int> findReachableCached(BattleUnit *unit, int tuMax, int energyMax);
+	/// Gets a hash of the unit positions.
+	Uint32 getOccupancyHash() const;
 	/// Determines whether a unit can fall down from this tile.
 	bool canFallDown(Tile *destinationTile) const;
 	/// Determines whether a unit can fall down from this tile.
@@ -131,8 +166,12 @@ public:
 	void setUnit(BattleUnit *unit);
 	/// Gets all reachable tiles, based on cost.
 	std::vector<int> findReachable(BattleUnit *unit, const BattleActionCost &cost);
+	/// Drops the cached reachable tiles.
+	void invalidateReachable();
 	/// Gets _totalTUCost; finds out whether we can hike somewhere in this turn or not.
 	int getTotalTUCost() const { return _totalTUCost; }
+	/// Uses the old full node reset and binary heap, to compare against in benchmarks.
+	void setReferenceSearch(bool reference) { _referenceSearch = reference; }
 	/// Gets the path preview setting.
 	bool isPathPreviewed() const;
 	/// Gets the modifier setting.
@@ -26,7 +26,7 @@ namespace OpenXcom
  * Sets up a PathfindingNode.
  * @param pos Position.
  */
-PathfindingNode::PathfindingNode(Position pos) : _pos(pos), _checked(0), _tuCost(0), _prevNode(0), _prevDir(0), _tuGuess(0), _openentry(0)
+PathfindingNode::PathfindingNode(Position pos) : _pos(pos), _checked(0), _tuCost(0), _prevNode(0), _prevDir(0), _tuGuess(0), _generation(0), _openCost(-1)
 {
 
 }
@@ -50,11 +50,13 @@ Position PathfindingNode::getPosition() const
 
 /**
  * Resets the node.
+ * @param generation Search the node is used by from now on.
  */
-void PathfindingNode::reset()
+void PathfindingNode::reset(unsigned generation)
 {
 	_checked = false;
-	_openentry = 0;
+	_openCost = -1;
+	_generation = generation;
 }
 
 /**
@@ -23,7 +23,7 @@ namespace OpenXcom
 {
 
 class PathfindingOpenSet;
-struct OpenSetEntry;
+class PathfindingHeapOpenSet;
 
 /**
  * A class that holds pathfinding info for a certain node on the map.
@@ -38,9 +38,12 @@ private:
 	int _prevDir;
 	/// Approximate cost to reach goal position.
 	int _tuGuess;
-	// Invasive field needed by PathfindingOpenSet
-	OpenSetEntry *_openentry;
+	/// Search the node was last reset for.
+	unsigned _generation;
+	// Invasive field needed by the open sets, cost the node is queued with or -1.
+	int _openCost;
 	friend class PathfindingOpenSet;
+	friend class PathfindingHeapOpenSet;
 public:
 	/// Creates a new PathfindingNode class.
 	PathfindingNode(Position pos);
@@ -48,8 +51,10 @@ public:
 	~PathfindingNode();
 	/// Gets the node position.
 	Position getPosition() const;
-	/// Resets the node.
-	void reset();
+	/// Resets the node for a new search.
+	void reset(unsigned generation);
+	/// Gets the search the node was last reset for.
+	unsigned getGeneration() const { return _generation; }
 	/// Is checked?
 	bool isChecked() const;
 	/// Marks the node as checked.
@@ -61,7 +66,7 @@ public:
 	/// Gets the previous walking direction.
 	int getPrevDir() const;
 	/// Is this node already in a PathfindingOpenSet?
-	bool inOpenSet() const { return (_openentry != 0); }
+	bool inOpenSet() const { return (_openCost >= 0); }
 	/// Gets the approximate cost to reach the target position.
 	int getTUGuess() const { return _tuGuess; }
 
@@ -16,6 +16,7 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <assert.h>
 #include "PathfindingOpenSet.h"
 #include "PathfindingNode.h"
@@ -24,44 +25,110 @@ namespace OpenXcom
 {
 
 /**
- * Cleans up all the entries still in set.
+ * Creates an empty bucket queue.
  */
-PathfindingOpenSet::~PathfindingOpenSet()
+PathfindingOpenSet::PathfindingOpenSet() : _first(0), _last(0), _count(0)
 {
-	while (!_queue.empty())
+
+}
+
+/**
+ * Removes all the nodes, keeping the memory of the buckets.
+ */
+void PathfindingOpenSet::clear()
+{
+	for (size_t i = _first; i <= _last && i < _buckets.size(); ++i)
 	{
-		OpenSetEntry *entry = _queue.top();
-		_queue.pop();
-		delete entry;
+		_buckets[i].nodes.clear();
+		_buckets[i].next = 0;
+	}
+	_first = _buckets.size();
+	_last = 0;
+	_count = 0;
+}
+
+/**
+ * Keeps removing nodes from the front of the cheapest bucket until
+ * one that wasn't discarded by a later push shows up.
+ * @return The oldest node with the lowest cost.
+ */
+PathfindingNode *PathfindingOpenSet::pop()
+{
+	assert(!empty());
+	while (true)
+	{
+		while (_buckets[_first].next == _buckets[_first].nodes.size())
+		{
+			_buckets[_first].nodes.clear();
+			_buckets[_first].next = 0;
+			++_first;
+		}
+		PathfindingNode *nd = _buckets[_first].nodes[_buckets[_first].next++];
+		if (nd->_openCost == (int)_first)
+		{
+			nd->_openCost = -1;
+			if (--_count == 0)
+			{
+				// only discarded entries left
+				clear();
+			}
+			return nd;
+		}
+	}
+}
+
+/**
+ * Adds a node to the bucket of its cost. If it was already in the set,
+ * the old entry is left behind and skipped when it comes up.
+ * @param node Node to add.
+ */
+void PathfindingOpenSet::push(PathfindingNode *node)
+{
+	size_t cost = node->getTUCost(false) + node->getTUGuess();
+	if (cost >= _buckets.size())
+	{
+		_buckets.resize(cost + 1);
+	}
+	if (!node->inOpenSet())
+	{
+		++_count;
 	}
+	node->_openCost = (int)cost;
+	_buckets[cost].nodes.push_back(node);
+	_first = std::min(_first, cost);
+	_last = std::max(_last, cost);
+}
+
+/**
+ * Removes all the nodes.
+ */
+void PathfindingHeapOpenSet::clear()
+{
+	_queue = std::priority_queue<OpenSetEntry, std::vector<OpenSetEntry>, EntryCompare>();
 }
 
 /**
  * Keeps removing all discarded entries that have come to the top of the queue.
  */
-void PathfindingOpenSet::removeDiscarded()
+void PathfindingHeapOpenSet::removeDiscarded()
 {
-	while (!_queue.empty() && !_queue.top()->_node)
+	while (!_queue.empty() && _queue.top()._node->_openCost != _queue.top()._cost)
 	{
-		OpenSetEntry *entry = _queue.top();
 		_queue.pop();
-		delete entry;
 	}
 }
 
 /**
  * Gets the node with the least cost.
- * After this call, the node is no longer in the set. It is an error to call this when the set is empty.
- * @return A pointer to the node which had the least cost.
+ * After this call, the node is no longer in the set.
+ * @return The node with the lowest cost.
  */
-PathfindingNode *PathfindingOpenSet::pop()
+PathfindingNode *PathfindingHeapOpenSet::pop()
 {
 	assert(!empty());
-	OpenSetEntry *entry = _queue.top();
-	PathfindingNode *nd = entry->_node;
+	PathfindingNode *nd = _queue.top()._node;
 	_queue.pop();
-	delete entry;
-	nd->_openentry = 0;
+	nd->_openCost = -1;
 
 	// Discarded entries might be visible now.
 	removeDiscarded();
@@ -74,16 +141,13 @@ PathfindingNode *PathfindingOpenSet::pop()
  * It is the caller's responsibility to never re-add a node with a worse cost.
  * @param node A pointer to the node to add.
  */
-void PathfindingOpenSet::push(PathfindingNode *node)
+void PathfindingHeapOpenSet::push(PathfindingNode *node)
 {
-	OpenSetEntry *entry = new OpenSetEntry;
-	entry->_node = node;
-	entry->_cost = node->getTUCost(false) + node->getTUGuess();
-	if (node->_openentry)
-		node->_openentry->_node = 0;
-	node->_openentry = entry;
+	OpenSetEntry entry;
+	entry._node = node;
+	entry._cost = node->getTUCost(false) + node->getTUGuess();
+	node->_openCost = entry._cost;
 	_queue.push(entry);
 }
 
-
 }
@@ -18,6 +18,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <queue>
+#include <vector>
 
 namespace OpenXcom
 {
@@ -30,41 +31,72 @@ struct OpenSetEntry
 	PathfindingNode *_node;
 };
 
-/**
- * Helper class to compare entries through pointers.
- */
 class EntryCompare
 {
 public:
 	/**
-	 * Compares entries @a *a and @a *b.
-	 * @param a Pointer to first entry.
-	 * @param b Pointer to second entry.
-	 * @return True if entry @a *b must come before @a *a.
+	 * Compares entries @a a and @a b.
+	 * @param a First entry.
+	 * @param b Second entry.
+	 * @return True if entry @a b must come before @a a.
 	 */
-	bool operator()(OpenSetEntry *a, OpenSetEntry *b) const
+	bool operator()(const OpenSetEntry &a, const OpenSetEntry &b) const
 	{
-		return b->_cost < a->_cost;
+		return b._cost < a._cost;
 	}
 };
 
 /**
- * A class that holds references to the nodes to be examined in pathfinding.
+ * Open set of the pathfinding searches, a bucket queue indexed by cost.
+ * TU costs are small integers, so finding the next node is just moving
+ * to the next non-empty bucket. Nodes of the same cost come out in the
+ * order they went in. The buckets keep their memory between searches.
  */
 class PathfindingOpenSet
 {
 public:
-	/// Cleans up the set and frees allocated memory.
-	~PathfindingOpenSet();
+	/// Creates an empty set.
+	PathfindingOpenSet();
+	/// Gets the next node to check.
+	PathfindingNode *pop();
+	/// Adds a node to the set.
+	void push(PathfindingNode *node);
+	/// Is the set empty?
+	bool empty() const { return _count == 0; }
+	/// Removes all the nodes.
+	void clear();
+
+private:
+	/// Nodes of one cost, read from the front.
+	struct Bucket
+	{
+		std::vector<PathfindingNode*> nodes;
+		size_t next = 0;
+	};
+
+	std::vector<Bucket> _buckets;
+	size_t _first, _last;
+	int _count;
+};
+
+/**
+ * Open set of the pathfinding searches using a binary heap,
+ * kept as the reference to compare the bucket queue with.
+ */
+class PathfindingHeapOpenSet
+{
+public:
 	/// Gets the next node to check.
 	PathfindingNode *pop();
 	/// Adds a node to the set.
 	void push(PathfindingNode *node);
 	/// Is the set empty?
 	bool empty() const { return _queue.empty(); }
+	/// Removes all the nodes.
+	void clear();
 
 private:
-	std::priority_queue<OpenSetEntry*, std::vector<OpenSetEntry*>, EntryCompare> _queue;
+	std::priority_queue<OpenSetEntry, std::vector<OpenSetEntry>, EntryCompare> _queue;
 
 	/// Removes reachable discarded entries.
 	void removeDiscarded();
@@ -827,6 +827,11 @@ void ProjectileFlyBState::think()
 			delete _parent->getMap()->getProjectile();
 			_parent->getMap()->setProjectile(0);
 		}
+		else
+		{
+			// still in flight
+			_parent->setOnlyMovingChanged();
+		}
 	}
 }
 
@@ -19,7 +19,11 @@
 #include <assert.h>
 #include <climits>
 #include <set>
+#include <unordered_set>
 #include "TileEngine.h"
+#include "BlastTemplate.h"
+#include "UnitGrid.h"
+#include "VoxelGrid.h"
 #include <SDL.h>
 #include "AIModule.h"
 #include "Map.h"
@@ -35,6 +39,8 @@
 #include "../Savegame/HitLog.h"
 #include "../Engine/RNG.h"
 #include "../Engine/GraphSubset.h"
+#include "../Engine/Parallel.h"
+#include "../Engine/Profiler.h"
 #include "BattlescapeState.h"
 #include "../Mod/MapDataSet.h"
 #include "../Mod/Unit.h"
@@ -54,15 +60,56 @@ namespace OpenXcom
 namespace
 {
 
+/**
+ * Gets how many steps of a line can be taken along a minor axis
+ * before it leaves the range [min, max] of that axis.
+ * @param pos Current position on the axis.
+ * @param step Direction of the line on the axis.
+ * @param min Lowest allowed position.
+ * @param max Highest allowed position.
+ * @param drift Current drift of the axis.
+ * @param deltaMajor Length of the line along the major axis.
+ * @param delta Length of the line along the axis.
+ * @return Number of major steps.
+ */
+inline int lineStepsInRange(int pos, int step, int min, int max, int drift, int deltaMajor, int delta)
+{
+	if (delta == 0)
+	{
+		return INT_MAX;
+	}
+	int room = step > 0 ? max - pos : pos - min;
+	return (room * deltaMajor + drift) / delta;
+}
+
+/**
+ * Gets how many times a minor axis moves in the next steps of a line.
+ * @param steps Number of major steps.
+ * @param drift Current drift of the axis.
+ * @param deltaMajor Length of the line along the major axis.
+ * @param delta Length of the line along the axis.
+ * @return Number of minor steps.
+ */
+inline int lineMovesInSteps(int steps, int drift, int deltaMajor, int delta)
+{
+	int over = steps * delta - drift;
+	return over > 0 ? (over + deltaMajor - 1) / deltaMajor : 0;
+}
+
 /**
  * Calculates a line trajectory, using bresenham algorithm in 3D.
+ * After each step skipFunc can return a box around the current position
+ * where nothing can be hit, the line then jumps straight to its last
+ * position inside that box, with the same drift it would have stepping
+ * through it, so the rest of the line is exactly the same.
  * @param origin Origin.
  * @param target Target.
  * @param posFunc Function call for each step in primary direction of line.
  * @param driftFunc Function call for each side step of line.
+ * @param skipFunc Function call for the box that can be skipped.
  */
-template<typename FuncNewPosition, typename FuncDrift>
-bool calculateLineHitHelper(const Position& origin, const Position& target, FuncNewPosition posFunc, FuncDrift driftFunc)
+template<typename FuncNewPosition, typename FuncDrift, typename FuncSkip>
+bool calculateLineHitHelper(const Position& origin, const Position& target, FuncNewPosition posFunc, FuncDrift driftFunc, FuncSkip skipFunc)
 {
 	int x, x0, x1, delta_x, step_x;
 	int y, y0, y1, delta_y, step_y;
@@ -127,6 +174,38 @@ bool calculateLineHitHelper(const Position& origin, const Position& target, Func
 
 		if (x == x1) break;
 
+		//jump over the part of the line that can't hit anything
+		Position boxMin, boxMax;
+		if (skipFunc(Position(cx, cy, cz), boxMin, boxMax))
+		{
+			//swap the box the same way as the line
+			if (swap_xy)
+			{
+				std::swap(boxMin.x, boxMin.y);
+				std::swap(boxMax.x, boxMax.y);
+			}
+			if (swap_xz)
+			{
+				std::swap(boxMin.x, boxMin.z);
+				std::swap(boxMax.x, boxMax.z);
+			}
+			int steps = step_x > 0 ? std::min<int>(boxMax.x, x1) - x : x - std::max<int>(boxMin.x, x1);
+			steps = std::min(steps, lineStepsInRange(y, step_y, boxMin.y, boxMax.y, drift_xy, delta_x, delta_y));
+			steps = std::min(steps, lineStepsInRange(z, step_z, boxMin.z, boxMax.z, drift_xz, delta_x, delta_z));
+			if (steps > 0)
+			{
+				int moves_y = lineMovesInSteps(steps, drift_xy, delta_x, delta_y);
+				int moves_z = lineMovesInSteps(steps, drift_xz, delta_x, delta_z);
+				x += steps * step_x;
+				y += moves_y * step_y;
+				z += moves_z * step_z;
+				drift_xy += moves_y * delta_x - steps * delta_y;
+				drift_xz += moves_z * delta_x - steps * delta_z;
+
+				if (x == x1) break;
+			}
+		}
+
 		//update progress in other planes
 		drift_xy = drift_xy - delta_y;
 		drift_xz = drift_xz - delta_z;
@@ -164,6 +243,19 @@ bool calculateLineHitHelper(const Position& origin, const Position& target, Func
 	return false;
 }
 
+/**
+ * Calculates a line trajectory, using bresenham algorithm in 3D, checking every step.
+ * @param origin Origin.
+ * @param target Target.
+ * @param posFunc Function call for each step in primary direction of line.
+ * @param driftFunc Function call for each side step of line.
+ */
+template<typename FuncNewPosition, typename FuncDrift>
+bool calculateLineHitHelper(const Position& origin, const Position& target, FuncNewPosition posFunc, FuncDrift driftFunc)
+{
+	return calculateLineHitHelper(origin, target, posFunc, driftFunc, [](Position, Position&, Position&) { return false; });
+}
+
 /**
  * Iterate through some subset of map tiles.
  * @param save Map data.
@@ -228,14 +320,32 @@ constexpr Position TileEngine::voxelTileCenter;
  * @param maxDarknessToSeeUnits Threshold of darkness for LoS calculation.
  */
 TileEngine::TileEngine(SavedBattleGame *save, Mod *mod) :
-	_save(save), _voxelData(mod->getVoxelData()), _inventorySlotGround(mod->getInventoryGround()), _personalLighting(true), _cacheTile(0), _cacheTileBelow(0),
+	_save(save), _voxelData(mod->getVoxelData()), _blockVisibility(_blockVisibilityData), _inventorySlotGround(mod->getInventoryGround()), _personalLighting(true), _cacheTile(0), _cacheTileBelow(0),
 	_maxViewDistance(mod->getMaxViewDistance()), _maxViewDistanceSq(_maxViewDistance * _maxViewDistance),
 	_maxVoxelViewDistance(_maxViewDistance * 16), _maxDarknessToSeeUnits(mod->getMaxDarknessToSeeUnits()),
 	_maxStaticLightDistance(mod->getMaxStaticLightDistance()), _maxDynamicLightDistance(mod->getMaxDynamicLightDistance()),
 	_enhancedLighting(mod->getEnhancedLighting())
 {
-	_blockVisibility.resize(save->getMapSizeXYZ());
-	_cacheTilePos = invalid;
+	_blockVisibilityData.resize(save->getMapSizeXYZ());
+	_voxelGrid = std::make_shared<VoxelGrid>(save, _voxelData);
+	voxelCheckFlush();
+}
+
+/**
+ * Sets up a TileEngine for a worker thread. It shares everything
+ * with the main engine, except the caches used by the traces.
+ * The blockage cache is read straight from the main engine, it only
+ * changes on the main thread while no worker is running.
+ * @param main Engine of the battle.
+ */
+TileEngine::TileEngine(const TileEngine *main) :
+	_save(main->_save), _voxelData(main->_voxelData), _blockVisibility(main->_blockVisibilityData), _inventorySlotGround(main->_inventorySlotGround), _personalLighting(main->_personalLighting), _cacheTile(0), _cacheTileBelow(0),
+	_maxViewDistance(main->_maxViewDistance), _maxViewDistanceSq(main->_maxViewDistanceSq),
+	_maxVoxelViewDistance(main->_maxVoxelViewDistance), _maxDarknessToSeeUnits(main->_maxDarknessToSeeUnits),
+	_maxStaticLightDistance(main->_maxStaticLightDistance), _maxDynamicLightDistance(main->_maxDynamicLightDistance),
+	_enhancedLighting(main->_enhancedLighting), _voxelGrid(main->_voxelGrid)
+{
+	voxelCheckFlush();
 }
 
 /**
@@ -246,6 +356,24 @@ TileEngine::~TileEngine()
 
 }
 
+/**
+ * Makes sure there are enough engines for the worker threads,
+ * and brings their settings and trace caches up to date.
+ * @param count Number of worker threads.
+ */
+void TileEngine::prepareWorkers(int count)
+{
+	while ((int)_workers.size() < count)
+	{
+		_workers.push_back(std::unique_ptr<TileEngine>(new TileEngine(this)));
+	}
+	for (int i = 0; i < count; ++i)
+	{
+		_workers[i]->_referenceTracing = _referenceTracing;
+		_workers[i]->voxelCheckFlush();
+	}
+}
+
 /**
   * Calculates sun shading for the whole terrain.
   */
@@ -333,29 +461,12 @@ void TileEngine::calculateTerrainBackground(MapSubset gs)
   */
 void TileEngine::calculateTerrainItems(MapSubset gs)
 {
-	// add lighting of terrain
-	iterateTiles(
-		_save,
-		mapAreaExpand(gs, getMaxDynamicLightDistance() - 1),
-		[&](Tile* tile)
-		{
-			auto currLight = 0;
-
-			for (BattleItem *it : *tile->getInventory())
-			{
-				if (it->getGlow())
-				{
-					currLight = std::max(currLight, it->getGlowRange());
-				}
-			}
-
-			if (currLight >= getMaxDynamicLightDistance())
-			{
-				currLight = getMaxDynamicLightDistance() - 1;
-			}
-			addLight(gs, tile->getPosition(), currLight, LL_ITEMS);
-		}
-	);
+	std::vector<LightSource> sources;
+	getDynamicLights(LL_ITEMS, mapAreaExpand(gs, getMaxDynamicLightDistance() - 1), sources);
+	for (const LightSource &source : sources)
+	{
+		addLight(gs, source.center, source.power, LL_ITEMS);
+	}
 }
 
 /**
@@ -363,6 +474,60 @@ void TileEngine::calculateTerrainItems(MapSubset gs)
   */
 void TileEngine::calculateUnitLighting(MapSubset gs)
 {
+	std::vector<LightSource> sources;
+	getDynamicLights(LL_UNITS, gs, sources);
+	for (const LightSource &source : sources)
+	{
+		addLight(gs, source.center, source.power, LL_UNITS);
+	}
+}
+
+/**
+ * Gets the light sources of the items or units layer.
+ * @param layer Either LL_ITEMS or LL_UNITS.
+ * @param gs Area to look for items in, units are taken from the whole map.
+ * @param sources Gets the sources with any light, in the order they are applied.
+ */
+void TileEngine::getDynamicLights(LightLayers layer, MapSubset gs, std::vector<LightSource> &sources)
+{
+	auto addSource = [&](int key, Position center, int power)
+	{
+		if (power >= getMaxDynamicLightDistance())
+		{
+			power = getMaxDynamicLightDistance() - 1;
+		}
+		if (power > 0)
+		{
+			sources.push_back(LightSource());
+			sources.back().key = key;
+			sources.back().center = center;
+			sources.back().power = power;
+		}
+	};
+
+	if (layer == LL_ITEMS)
+	{
+		// add lighting of terrain
+		iterateTiles(
+			_save,
+			gs,
+			[&](Tile* tile)
+			{
+				auto currLight = 0;
+
+				for (BattleItem *it : *tile->getInventory())
+				{
+					if (it->getGlow())
+					{
+						currLight = std::max(currLight, it->getGlowRange());
+					}
+				}
+				addSource(_save->getTileIndex(tile->getPosition()), tile->getPosition(), currLight);
+			}
+		);
+		return;
+	}
+
 	const int fireLightPower = 15; // amount of light a fire generates
 
 	for (BattleUnit *unit : *_save->getUnits())
@@ -392,24 +557,153 @@ void TileEngine::calculateUnitLighting(MapSubset gs)
 			currLight = std::max(currLight, fireLightPower);
 		}
 
-		if (currLight >= getMaxDynamicLightDistance())
-		{
-			currLight = getMaxDynamicLightDistance() - 1;
-		}
 		const auto size = unit->getArmor()->getSize();
 		const auto pos = unit->getPosition();
 		for (int x = 0; x < size; ++x)
 		{
 			for (int y = 0; y < size; ++y)
 			{
-				addLight(gs, pos + Position(x, y, 0), currLight, LL_UNITS);
+				addSource(unit->getId() * 4 + x + y * 2, pos + Position(x, y, 0), currLight);
 			}
 		}
 	}
 }
 
+/**
+ * Updates the items or units layer by only redoing the lights that changed.
+ * The light every source gives to the tiles is kept, so when a source moves,
+ * changes or goes away only the tiles it lit (before and after) are
+ * recalculated, taking the brightest of the sources reaching them.
+ * @param layer Either LL_ITEMS or LL_UNITS.
+ * @param gs Area that changed.
+ */
+void TileEngine::updateDynamicLights(LightLayers layer, MapSubset gs)
+{
+	std::map<int, LightSource> &stored = _lightSources[layer - LL_ITEMS];
+	const MapSubset sourceArea = layer == LL_ITEMS ? mapAreaExpand(gs, getMaxDynamicLightDistance() - 1) : MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() };
+	std::vector<LightSource> current;
+	getDynamicLights(layer, sourceArea, current);
+
+	std::vector<int> dirty;
+	_lightDirty.resize(_save->getMapSizeXYZ(), 0);
+	auto markDirty = [&](const LightSource &source)
+	{
+		for (const auto &t : source.tiles)
+		{
+			if (!_lightDirty[t.first])
+			{
+				_lightDirty[t.first] = 1;
+				dirty.push_back(t.first);
+			}
+		}
+	};
+
+	// drop the sources that are gone or changed
+	std::map<int, const LightSource*> currentByKey;
+	for (const LightSource &source : current)
+	{
+		currentByKey[source.key] = &source;
+	}
+	for (std::map<int, LightSource>::iterator i = stored.begin(); i != stored.end();)
+	{
+		const Position &center = i->second.center;
+		if (center.x < sourceArea.beg_x || center.x >= sourceArea.end_x || center.y < sourceArea.beg_y || center.y >= sourceArea.end_y)
+		{
+			++i;
+			continue;
+		}
+		std::map<int, const LightSource*>::const_iterator found = currentByKey.find(i->first);
+		if (found == currentByKey.end() || found->second->center != center || found->second->power != i->second.power)
+		{
+			markDirty(i->second);
+			i = stored.erase(i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	// trace the new ones
+	const MapSubset wholeMap = { _save->getMapSizeX(), _save->getMapSizeY() };
+	for (LightSource &source : current)
+	{
+		if (stored.find(source.key) == stored.end())
+		{
+			addLight(wholeMap, source.center, source.power, layer, &source.tiles);
+			markDirty(source);
+			stored[source.key] = std::move(source);
+		}
+	}
+
+	if (dirty.empty())
+	{
+		return;
+	}
+	Uint8 *light = _save->getTileStore()->getLight(layer);
+	for (int index : dirty)
+	{
+		light[index] = 0;
+	}
+	for (const auto &source : stored)
+	{
+		for (const auto &t : source.second.tiles)
+		{
+			if (_lightDirty[t.first] && light[t.first] < t.second)
+			{
+				light[t.first] = t.second;
+			}
+		}
+	}
+	for (int index : dirty)
+	{
+		_lightDirty[index] = 0;
+	}
+	Profiler::count("TileEngine::updateDynamicLights tiles", dirty.size());
+}
+
+/**
+ * Throws away the kept light sources and calculates the items
+ * and units layers of the whole map again.
+ */
+void TileEngine::rebuildDynamicLights()
+{
+	const MapSubset wholeMap = { _save->getMapSizeX(), _save->getMapSizeY() };
+	resetLight(wholeMap, LL_ITEMS);
+	for (int layer = LL_ITEMS; layer <= LL_UNITS; ++layer)
+	{
+		_lightSources[layer - LL_ITEMS].clear();
+		updateDynamicLights((LightLayers)layer, wholeMap);
+	}
+	_lightSourcesValid = true;
+}
+
+/**
+ * Clears the light of an area of the map, in a layer and all the layers above it.
+ * Goes through the rows of the dense light arrays instead of the tiles.
+ * @param gs Area of the map.
+ * @param layer First layer to clear.
+ */
+void TileEngine::resetLight(MapSubset gs, LightLayers layer)
+{
+	gs = MapSubset::intersection(gs, MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() });
+	if (!gs)
+	{
+		return;
+	}
+	TileStore *store = _save->getTileStore();
+	for (int z = 0; z < _save->getMapSizeZ(); ++z)
+	{
+		for (int y = gs.beg_y; y < gs.end_y; ++y)
+		{
+			store->resetLight(layer, _save->getTileIndex(Position(gs.beg_x, y, z)), gs.size_x());
+		}
+	}
+}
+
 void TileEngine::calculateLighting(LightLayers layer, Position position, int eventRadius, bool terrianChanged)
 {
+	Profiler::Scope profile("TileEngine::calculateLighting");
 	auto gsDynamic = MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() };
 	auto gsStatic = gsDynamic;
 
@@ -419,6 +713,26 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 		gsStatic = mapArea(position, eventRadius + getMaxStaticLightDistance());
 	}
 
+	// enhanced lighting cuts rays short against the brightest light so far, which depends
+	// on the order of the sources, so only the full recalculation gives the same shading
+	if (Options::oxceIncrementalLighting && !_enhancedLighting && layer >= LL_ITEMS && !terrianChanged)
+	{
+		if (!_lightSourcesValid)
+		{
+			rebuildDynamicLights();
+		}
+		else
+		{
+			for (int l = layer; l <= LL_UNITS; ++l)
+			{
+				updateDynamicLights((LightLayers)l, gsDynamic);
+			}
+		}
+		return;
+	}
+	// the lower layers change what the kept lights would add
+	_lightSourcesValid = false;
+
 	if (terrianChanged)
 	{
 		iterateTiles(
@@ -429,7 +743,7 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 				const auto currPos = tile->getPosition();
 				const auto index = _save->getTileIndex(currPos);
 				const auto mapData = tile->getMapData(O_OBJECT);
-				auto &cache = _blockVisibility[index];
+				auto &cache = _blockVisibilityData[index];
 
 				cache = {};
 				cache.height = -tile->getTerrainLevel();
@@ -442,6 +756,7 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 				}
 				cache.smoke = (tile->getSmoke() > 0);
 				cache.fire = (tile->getFire() > 0);
+				_voxelGrid->update(tile);
 				cache.blockUp = (verticalBlockage(tile, _save->getAboveTile(tile), DT_NONE) > 127);
 				cache.blockDown = (verticalBlockage(tile, _save->getBelowTile(tile), DT_NONE) > 127);
 				for (int dir = 0; dir < 8; ++dir)
@@ -477,28 +792,14 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 				}
 			}
 		);
+		voxelCheckFlush();
 	}
 
 	if (layer <= LL_FIRE)
 	{
-		iterateTiles(
-			_save,
-			gsStatic,
-			[&](Tile* tile)
-			{
-				tile->resetLightMulti(layer);
-			}
-		);
+		resetLight(gsStatic, layer);
 	}
-
-	iterateTiles(
-		_save,
-		gsDynamic,
-		[&](Tile* tile)
-		{
-			tile->resetLightMulti(std::max(layer, LL_ITEMS));
-		}
-	);
+	resetLight(gsDynamic, std::max(layer, LL_ITEMS));
 
 	if (layer <= LL_AMBIENT) calculateSunShading(gsStatic);
 	if (layer <= LL_FIRE) calculateTerrainBackground(gsStatic);
@@ -511,8 +812,9 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
  * @param center Center.
  * @param power Power.
  * @param layer Light is separated in 4 layers: Ambient, Tiles, Items, Units.
+ * @param footprint If set, gets the light of this source alone on each tile, instead of adding it to the tiles.
  */
-void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers layer)
+void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers layer, std::vector<std::pair<int, Uint8> > *footprint)
 	{
 	if (power <= 0)
 	{
@@ -541,8 +843,19 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 			const auto target = tile->getPosition();
 			const auto diff = target - center;
 			const auto distance = (int)Round(Position::distance(target, center));
-			const auto targetLight = tile->getLightMulti(layer);
+			const auto targetLight = footprint ? 0 : tile->getLightMulti(layer);
 			auto currLight = power - distance;
+			auto apply = [&](int light)
+			{
+				if (footprint)
+				{
+					footprint->push_back(std::make_pair(_save->getTileIndex(target), (Uint8)light));
+				}
+				else
+				{
+					tile->addLight(light, layer);
+				}
+			};
 
 			if (currLight <= targetLight)
 			{
@@ -550,7 +863,7 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 			}
 			if (clasicLighting)
 			{
-				tile->addLight(currLight, layer);
+				apply(currLight);
 				return;
 			}
 
@@ -669,7 +982,7 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 			currLight = (lightA + lightB) / 2;
 			if (currLight > targetLight)
 			{
-				tile->addLight(currLight, layer);
+				apply(currLight);
 			}
 		}
 	);
@@ -744,20 +1057,35 @@ inline bool TileEngine::inEventVisibilitySector(const Position &toCheck) const
 */
 bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos, const int eventRadius)
 {
-	size_t oldNumVisibleUnits = unit->getUnitsSpottedThisTurn().size();
+	FieldOfView fov;
+	collectUnitsInFOV(unit, eventPos, eventRadius, fov);
+	return applyUnitsInFOV(unit, fov);
+}
+
+/**
+* Checks which units are visible to a unit, the results are stored in the order
+* the checks happen and applied later by applyUnitsInFOV. Doesn't change any
+* unit or tile, so different units can be checked at the same time.
+* @param unit Unit to check line of sight of.
+* @param eventPos The centre of the event which necessitated the FOV update. Used to optimize which tiles to update.
+* @param eventRadius The radius of a circle able to fully encompass the event, in tiles. Hence: 1 for a single tile event.
+* @param fov Results of the check.
+*/
+void TileEngine::collectUnitsInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, FieldOfView &fov)
+{
 	bool useTurretDirection = false;
 	if (Options::strafe && (unit->getTurretType() > -1)) {
 		useTurretDirection = true;
 	}
 
 	if (unit->isOut())
-		return false;
+		return;
 
 	Position posSelf = unit->getPosition();
 	if (setupEventVisibilitySector(posSelf, eventPos, eventRadius))
 	{
 		//Asked to do a full check. Or the event is overlapping our tile. Better check everything.
-		unit->clearVisibleUnits();
+		fov.clearUnits = true;
 	}
 
 	//Loop through all units specified and figure out which ones we can actually see.
@@ -778,42 +1106,72 @@ bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos,
 						if (!unit->checkViewSector(posToCheck, useTurretDirection))
 						{
 							//Unit within arc, but not in view sector. If it just walked out we need to remove it.
-							unit->removeFromVisibleUnits((*i));
+							fov.units.push_back(std::make_pair(*i, false));
 						}
 						else if (visible(unit, _save->getTile(posToCheck))) // (distance is checked here)
 						{
 							//Unit (or part thereof) visible to one or more eyes of this unit.
-							if (unit->getFaction() == FACTION_PLAYER)
-							{
-								(*i)->setVisible(true);
-							}
-							if ((( (*i)->getFaction() == FACTION_HOSTILE && unit->getFaction() == FACTION_PLAYER )
-								|| ( (*i)->getFaction() != FACTION_HOSTILE && unit->getFaction() == FACTION_HOSTILE ))
-								&& !unit->hasVisibleUnit((*i)))
-							{
-								unit->addToVisibleUnits((*i));
-								unit->addToVisibleTiles((*i)->getTile());
-
-								if (unit->getFaction() == FACTION_HOSTILE && (*i)->getFaction() != FACTION_HOSTILE)
-								{
-									(*i)->setTurnsSinceSpotted(0);
-
-									(*i)->setTurnsLeftSpottedForSnipers(std::max(unit->getSpotterDuration(), (*i)->getTurnsLeftSpottedForSnipers())); // defaults to 0 = no information given to snipers
-								}
-							}
+							fov.units.push_back(std::make_pair(*i, true));
 
 							x = y = sizeOther; //If a unit's tile is visible there's no need to check the others: break the loops.
 						}
 						else
 						{
 							//Within arc, but not visible. Need to check to see if whatever happened at eventPos blocked a previously seen unit.
-							unit->removeFromVisibleUnits((*i));
+							fov.units.push_back(std::make_pair(*i, false));
 						}
 					}
 				}
 			}
 		}
 	}
+}
+
+/**
+* Updates the visible units of a unit with the results of collectUnitsInFOV.
+* @param unit Unit to update.
+* @param fov Results of the check.
+* @return True when new aliens are spotted.
+*/
+bool TileEngine::applyUnitsInFOV(BattleUnit *unit, const FieldOfView &fov)
+{
+	size_t oldNumVisibleUnits = unit->getUnitsSpottedThisTurn().size();
+
+	if (unit->isOut())
+		return false;
+
+	if (fov.clearUnits)
+	{
+		unit->clearVisibleUnits();
+	}
+
+	for (std::vector<std::pair<BattleUnit*, bool> >::const_iterator i = fov.units.begin(); i != fov.units.end(); ++i)
+	{
+		BattleUnit *other = i->first;
+		if (!i->second)
+		{
+			unit->removeFromVisibleUnits(other);
+			continue;
+		}
+		if (unit->getFaction() == FACTION_PLAYER)
+		{
+			other->setVisible(true);
+		}
+		if ((( other->getFaction() == FACTION_HOSTILE && unit->getFaction() == FACTION_PLAYER )
+			|| ( other->getFaction() != FACTION_HOSTILE && unit->getFaction() == FACTION_HOSTILE ))
+			&& !unit->hasVisibleUnit(other))
+		{
+			unit->addToVisibleUnits(other);
+			unit->addToVisibleTiles(other->getTile());
+
+			if (unit->getFaction() == FACTION_HOSTILE && other->getFaction() != FACTION_HOSTILE)
+			{
+				other->setTurnsSinceSpotted(0);
+
+				other->setTurnsLeftSpottedForSnipers(std::max(unit->getSpotterDuration(), other->getTurnsLeftSpottedForSnipers())); // defaults to 0 = no information given to snipers
+			}
+		}
+	}
 	// we only react when there are at least the same amount of visible units as before AND the checksum is different
 	// this way we stop if there are the same amount of visible units, but a different unit is seen
 	// or we stop if there are more visible units seen
@@ -833,6 +1191,22 @@ bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos,
 * @param eventRadius The radius of a circle able to fully encompass the event, in tiles. Hence: 1 for a single tile event.
 */
 void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius)
+{
+	FieldOfView fov;
+	collectTilesInFOV(unit, eventPos, eventRadius, fov);
+	applyTilesInFOV(unit, fov);
+}
+
+/**
+* Traces the tiles visible to a player controlled soldier, the results are applied
+* later by applyTilesInFOV. Doesn't change any unit or tile, so different units can
+* be traced at the same time.
+* @param unit Unit to check line of sight of.
+* @param eventPos The centre of the event which necessitated the FOV update. Used to optimize which tiles to update.
+* @param eventRadius The radius of a circle able to fully encompass the event, in tiles. Hence: 1 for a single tile event.
+* @param fov Results of the trace.
+*/
+void TileEngine::collectTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, FieldOfView &fov)
 {
 	bool useTurretDirection = false;
 	bool skipNarrowArcTest = false;
@@ -852,14 +1226,14 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 	}
 	else if (unit->isOut())
 	{
-		unit->clearVisibleTiles();
+		fov.clearTiles = true;
 		return;
 	}
 	Position posSelf = unit->getPosition();
 	if (setupEventVisibilitySector(posSelf, eventPos, eventRadius))
 	{
 		//Asked to do a full check. Or unit within event. Should update all.
-		unit->clearVisibleTiles();
+		fov.clearTiles = true;
 		skipNarrowArcTest = true;
 	}
 
@@ -869,6 +1243,7 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 	//Variables for finding the tiles to test based on the view direction.
 	Position posTest;
 	std::vector<Position> _trajectory;
+	std::unordered_set<Tile*> traced;
 	bool swap = (direction == 0 || direction == 4);
 	const int signX[8] = { +1, +1, +1, +1, -1, -1, -1, -1 };
 	const int signY[8] = { -1, -1, -1, +1, +1, +1, -1, -1 };
@@ -929,20 +1304,12 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 									//Reveal all tiles along line of vision. Note: needed due to width of bresenham stroke.
 									for (std::vector<Position>::iterator i = _trajectory.begin(); i != _trajectory.end(); ++i)
 									{
-										Position posVisited = (*i);
 										//Add tiles to the visible list only once. BUT we still need to calculate the whole trajectory as
 										// this bresenham line's period might be different from the one that originally revealed the tile.
-										if (!unit->hasVisibleTile(_save->getTile(posVisited)))
+										Tile *tileVisited = _save->getTile(*i);
+										if (traced.insert(tileVisited).second)
 										{
-											unit->addToVisibleTiles(_save->getTile(posVisited));
-											_save->getTile(posVisited)->setVisible(+1);
-											_save->getTile(posVisited)->setDiscovered(true, O_FLOOR);
-
-											// walls to the east or south of a visible tile, we see that too
-											Tile* t = _save->getTile(Position(posVisited.x + 1, posVisited.y, posVisited.z));
-											if (t) t->setDiscovered(true, O_WESTWALL);
-											t = _save->getTile(Position(posVisited.x, posVisited.y + 1, posVisited.z));
-											if (t) t->setDiscovered(true, O_NORTHWALL);
+											fov.tiles.push_back(tileVisited);
 										}
 									}
 								}
@@ -955,6 +1322,36 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 	}
 }
 
+/**
+* Marks the tiles traced by collectTilesInFOV as visible and discovered.
+* @param unit Unit to update.
+* @param fov Results of the trace.
+*/
+void TileEngine::applyTilesInFOV(BattleUnit *unit, const FieldOfView &fov)
+{
+	if (fov.clearTiles)
+	{
+		unit->clearVisibleTiles();
+	}
+	for (std::vector<Tile*>::const_iterator i = fov.tiles.begin(); i != fov.tiles.end(); ++i)
+	{
+		Tile *tileVisited = (*i);
+		if (!unit->hasVisibleTile(tileVisited))
+		{
+			Position posVisited = tileVisited->getPosition();
+			unit->addToVisibleTiles(tileVisited);
+			tileVisited->setVisible(+1);
+			tileVisited->setDiscovered(true, O_FLOOR);
+
+			// walls to the east or south of a visible tile, we see that too
+			Tile* t = _save->getTile(Position(posVisited.x + 1, posVisited.y, posVisited.z));
+			if (t) t->setDiscovered(true, O_WESTWALL);
+			t = _save->getTile(Position(posVisited.x, posVisited.y + 1, posVisited.z));
+			if (t) t->setDiscovered(true, O_NORTHWALL);
+		}
+	}
+}
+
 /**
 * Recalculates line of sight of a soldier.
 * @param unit Unit to check line of sight of.
@@ -964,6 +1361,7 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 */
 bool TileEngine::calculateFOV(BattleUnit *unit, bool doTileRecalc, bool doUnitRecalc)
 {
+	Profiler::Scope profile("TileEngine::calculateFOV(unit)");
 	//Force a full FOV recheck for this unit.
 	if (doTileRecalc) calculateTilesInFOV(unit);
 	return doUnitRecalc ? calculateUnitsInFOV(unit) : false;
@@ -1339,7 +1737,9 @@ int TileEngine::checkVoxelExposure(Position *originVoxel, Tile *tile, BattleUnit
 {
 	Position targetVoxel = tile->getPosition().toVoxel() + Position(7, 8, 0);
 	Position scanVoxel;
-	std::vector<Position> _trajectory;
+	std::vector<Position> scanVoxels;
+	std::vector<Position> impacts;
+	std::vector<VoxelType> results;
 	BattleUnit *otherUnit = tile->getUnit();
 	if (otherUnit == 0) return 0; //no unit in this tile, even if it elevated and appearing in it.
 	if (otherUnit == excludeUnit) return 0; //skip self
@@ -1386,18 +1786,22 @@ int TileEngine::checkVoxelExposure(Position *originVoxel, Tile *tile, BattleUnit
 		{
 			scanVoxel.x=targetVoxel.x + sliceTargets[j*2];
 			scanVoxel.y=targetVoxel.y + sliceTargets[j*2+1];
-			_trajectory.clear();
-			int test = calculateLineVoxel(*originVoxel, scanVoxel, false, &_trajectory, excludeUnit, excludeAllBut);
-			if (test == V_UNIT)
+			scanVoxels.push_back(scanVoxel);
+		}
+	}
+	// all the rays start at the same place, trace them together
+	calculateLineVoxels(*originVoxel, scanVoxels, results, impacts, excludeUnit, excludeAllBut);
+	for (size_t i = 0; i < scanVoxels.size(); ++i)
+	{
+		if (results[i] == V_UNIT)
+		{
+			//voxel of hit must be inside of scanned box
+			if (impacts[i].x/16 == scanVoxels[i].x/16 &&
+				impacts[i].y/16 == scanVoxels[i].y/16 &&
+				impacts[i].z >= targetMinHeight &&
+				impacts[i].z <= targetMaxHeight)
 			{
-				//voxel of hit must be inside of scanned box
-				if (_trajectory.at(0).x/16 == scanVoxel.x/16 &&
-					_trajectory.at(0).y/16 == scanVoxel.y/16 &&
-					_trajectory.at(0).z >= targetMinHeight &&
-					_trajectory.at(0).z <= targetMaxHeight)
-				{
-					++visible;
-				}
+				++visible;
 			}
 		}
 	}
@@ -1691,6 +2095,7 @@ bool TileEngine::canTargetTile(Position *originVoxel, Tile *tile, int part, Posi
  */
 void TileEngine::calculateFOV(Position position, int eventRadius, const bool updateTiles, const bool appendToTileVisibility)
 {
+	Profiler::Scope profile("TileEngine::calculateFOV(position)");
 	int updateRadius;
 	if (eventRadius == -1)
 	{
@@ -1703,24 +2108,76 @@ void TileEngine::calculateFOV(Position position, int eventRadius, const bool upd
 		updateRadius = getMaxViewDistance() + (eventRadius > 0 ? eventRadius : 0);
 		updateRadius *= updateRadius;
 	}
+	std::vector<BattleUnit*> units;
 	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
 		if (Position::distance2dSq(position, (*i)->getPosition()) <= updateRadius) //could this unit have observed the event?
+		{
+			units.push_back(*i);
+		}
+	}
+	calculateFOV(units, position, eventRadius, updateTiles, appendToTileVisibility);
+}
+
+/**
+ * Calculates the field of view of several units. The expensive line of sight
+ * traces run on the worker threads, each with its own engine; the results
+ * are then applied one unit after another in the given order, which gives
+ * exactly the same outcome as updating the units one by one.
+ * @param units Units to update.
+ * @param eventPos Position of the event, or invalid for a full update.
+ * @param eventRadius Radius of circle big enough to encompass the event.
+ * @param updateTiles true to do an update of visible tiles.
+ * @param appendToTileVisibility true to append only new tiles and skip previously seen ones.
+ */
+void TileEngine::calculateFOV(const std::vector<BattleUnit*> &units, Position eventPos, int eventRadius, bool updateTiles, bool appendToTileVisibility)
+{
+	std::vector<FieldOfView> results(units.size());
+	forEachParallel(units.size(),
+		[&](size_t i, TileEngine *engine)
 		{
 			if (updateTiles)
 			{
-				if (!appendToTileVisibility)
-				{
-					(*i)->clearVisibleTiles();
-				}
-				calculateTilesInFOV((*i), position, eventRadius);
+				engine->collectTilesInFOV(units[i], eventPos, eventRadius, results[i]);
 			}
-
-			calculateUnitsInFOV((*i), position, eventRadius);
+			engine->collectUnitsInFOV(units[i], eventPos, eventRadius, results[i]);
 		}
+	);
+	for (size_t i = 0; i < units.size(); ++i)
+	{
+		if (updateTiles)
+		{
+			if (!appendToTileVisibility)
+			{
+				units[i]->clearVisibleTiles();
+			}
+			applyTilesInFOV(units[i], results[i]);
+		}
+		applyUnitsInFOV(units[i], results[i]);
 	}
 }
 
+/**
+ * Runs a function for every index in [0, count) on the worker threads.
+ * Each thread gets its own engine with its own voxel cache, so the function
+ * can trace lines of sight and fire, but must not change the battle.
+ * @param count Number of work items.
+ * @param func Function called with the item index and the engine to use.
+ */
+void TileEngine::forEachParallel(size_t count, const std::function<void(size_t index, TileEngine *engine)> &func)
+{
+	if (count > 1)
+	{
+		prepareWorkers(Parallel::getThreadCount() - 1);
+	}
+	Parallel::forEach(count,
+		[&](size_t i, int thread)
+		{
+			func(i, thread == 0 ? this : _workers[thread - 1].get());
+		}
+	);
+}
+
 /**
  * Checks if a sniper from the opposing faction sees this unit. The unit with the highest reaction score will be compared with the current unit's reaction score.
  * If it's higher, a shot is fired when enough time units, a weapon and ammo are available.
@@ -1729,6 +2186,7 @@ void TileEngine::calculateFOV(Position position, int eventRadius, const bool upd
  */
 bool TileEngine::checkReactionFire(BattleUnit *unit, const BattleAction &originalAction)
 {
+	Profiler::Scope profile("TileEngine::checkReactionFire");
 	// reaction fire only triggered when the actioning unit is of the currently playing side, and is still on the map (alive)
 	if (unit->getFaction() != _save->getSide() || unit->getTile() == 0)
 	{
@@ -1785,7 +2243,11 @@ std::vector<TileEngine::ReactionScore> TileEngine::getSpottingUnits(BattleUnit*
 	// no reaction on civilian turn.
 	if (_save->getSide() != FACTION_NEUTRAL)
 	{
-		for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+		// only the units close enough can react
+		std::vector<BattleUnit*> candidates;
+		_save->getUnitGrid()->getUnitsNear(unit->getPosition(), getMaxViewDistance(), candidates);
+		Profiler::count("TileEngine::getSpottingUnits candidates", candidates.size());
+		for (std::vector<BattleUnit*>::const_iterator i = candidates.begin(); i != candidates.end(); ++i)
 		{
 				// not dead/unconscious
 			if (!(*i)->isOut() &&
@@ -1879,6 +2341,7 @@ std::vector<TileEngine::ReactionScore> TileEngine::getSpottingUnits(BattleUnit*
 				}
 			}
 		}
+		Profiler::count("TileEngine::getSpottingUnits accepted", spotters.size());
 	}
 	return spotters;
 }
@@ -2474,6 +2937,7 @@ void TileEngine::hit(BattleActionAttack attack, Position center, int power, cons
 			{
 				_save->addDestroyedObjective();
 			}
+			updateTerrainVoxels(tile);
 		}
 	}
 	else if (part == V_UNIT)
@@ -2537,13 +3001,12 @@ void TileEngine::hit(BattleActionAttack attack, Position center, int power, cons
  */
 void TileEngine::explode(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, int maxRadius, bool rangeAtack)
 {
+	Profiler::Scope profile("TileEngine::explode");
 	const Position centetTile = center.toTile();
 	int hitSide = 0;
 	int diagonalWall = 0;
 	int power_;
-	std::map<Tile*, int> tilesAffected;
 	std::vector<BattleItem*> toRemove;
-	std::pair<std::map<Tile*, int>::iterator, bool> ret;
 
 	if (type->FireBlastCalc)
 	{
@@ -2576,149 +3039,186 @@ void TileEngine::explode(BattleActionAttack attack, Position center, int power,
 			hitSide = (center.x % 16 + center.y % 16 - 15) > 0 ? 1 : -1;
 	}
 
-	for (int fi = -90; fi <= 90; fi += 5)
+	// rays longer than the map diagonal have left the map anyway
+	const int mapLength = (int)ceil(sqrt((double)(_save->getMapSizeX() * _save->getMapSizeX() + _save->getMapSizeY() * _save->getMapSizeY() + _save->getMapSizeZ() * _save->getMapSizeZ()))) + 1;
+	const int length = std::max(std::min(maxRadius, mapLength), 0);
+	if (!_blastTemplate || _blastTemplate->getLength() < length)
 	{
-		// raytrace every 3 degrees makes sure we cover all tiles in a circle.
-		for (int te = 0; te <= 360; te += 3)
-		{
-			double cos_te = cos(Deg2Rad(te));
-			double sin_te = sin(Deg2Rad(te));
-			double sin_fi = sin(Deg2Rad(fi));
-			double cos_fi = cos(Deg2Rad(fi));
+		_blastTemplate.reset(new BlastTemplate(length));
+	}
+
+	// the rays can't go further than their length from the center, so the
+	// damage of the tiles and the blockage between them fit in flat arrays
+	const Position boxMin = Position(std::max(centetTile.x - length, 0), std::max(centetTile.y - length, 0), 0);
+	const Position boxMax = Position(std::min(centetTile.x + length, _save->getMapSizeX() - 1), std::min(centetTile.y + length, _save->getMapSizeY() - 1), _save->getMapSizeZ() - 1);
+	const int boxX = boxMax.x - boxMin.x + 1;
+	const int boxY = boxMax.y - boxMin.y + 1;
+	const int boxZ = boxMax.z - boxMin.z + 1;
+	auto boxIndex = [&](Position pos)
+	{
+		return ((pos.z - boxMin.z) * boxY + (pos.y - boxMin.y)) * boxX + (pos.x - boxMin.x);
+	};
+	// damage to the tile parts, -1 for tiles the explosion didn't reach
+	std::vector<int> tilesAffected(boxX * boxY * boxZ, -1);
+	// blockage from each tile to its 27 neighbours, INT_MIN when not known yet
+	std::vector<int> blockages(tilesAffected.size() * 27, INT_MIN);
 
-			origin = _save->getTile(centetTile);
-			dest = origin;
-			double l = 0;
-			int tileX, tileY, tileZ;
-			power_ = power;
-			while (power_ > 0 && l <= maxRadius)
+	for (size_t ray = 0; ray < _blastTemplate->getRayCount(); ++ray)
+	{
+		const int te = _blastTemplate->getAngle(ray);
+		origin = _save->getTile(centetTile);
+		dest = origin;
+		int l = 0;
+		power_ = power;
+		while (power_ > 0 && l <= maxRadius)
+		{
+			if (power_ > 0)
 			{
-				if (power_ > 0)
+				int &tileAffected = tilesAffected[boxIndex(dest->getPosition())]; // check if we had this tile already affected
+				const bool firstHit = tileAffected < 0;
+				if (firstHit)
+				{
+					tileAffected = 0;
+				}
+
+				const int tileDmg = type->getTileFinalDamage(power_);
+				if (tileDmg > tileAffected)
+				{
+					tileAffected = tileDmg;
+				}
+				if (firstHit)
 				{
-					ret = tilesAffected.insert(std::make_pair(dest, 0)); // check if we had this tile already affected
+					const int damage = type->getRandomDamage(power_);
+					BattleUnit *bu = dest->getOverlappingUnit(_save);
 
-					const int tileDmg = type->getTileFinalDamage(power_);
-					if (tileDmg > ret.first->second)
+					toRemove.clear();
+					if (bu)
 					{
-						ret.first->second = tileDmg;
-					}
-					if (ret.second)
-					{
-						const int damage = type->getRandomDamage(power_);
-						BattleUnit *bu = dest->getOverlappingUnit(_save);
-
-						toRemove.clear();
-						if (bu)
+						if (Position::distance2d(dest->getPosition(), centetTile) < 2)
 						{
-							if (Position::distance2d(dest->getPosition(), centetTile) < 2)
-							{
-								// ground zero effect is in effect
-								hitUnit(attack, bu, Position(0, 0, 0), damage, type, rangeAtack);
-							}
-							else
-							{
-								// directional damage relative to explosion position.
-								// units above the explosion will be hit in the legs, units lateral to or below will be hit in the torso
-								hitUnit(attack, bu, centetTile + Position(0, 0, 5) - dest->getPosition(), damage, type, rangeAtack);
-							}
+							// ground zero effect is in effect
+							hitUnit(attack, bu, Position(0, 0, 0), damage, type, rangeAtack);
+						}
+						else
+						{
+							// directional damage relative to explosion position.
+							// units above the explosion will be hit in the legs, units lateral to or below will be hit in the torso
+							hitUnit(attack, bu, centetTile + Position(0, 0, 5) - dest->getPosition(), damage, type, rangeAtack);
+						}
 
-							// Affect all items and units in inventory
-							const int itemDamage = bu->getOverKillDamage();
-							if (itemDamage > 0)
+						// Affect all items and units in inventory
+						const int itemDamage = bu->getOverKillDamage();
+						if (itemDamage > 0)
+						{
+							for (std::vector<BattleItem*>::iterator it = bu->getInventory()->begin(); it != bu->getInventory()->end(); ++it)
 							{
-								for (std::vector<BattleItem*>::iterator it = bu->getInventory()->begin(); it != bu->getInventory()->end(); ++it)
+								if (!hitUnit(attack, (*it)->getUnit(), Position(0, 0, 0), itemDamage, type, rangeAtack) && type->getItemFinalDamage(itemDamage) > (*it)->getRules()->getArmor())
 								{
-									if (!hitUnit(attack, (*it)->getUnit(), Position(0, 0, 0), itemDamage, type, rangeAtack) && type->getItemFinalDamage(itemDamage) > (*it)->getRules()->getArmor())
-									{
-										toRemove.push_back(*it);
-									}
+									toRemove.push_back(*it);
 								}
 							}
 						}
-						// Affect all items and units on ground
-						for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); ++it)
-						{
-							if (!hitUnit(attack, (*it)->getUnit(), Position(0, 0, 0), damage, type) && type->getItemFinalDamage(damage) > (*it)->getRules()->getArmor())
-							{
-								toRemove.push_back(*it);
-							}
-						}
-						for (std::vector<BattleItem*>::iterator it = toRemove.begin(); it != toRemove.end(); ++it)
+					}
+					// Affect all items and units on ground
+					for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); ++it)
+					{
+						if (!hitUnit(attack, (*it)->getUnit(), Position(0, 0, 0), damage, type) && type->getItemFinalDamage(damage) > (*it)->getRules()->getArmor())
 						{
-							_save->removeItem((*it));
+							toRemove.push_back(*it);
 						}
-
-						hitTile(dest, damage, type);
 					}
+					for (std::vector<BattleItem*>::iterator it = toRemove.begin(); it != toRemove.end(); ++it)
+					{
+						_save->removeItem((*it));
+					}
+
+					hitTile(dest, damage, type);
 				}
+			}
 
-				l += 1.0;
+			++l;
+			// past the length of the template the ray is past the radius or out of the map
+			if (l > length) break;
 
-				tileX = int(floor(centetTile.x + 0.5 + l * sin_te * cos_fi));
-				tileY = int(floor(centetTile.y + 0.5 + l * cos_te * cos_fi));
-				tileZ = int(floor(centetTile.z + 0.5 + l * sin_fi));
+			const Position next = _blastTemplate->getStep(ray, l, centetTile);
+			origin = dest;
+			dest = _save->getTile(next);
 
-				origin = dest;
-				dest = _save->getTile(Position(tileX, tileY, tileZ));
+			if (!dest) break; // out of map!
 
-				if (!dest) break; // out of map!
+			const Position move = next - origin->getPosition();
 
-				// blockage by terrain is deducted from the explosion power
-				power_ -= type->RadiusReduction; // explosive damage decreases by 10 per tile
-				if (origin->getPosition().z != tileZ)
-					power_ -= vertdec; //3d explosion factor
+			// blockage by terrain is deducted from the explosion power
+			power_ -= type->RadiusReduction; // explosive damage decreases by 10 per tile
+			if (move.z != 0)
+				power_ -= vertdec; //3d explosion factor
 
-				if (type->FireBlastCalc)
+			if (type->FireBlastCalc)
+			{
+				int dir;
+				Pathfinding::vectorToDirection(origin->getPosition() - dest->getPosition(), dir);
+				if (dir != -1 && dir %2) power_ -= 0.5f * type->RadiusReduction; // diagonal movement costs an extra 50% for fire.
+			}
+			if ( l > 1)
+			{
+				// the terrain doesn't change until the rays are done, so the blockage between two tiles is always the same
+				int &block = blockages[boxIndex(origin->getPosition()) * 27 + (move.x + 1) + (move.y + 1) * 3 + (move.z + 1) * 9];
+				if (block == INT_MIN)
 				{
-					int dir;
-					Pathfinding::vectorToDirection(origin->getPosition() - dest->getPosition(), dir);
-					if (dir != -1 && dir %2) power_ -= 0.5f * type->RadiusReduction; // diagonal movement costs an extra 50% for fire.
+					block = verticalBlockage(origin, dest, type->ResistType, false) * 2;
+					block += horizontalBlockage(origin, dest, type->ResistType, false) * 2;
 				}
-				if (l > 0.5) {
-					if ( l > 1.5)
-					{
-						power_ -= verticalBlockage(origin, dest, type->ResistType, false) * 2;
-						power_ -= horizontalBlockage(origin, dest, type->ResistType, false) * 2;
-					}
-					else //tricky bigwall deflection /Volutar
-					{
-						bool skipObject = diagonalWall == 0;
-						if (diagonalWall == Pathfinding::BIGWALLNESW) // --
-						{
-							if (hitSide<0 && te >= 135 && te < 315)
-								skipObject = true;
-							if (hitSide>0 && ( te < 135 || te > 315))
-								skipObject = true;
-						}
-						if (diagonalWall == Pathfinding::BIGWALLNWSE) // |
-						{
-							if (hitSide>0 && te >= 45 && te < 225)
-								skipObject = true;
-							if (hitSide<0 && ( te < 45 || te > 225))
-								skipObject = true;
-						}
-						power_ -= verticalBlockage(origin, dest, type->ResistType, skipObject) * 2;
-						power_ -= horizontalBlockage(origin, dest, type->ResistType, skipObject) * 2;
-
-					}
+				power_ -= block;
+			}
+			else //tricky bigwall deflection /Volutar
+			{
+				bool skipObject = diagonalWall == 0;
+				if (diagonalWall == Pathfinding::BIGWALLNESW) // --
+				{
+					if (hitSide<0 && te >= 135 && te < 315)
+						skipObject = true;
+					if (hitSide>0 && ( te < 135 || te > 315))
+						skipObject = true;
+				}
+				if (diagonalWall == Pathfinding::BIGWALLNWSE) // |
+				{
+					if (hitSide>0 && te >= 45 && te < 225)
+						skipObject = true;
+					if (hitSide<0 && ( te < 45 || te > 225))
+						skipObject = true;
 				}
+				power_ -= verticalBlockage(origin, dest, type->ResistType, skipObject) * 2;
+				power_ -= horizontalBlockage(origin, dest, type->ResistType, skipObject) * 2;
 			}
 		}
 	}
 
-	// now detonate the tiles affected by explosion
+	// now detonate the tiles affected by explosion, in map order
 	if (type->ToTile > 0.0f)
 	{
-		for (std::map<Tile*, int>::iterator i = tilesAffected.begin(); i != tilesAffected.end(); ++i)
+		for (int z = boxMin.z; z <= boxMax.z; ++z)
 		{
-			if (detonate(i->first, i->second))
+			for (int y = boxMin.y; y <= boxMax.y; ++y)
 			{
-				_save->addDestroyedObjective();
+				for (int x = boxMin.x; x <= boxMax.x; ++x)
+				{
+					const Position pos = Position(x, y, z);
+					const int tileAffected = tilesAffected[boxIndex(pos)];
+					if (tileAffected < 0)
+					{
+						continue;
+					}
+					Tile *tile = _save->getTile(pos);
+					if (detonate(tile, tileAffected))
+					{
+						_save->addDestroyedObjective();
+					}
+					applyGravity(tile);
+					Tile *j = _save->getTile(pos + Position(0,0,1));
+					if (j)
+						applyGravity(j);
+				}
 			}
-			applyGravity(i->first);
-			Tile *j = _save->getTile(i->first->getPosition() + Position(0,0,1));
-			if (j)
-				applyGravity(j);
 		}
 	}
 	calculateLighting(LL_AMBIENT, centetTile, maxRadius + 1, true); // roofs could have been destroyed and fires could have been started
@@ -2811,6 +3311,7 @@ bool TileEngine::detonate(Tile* tile, int explosive)
 				currentpart2 = currentpart;
 			if (tiles[i]->destroy(currentpart, _save->getObjectiveType()))
 				objective = true;
+			updateTerrainVoxels(tiles[i]);
 			currentpart =  currentpart2;
 			if (tiles[i]->getMapData(currentpart)) // take new values
 			{
@@ -2867,6 +3368,24 @@ Tile *TileEngine::checkForTerrainExplosions()
 	return 0;
 }
 
+/**
+ * Gets all the tiles waiting for a chained explosion, in map order.
+ * Lets many chained explosions go off as one wave, instead of looking
+ * through the whole map again after each of them.
+ * @param tiles Returns the tiles.
+ */
+void TileEngine::getTerrainExplosions(std::vector<Tile*> &tiles)
+{
+	tiles.clear();
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		if (_save->getTile(i)->getExplosive())
+		{
+			tiles.push_back(_save->getTile(i));
+		}
+	}
+}
+
 /**
  * Calculates the amount of power that is blocked going from one tile to another on a different level.
  * @param startTile The tile where the power starts.
@@ -3358,6 +3877,10 @@ int TileEngine::unitOpensDoor(BattleUnit *unit, bool rClick, int dir)
 				if (tile)
 				{
 					door = tile->openDoor(i->second, unit, _save->getBattleGame()->getReservedAction(), rClick);
+					if (door == 0 || door == 1)
+					{
+						updateTerrainVoxels(tile);
+					}
 					if (door != -1)
 					{
 						part = i->second;
@@ -3434,6 +3957,7 @@ std::pair<int, Position> TileEngine::checkAdjacentDoors(Position pos, TilePart p
 			int doorAdj = tile->openDoor(part);
 			if (doorAdj == 1) //only expecting ufo doors
 			{
+				updateTerrainVoxels(tile);
 				adjacentDoorsOpened++;
 				doorOffset++;
 			}
@@ -3449,6 +3973,7 @@ std::pair<int, Position> TileEngine::checkAdjacentDoors(Position pos, TilePart p
 			int doorAdj = tile->openDoor(part);
 			if (doorAdj == 1)
 			{
+				updateTerrainVoxels(tile);
 				adjacentDoorsOpened++;
 				doorOffset--;
 			}
@@ -3482,7 +4007,11 @@ int TileEngine::closeUfoDoors()
 				continue;
 			}
 		}
-		doorsclosed += _save->getTile(i)->closeUfoDoor();
+		if (_save->getTile(i)->closeUfoDoor())
+		{
+			updateTerrainVoxels(_save->getTile(i));
+			++doorsclosed;
+		}
 	}
 
 	return doorsclosed;
@@ -3577,6 +4106,90 @@ int TileEngine::calculateLineTile(Position origin, Position target, std::vector<
  * @return the objectnumber(0-3) or unit(4) or out of map (5) or -1(hit nothing).
  */
 VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, BattleUnit *excludeAllBut, bool onlyVisible)
+{
+	Profiler::count("TileEngine::calculateLineVoxel");
+	LineTrace trace;
+	return traceLineVoxel(origin, target, storeTrajectory, trajectory, excludeUnit, excludeAllBut, onlyVisible, trace);
+}
+
+/**
+ * Calculates the line trajectories from one origin to many targets,
+ * like all the scan voxels of a unit. The lines share what they learn
+ * about the clear tiles around the origin, and give the same results
+ * as calling calculateLineVoxel for each target.
+ * @param origin Origin in voxel.
+ * @param targets Targets in voxel.
+ * @param results Returns what each line hit.
+ * @param impacts Returns the position of impact of each line, or invalid if it hit nothing.
+ * @param excludeUnit Excludes this unit in the collision detection.
+ * @param excludeAllBut [Optional] The only unit to be considered for ray hits.
+ */
+void TileEngine::calculateLineVoxels(Position origin, const std::vector<Position> &targets, std::vector<VoxelType> &results, std::vector<Position> &impacts, BattleUnit *excludeUnit, BattleUnit *excludeAllBut)
+{
+	Profiler::count("TileEngine::calculateLineVoxels", targets.size());
+	results.resize(targets.size());
+	impacts.resize(targets.size());
+	LineTrace trace;
+	std::vector<Position> impact;
+	for (size_t i = 0; i < targets.size(); ++i)
+	{
+		impact.clear();
+		results[i] = traceLineVoxel(origin, targets[i], false, &impact, excludeUnit, excludeAllBut, false, trace);
+		impacts[i] = impact.empty() ? invalid : impact.front();
+	}
+}
+
+/**
+ * Checks if a line can't hit anything in a tile, because the tile has
+ * no solid voxel and no unit that could be hit, so every voxel check
+ * in it would come out empty.
+ * @param pos Position of the tile.
+ * @param excludeUnit Unit the line ignores.
+ * @param excludeAllUnits Does the line ignore all the units?
+ * @param onlyVisible Does the line ignore the units not visible?
+ * @param excludeAllBut If set, the only unit the line can hit.
+ * @return True if the tile is clear.
+ */
+bool TileEngine::isTileClear(Position pos, BattleUnit *excludeUnit, bool excludeAllUnits, bool onlyVisible, BattleUnit *excludeAllBut)
+{
+	Tile *tile = _save->getTile(pos);
+	if (!tile)
+	{
+		return false;
+	}
+	Tile *tileBelow = _save->getBelowTile(tile);
+	if (!tile->isVoid() && _voxelGrid->getTile(_save->getTileIndex(pos)) != VoxelGrid::BLOCK_EMPTY)
+	{
+		return false;
+	}
+	if (excludeAllUnits)
+	{
+		return true;
+	}
+	// the overlapping unit is either the one on the tile or the one below
+	BattleUnit *unit = tile->getUnit();
+	if (!unit && tileBelow)
+	{
+		unit = tileBelow->getUnit();
+	}
+	return !unit || unit->isOut() || unit == excludeUnit || (excludeAllBut && unit != excludeAllBut) || (onlyVisible && !unit->getVisible());
+}
+
+/**
+ * Calculates a line trajectory, the same as calculateLineVoxel. Voxels in
+ * clear tiles are not checked, and when only the impact is needed the line
+ * jumps over them to the next tile.
+ * @param origin Origin in voxel.
+ * @param target Target in voxel.
+ * @param storeTrajectory True will store the whole trajectory - otherwise it just stores the last position.
+ * @param trajectory A vector of positions in which the trajectory is stored.
+ * @param excludeUnit Excludes this unit in the collision detection.
+ * @param excludeAllBut The only unit to be considered for ray hits.
+ * @param onlyVisible Skip invisible units?
+ * @param trace Clear tiles found so far.
+ * @return the objectnumber(0-3) or unit(4) or out of map (5) or -1(hit nothing).
+ */
+VoxelType TileEngine::traceLineVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, BattleUnit *excludeAllBut, bool onlyVisible, LineTrace &trace)
 {
 	VoxelType result;
 	bool excludeAllUnits = false;
@@ -3584,6 +4197,34 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
 	{
 		excludeAllUnits = true; // don't start unit spotting before pre-game inventory stuff (large units on the craftInventory tile will cause a crash if they're "spotted")
 	}
+	const bool skip = !(storeTrajectory && trajectory);
+
+	auto isClear = [&](Position point)
+	{
+		if (_referenceTracing || point.x < 0 || point.y < 0 || point.z < 0)
+		{
+			return false;
+		}
+		if (point.x >= trace.clearMin.x && point.x <= trace.clearMax.x &&
+			point.y >= trace.clearMin.y && point.y <= trace.clearMax.y &&
+			point.z >= trace.clearMin.z && point.z <= trace.clearMax.z)
+		{
+			return true;
+		}
+		Position pos = point.toTile();
+		if (pos == trace.blockedTile)
+		{
+			return false;
+		}
+		if (isTileClear(pos, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut))
+		{
+			trace.clearMin = pos.toVoxel();
+			trace.clearMax = trace.clearMin + voxelTileSize - Position(1, 1, 1);
+			return true;
+		}
+		trace.blockedTile = pos;
+		return false;
+	};
 
 	bool hit = calculateLineHitHelper(origin, target,
 		[&](Position point)
@@ -3593,6 +4234,10 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
 				trajectory->push_back(point);
 			}
 
+			if (isClear(point))
+			{
+				return false;
+			}
 			result = voxelCheck(point, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut);
 			if (result != V_EMPTY)
 			{
@@ -3606,6 +4251,10 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
 		},
 		[&](Position point)
 		{
+			if (isClear(point))
+			{
+				return false;
+			}
 			//check for xy diagonal intermediate voxel step
 			result = voxelCheck(point, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut);
 			if (result != V_EMPTY)
@@ -3617,6 +4266,18 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
 				return true;
 			}
 			return false;
+		},
+		[&](Position point, Position &boxMin, Position &boxMax)
+		{
+			// the whole trajectory needs every point
+			if (!skip || !isClear(point))
+			{
+				return false;
+			}
+			Profiler::count("TileEngine::traceLineVoxel skips");
+			boxMin = trace.clearMin;
+			boxMax = trace.clearMax;
+			return true;
 		}
 	);
 	if (hit)
@@ -3639,6 +4300,7 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
  */
 int TileEngine::calculateParabolaVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, double curvature, const Position delta)
 {
+	Profiler::count("TileEngine::calculateParabolaVoxel");
 	double ro = Position::distance(target, origin);
 
 	if (AreSame(ro, 0.0)) return V_EMPTY;//just in case
@@ -3659,6 +4321,8 @@ int TileEngine::calculateParabolaVoxel(Position origin, Position target, bool st
 	int result = V_EMPTY;
 	Position lastPosition = Position(x,y,z);
 	Position nextPosition = lastPosition;
+	// the segments are only a few voxels long, share the clear tiles between them
+	LineTrace trace;
 
 	if (storeTrajectory && trajectory)
 	{
@@ -3678,12 +4342,12 @@ int TileEngine::calculateParabolaVoxel(Position origin, Position target, bool st
 			//remove end point of previus trajectory part, becasue next one will add this point again
 			trajectory->pop_back();
 		}
-		result = calculateLineVoxel(lastPosition, nextPosition, storeTrajectory, storeTrajectory ? trajectory : nullptr, excludeUnit);
+		result = traceLineVoxel(lastPosition, nextPosition, storeTrajectory, storeTrajectory ? trajectory : nullptr, excludeUnit, 0, false, trace);
 		if (result != V_EMPTY)
 		{
 			if (!storeTrajectory && trajectory)
 			{
-				result = calculateLineVoxel(lastPosition, nextPosition, false, trajectory, excludeUnit); //pick the INSIDE position of impact
+				result = traceLineVoxel(lastPosition, nextPosition, false, trajectory, excludeUnit, 0, false, trace); //pick the INSIDE position of impact
 			}
 			break;
 		}
@@ -3767,10 +4431,12 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 	}
 	Position pos = voxel.toTile();
 	Tile *tile, *tileBelow;
+	Uint16 terrain;
 	if (_cacheTilePos == pos)
 	{
 		tile = _cacheTile;
 		tileBelow = _cacheTileBelow;
+		terrain = _cacheTerrain;
 	}
 	else
 	{
@@ -3780,9 +4446,11 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 			return V_OUTOFBOUNDS; //not even cache
 		}
 		tileBelow = _save->getBelowTile(tile);
+		terrain = _voxelGrid->getTile(_save->getTileIndex(pos));
 		_cacheTilePos = pos;
 		_cacheTile = tile;
 		_cacheTileBelow = tileBelow;
+		_cacheTerrain = terrain;
  	}
 
 	if (tile->isVoid() && tile->getUnit() == 0 && (!tileBelow || tileBelow->getUnit() == 0))
@@ -3790,29 +4458,37 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 		return V_EMPTY;
 	}
 
-	if (tile->getMapData(O_FLOOR) && tile->getMapData(O_FLOOR)->isGravLift() && (voxel.z % 24 == 0 || voxel.z % 24 == 1))
+	const Uint16 block = terrain & ~VoxelGrid::FLAG_GRAV_LIFT;
+	if ((terrain & VoxelGrid::FLAG_GRAV_LIFT) || block == VoxelGrid::BLOCK_UNKNOWN)
 	{
-		if ((tile->getPosition().z == 0) || (tileBelow && tileBelow->getMapData(O_FLOOR) && !tileBelow->getMapData(O_FLOOR)->isGravLift()))
+		if (tile->getMapData(O_FLOOR) && tile->getMapData(O_FLOOR)->isGravLift() && (voxel.z % 24 == 0 || voxel.z % 24 == 1))
 		{
-			return V_FLOOR;
+			if ((tile->getPosition().z == 0) || (tileBelow && tileBelow->getMapData(O_FLOOR) && !tileBelow->getMapData(O_FLOOR)->isGravLift()))
+			{
+				return V_FLOOR;
+			}
 		}
 	}
 
 	// first we check terrain voxel data, not to allow 2x2 units stick through walls
-	for (int i = V_FLOOR; i <= V_OBJECT; ++i)
+	// the grid tells if any part is solid here, the parts are only checked to know which one it is
+	if (block == VoxelGrid::BLOCK_UNKNOWN || (block != VoxelGrid::BLOCK_EMPTY && _voxelGrid->isSolid(block, voxel)))
 	{
-		TilePart tp = (TilePart)i;
-		MapData *mp = tile->getMapData(tp);
-		if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
-			continue;
-		if (mp != 0)
+		for (int i = V_FLOOR; i <= V_OBJECT; ++i)
 		{
-			int x = 15 - voxel.x%16;
-			int y = voxel.y%16;
-			int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
-			if (_voxelData->at(idx) & (1 << x))
+			TilePart tp = (TilePart)i;
+			MapData *mp = tile->getMapData(tp);
+			if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
+				continue;
+			if (mp != 0)
 			{
-				return (VoxelType)i;
+				int x = 15 - voxel.x%16;
+				int y = voxel.y%16;
+				int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
+				if (_voxelData->at(idx) & (1 << x))
+				{
+					return (VoxelType)i;
+				}
 			}
 		}
 	}
@@ -3864,6 +4540,19 @@ void TileEngine::voxelCheckFlush()
 	_cacheTilePos = invalid;
 	_cacheTile = 0;
 	_cacheTileBelow = 0;
+	_cacheTerrain = VoxelGrid::BLOCK_UNKNOWN;
+}
+
+/**
+ * Updates the voxel grid entry of a tile, must be called
+ * whenever a tile part is destroyed, replaced or a door opens.
+ * @param tile Changed tile.
+ */
+void TileEngine::updateTerrainVoxels(Tile *tile)
+{
+	_voxelGrid->update(tile);
+	voxelCheckFlush();
+	_save->getPathfinding()->invalidateReachable();
 }
 
 /**
@@ -4902,13 +5591,16 @@ bool TileEngine::validateThrow(BattleAction &action, Position originVoxel, Posit
  */
 void TileEngine::recalculateFOV()
 {
+	Profiler::Scope profile("TileEngine::recalculateFOV");
+	std::vector<BattleUnit*> units;
 	for (std::vector<BattleUnit*>::iterator bu = _save->getUnits()->begin(); bu != _save->getUnits()->end(); ++bu)
 	{
 		if ((*bu)->getTile() != 0)
 		{
-			calculateFOV(*bu);
+			units.push_back(*bu);
 		}
 	}
+	calculateFOV(units, invalid, 0, true, true);
 }
 
 /**
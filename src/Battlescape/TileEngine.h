@@ -17,6 +17,9 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <functional>
+#include <map>
+#include <memory>
 #include <vector>
 #include "Position.h"
 #include "BattlescapeGame.h"
@@ -32,6 +35,8 @@ class BattleUnit;
 class BattleItem;
 class Tile;
 class RuleSkill;
+class VoxelGrid;
+class BlastTemplate;
 struct BattleAction;
 template<typename Tag, typename DataType> struct AreaSubset;
 
@@ -90,16 +95,42 @@ private:
 		double reactionScore;
 		double reactionReduction;
 	};
+	/**
+	 * Helper class storing what a unit sees, before it is applied to the unit and the tiles.
+	 */
+	struct FieldOfView
+	{
+		bool clearTiles = false;
+		bool clearUnits = false;
+		/// Newly traced tiles, in the order they were reached.
+		std::vector<Tile*> tiles;
+		/// Units checked, with true when seen and false when lost from view.
+		std::vector<std::pair<BattleUnit*, bool> > units;
+	};
+	/**
+	 * A light of the items or units layer, with the light it gives to each tile.
+	 */
+	struct LightSource
+	{
+		int key = 0;
+		Position center;
+		int power = 0;
+		/// Tile index and light, for every tile the light reaches.
+		std::vector<std::pair<int, Uint8> > tiles;
+	};
 
 	SavedBattleGame *_save;
 	std::vector<Uint16> *_voxelData;
-	std::vector<VisibilityBlockCache> _blockVisibility;
+	std::vector<VisibilityBlockCache> _blockVisibilityData;
+	/// Blockage cache of the battle, owned by the main engine and only read by the workers.
+	const std::vector<VisibilityBlockCache> &_blockVisibility;
 	RuleInventory *_inventorySlotGround;
 	constexpr static int heightFromCenter[11] = {0,-2,+2,-4,+4,-6,+6,-8,+8,-12,+12};
 	bool _personalLighting;
 	Tile *_cacheTile;
 	Tile *_cacheTileBelow;
 	Position _cacheTilePos;
+	Uint16 _cacheTerrain;
 	const int _maxViewDistance;        // 20 tiles by default
 	const int _maxViewDistanceSq;      // 20 * 20
 	const int _maxVoxelViewDistance;   // maxViewDistance * 16
@@ -107,12 +138,37 @@ private:
 	const int _maxStaticLightDistance;
 	const int _maxDynamicLightDistance;
 	const int _enhancedLighting;
+	std::shared_ptr<VoxelGrid> _voxelGrid;
+	std::unique_ptr<BlastTemplate> _blastTemplate;
 	Position _eventVisibilitySectorL, _eventVisibilitySectorR, _eventVisibilityObserverPos;
 	std::vector<BattleUnit*> _movingUnitPrev;
 	BattleUnit* _movingUnit = nullptr;
+	std::vector<std::unique_ptr<TileEngine> > _workers;
+	std::map<int, LightSource> _lightSources[2];
+	bool _lightSourcesValid = false;
+	std::vector<char> _lightDirty;
+	bool _referenceTracing = false;
+
+	/// Part of the map known to be clear while tracing lines, shared by the lines of a batch.
+	struct LineTrace
+	{
+		Position clearMin = { 1, 1, 1 }, clearMax = { 0, 0, 0 };
+		Position blockedTile = { -1, -1, -1 };
+	};
+
+	/// Creates an engine for a worker thread.
+	explicit TileEngine(const TileEngine *main);
+	/// Gets the engines used by the worker threads, up to date with this one.
+	void prepareWorkers(int count);
+	/// Checks if a line can't hit anything in a tile.
+	bool isTileClear(Position pos, BattleUnit *excludeUnit, bool excludeAllUnits, bool onlyVisible, BattleUnit *excludeAllBut);
+	/// Calculates a line trajectory in voxel space, skipping the clear tiles.
+	VoxelType traceLineVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, BattleUnit *excludeAllBut, bool onlyVisible, LineTrace &trace);
 
+	/// Clears the light of an area.
+	void resetLight(MapSubset gs, LightLayers layer);
 	/// Add light source.
-	void addLight(MapSubset gs, Position center, int power, LightLayers layer);
+	void addLight(MapSubset gs, Position center, int power, LightLayers layer, std::vector<std::pair<int, Uint8> > *footprint = 0);
 	/// Calculate blockage amount.
 	int blockage(Tile *tile, const TilePart part, ItemDamageType type, int direction = -1, bool checkingFromOrigin = false);
 	/// Get max distance that fire light can reach.
@@ -133,6 +189,17 @@ private:
 	bool setupEventVisibilitySector(const Position &observerPos, const Position &eventPos, const int &eventRadius);
 	inline bool inEventVisibilitySector(const Position &toCheck) const;
 
+	/// Traces the tiles a unit can see, without changing anything.
+	void collectTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, FieldOfView &fov);
+	/// Checks which units a unit can see, without changing anything.
+	void collectUnitsInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, FieldOfView &fov);
+	/// Marks the traced tiles as seen by the unit.
+	void applyTilesInFOV(BattleUnit *unit, const FieldOfView &fov);
+	/// Updates the visible units of the unit.
+	bool applyUnitsInFOV(BattleUnit *unit, const FieldOfView &fov);
+	/// Calculates the field of view of several units at once.
+	void calculateFOV(const std::vector<BattleUnit*> &units, Position eventPos, int eventRadius, bool updateTiles, bool appendToTileVisibility);
+
 	/// Calculates sun shading of the whole map.
 	void calculateSunShading(MapSubset gs);
 	/// Recalculates lighting of the battlescape for terrain.
@@ -141,6 +208,12 @@ private:
 	void calculateTerrainItems(MapSubset gs);
 	/// Recalculates lighting of the battlescape for units.
 	void calculateUnitLighting(MapSubset gs);
+	/// Gets the light sources of the items or units layer.
+	void getDynamicLights(LightLayers layer, MapSubset gs, std::vector<LightSource> &sources);
+	/// Updates the items or units layer for the light sources that changed.
+	void updateDynamicLights(LightLayers layer, MapSubset gs);
+	/// Calculates the items and units layers of the whole map from scratch.
+	void rebuildDynamicLights();
 
 	/// Checks validity of a snap shot to this position.
 	ReactionScore determineReactionType(BattleUnit *unit, BattleUnit *target);
@@ -163,6 +236,8 @@ public:
 	bool calculateFOV(BattleUnit *unit, bool doTileRecalc = true, bool doUnitRecalc = true);
 	/// Calculates the field of view within range of a certain position.
 	void calculateFOV(Position position, int eventRadius = -1, const bool updateTiles = true, const bool appendToTileVisibility = false);
+	/// Runs read-only checks for many items at once, each thread using its own engine.
+	void forEachParallel(size_t count, const std::function<void(size_t index, TileEngine *engine)> &func);
 	/// Checks reaction fire.
 	bool checkReactionFire(BattleUnit *unit, const BattleAction &originalAction);
 	/// Recalculate all lighting in some area.
@@ -179,6 +254,8 @@ public:
 	void explode(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, int maxRadius, bool rangeAtack = true);
 	/// Checks if a destroyed tile starts an explosion.
 	Tile *checkForTerrainExplosions();
+	/// Gets all the tiles waiting for a chained explosion.
+	void getTerrainExplosions(std::vector<Tile*> &tiles);
 	/// Unit opens door?
 	int unitOpensDoor(BattleUnit *unit, bool rClick = false, int dir = -1);
 	/// Closes ufo doors.
@@ -187,6 +264,10 @@ public:
 	int calculateLineTile(Position origin, Position target, std::vector<Position> &trajectory);
 	/// Calculates a line trajectory in voxel space.
 	VoxelType calculateLineVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, BattleUnit *excludeAllBut = 0, bool onlyVisible = false);
+	/// Calculates the line trajectories from one origin to many targets.
+	void calculateLineVoxels(Position origin, const std::vector<Position> &targets, std::vector<VoxelType> &results, std::vector<Position> &impacts, BattleUnit *excludeUnit, BattleUnit *excludeAllBut = 0);
+	/// Makes the lines check every voxel, to compare with the tile skipping.
+	void setReferenceTracing(bool reference) { _referenceTracing = reference; }
 	/// Calculates a parabola trajectory.
 	int calculateParabolaVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, double curvature, const Position delta);
 	/// Gets the origin voxel of a unit's eyesight.
@@ -257,6 +338,8 @@ public:
 	VoxelType voxelCheck(Position voxel, BattleUnit *excludeUnit, bool excludeAllUnits = false, bool onlyVisible = false, BattleUnit *excludeAllBut = 0);
 	/// Flushes cache of voxel check
 	void voxelCheckFlush();
+	/// Updates the terrain voxels of a tile after its parts changed.
+	void updateTerrainVoxels(Tile *tile);
 	/// Blows this tile up.
 	bool detonate(Tile* tile, int power);
 	/// Validates a throwing action.
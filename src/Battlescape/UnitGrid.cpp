@@ -0,0 +1,152 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "UnitGrid.h"
+#include <algorithm>
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Tile.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a grid covering the map of a battle,
+ * it gets filled on the first query.
+ * @param save Pointer to the battle.
+ */
+UnitGrid::UnitGrid(SavedBattleGame *save) : _save(save), _valid(false)
+{
+	_width = (_save->getMapSizeX() + CELL_SIZE - 1) / CELL_SIZE;
+	_length = (_save->getMapSizeY() + CELL_SIZE - 1) / CELL_SIZE;
+	// the last cell holds the units without a tile
+	_cells.resize(_width * _length + 1);
+}
+
+/**
+ * Cleans up the grid.
+ */
+UnitGrid::~UnitGrid()
+{
+
+}
+
+/**
+ * Gets the cell of the tile a unit stands on.
+ * @param unit Pointer to the unit.
+ * @return Cell index.
+ */
+int UnitGrid::getCell(const BattleUnit *unit) const
+{
+	const Tile *tile = unit->getTile();
+	if (tile == 0)
+	{
+		return _width * _length;
+	}
+	Position pos = tile->getPosition();
+	return (pos.y / CELL_SIZE) * _width + pos.x / CELL_SIZE;
+}
+
+/**
+ * Fills the grid with all the units of the battle,
+ * remembering their order in the unit list.
+ */
+void UnitGrid::rebuild()
+{
+	for (std::vector<std::vector<BattleUnit*> >::iterator i = _cells.begin(); i != _cells.end(); ++i)
+	{
+		i->clear();
+	}
+	_units.clear();
+	std::vector<BattleUnit*> *units = _save->getUnits();
+	for (size_t i = 0; i < units->size(); ++i)
+	{
+		BattleUnit *unit = (*units)[i];
+		int cell = getCell(unit);
+		_cells[cell].push_back(unit);
+		_units[unit] = std::make_pair(cell, (int)i);
+	}
+	_valid = true;
+}
+
+/**
+ * Moves a unit to the cell of the tile it's now on.
+ * Units that aren't in the battle list yet get added on the next rebuild.
+ * @param unit Pointer to the unit.
+ */
+void UnitGrid::update(const BattleUnit *unit)
+{
+	if (!_valid)
+	{
+		return;
+	}
+	std::unordered_map<const BattleUnit*, std::pair<int, int> >::iterator i = _units.find(unit);
+	if (i == _units.end())
+	{
+		return;
+	}
+	int cell = getCell(unit);
+	if (cell == i->second.first)
+	{
+		return;
+	}
+	std::vector<BattleUnit*> &from = _cells[i->second.first];
+	std::vector<BattleUnit*>::iterator entry = std::find(from.begin(), from.end(), unit);
+	_cells[cell].push_back(*entry);
+	from.erase(entry);
+	i->second.first = cell;
+}
+
+/**
+ * Gets all the units that can be within a 2D distance of a position,
+ * plus all the units without a tile, in the same order as the unit list.
+ * The caller still needs to check the actual distance.
+ * @param pos Position to look around.
+ * @param distance Distance in tiles.
+ * @param units Vector to fill with the units.
+ */
+void UnitGrid::getUnitsNear(Position pos, int distance, std::vector<BattleUnit*> &units)
+{
+	if (!_valid)
+	{
+		rebuild();
+	}
+
+	units.clear();
+	// a unit's tile can be a step ahead of its position while it walks
+	distance += 1;
+	int minX = std::max(0, (pos.x - distance) / CELL_SIZE), maxX = std::min(_width - 1, (pos.x + distance) / CELL_SIZE);
+	int minY = std::max(0, (pos.y - distance) / CELL_SIZE), maxY = std::min(_length - 1, (pos.y + distance) / CELL_SIZE);
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			const std::vector<BattleUnit*> &cell = _cells[y * _width + x];
+			units.insert(units.end(), cell.begin(), cell.end());
+		}
+	}
+	const std::vector<BattleUnit*> &offMap = _cells[_width * _length];
+	units.insert(units.end(), offMap.begin(), offMap.end());
+
+	std::sort(units.begin(), units.end(), [&](const BattleUnit *a, const BattleUnit *b)
+	{
+		return _units.at(a).second < _units.at(b).second;
+	});
+}
+
+}
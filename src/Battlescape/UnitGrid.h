@@ -0,0 +1,68 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <unordered_map>
+#include <vector>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class BattleUnit;
+class SavedBattleGame;
+
+/**
+ * Buckets of the battle units by map area, so the units near a spot
+ * can be found without going through the whole list. Each unit goes by
+ * the tile it stands on, units without one (off the map, unconscious,
+ * dead) are kept apart and always returned. The grid follows the units
+ * through BattleUnit::setTile(). Every change to the unit list must be
+ * followed by SavedBattleGame::invalidateUnitGrid(), so the grid gets
+ * rebuilt before the next query.
+ */
+class UnitGrid
+{
+public:
+	/// Size of a grid cell, in tiles.
+	static const int CELL_SIZE = 8;
+private:
+	SavedBattleGame *_save;
+	int _width, _length;
+	std::vector<std::vector<BattleUnit*> > _cells;
+	std::unordered_map<const BattleUnit*, std::pair<int, int> > _units;
+	bool _valid;
+
+	/// Gets the cell a unit belongs to.
+	int getCell(const BattleUnit *unit) const;
+	/// Puts all the units of the battle in the grid.
+	void rebuild();
+public:
+	/// Creates an empty grid for a battle.
+	UnitGrid(SavedBattleGame *save);
+	/// Cleans up the grid.
+	~UnitGrid();
+	/// Marks the grid to be rebuilt, after units were added or removed.
+	void invalidate() { _valid = false; }
+	/// Moves a unit to the cell of its current tile.
+	void update(const BattleUnit *unit);
+	/// Gets the units that may be near a position.
+	void getUnitsNear(Position pos, int distance, std::vector<BattleUnit*> &units);
+};
+
+}
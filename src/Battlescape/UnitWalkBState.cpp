@@ -123,12 +123,16 @@ void UnitWalkBState::think()
 
 	if (_unit->getStatus() == STATUS_WALKING || _unit->getStatus() == STATUS_FLYING)
 	{
+		bool stepOnly = false;
 		if ((_parent->getSave()->getTile(_unit->getDestination())->getUnit() == 0) || // next tile must be not occupied
 			(_parent->getSave()->getTile(_unit->getDestination())->getUnit() == _unit))
 		{
 			bool onScreenBoundary = (_unit->getVisible() && _parent->getMap()->getCamera()->isOnScreen(_unit->getPosition(), true, size, true));
+			Position lastPosition = _unit->getPosition();
 			_unit->keepWalking(_parent->getSave(), onScreenBoundary); // advances the phase
 			playMovementSound();
+			// still on the same tile and walking, so nothing else changed
+			stepOnly = _unit->getPosition() == lastPosition && (_unit->getStatus() == STATUS_WALKING || _unit->getStatus() == STATUS_FLYING);
 		}
 		else if (!_falling)
 		{
@@ -233,6 +237,10 @@ void UnitWalkBState::think()
 				_unit->setDirection(dirTemp);
 			}
 		}
+		if (stepOnly)
+		{
+			_parent->setOnlyMovingChanged();
+		}
 	}
 
 	// we are just standing around, shouldn't we be walking?
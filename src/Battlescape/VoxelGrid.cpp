@@ -0,0 +1,111 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "VoxelGrid.h"
+#include "../Mod/MapData.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Tile.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a grid where every tile is unknown, so the voxel checks
+ * use the tile data until the tiles get added.
+ * @param save Pointer to the battle.
+ * @param voxelData List of LOFTs.
+ */
+VoxelGrid::VoxelGrid(SavedBattleGame *save, const std::vector<Uint16> *voxelData) : _save(save), _voxelData(voxelData)
+{
+	clear();
+}
+
+/**
+ * Cleans up the grid.
+ */
+VoxelGrid::~VoxelGrid()
+{
+
+}
+
+/**
+ * Marks all the tiles as unknown and drops all the blocks.
+ * Block 0 always exists and has no solid voxels.
+ */
+void VoxelGrid::clear()
+{
+	_tiles.assign(_save->getMapSizeXYZ(), BLOCK_UNKNOWN);
+	_blocks.assign(BLOCK_ROWS, 0);
+	_blockIndex.clear();
+	_blockIndex[std::string(BLOCK_ROWS * sizeof(Uint16), '\0')] = BLOCK_EMPTY;
+}
+
+/**
+ * Rebuilds the entry of a tile from its current parts. Needs to be
+ * called every time a part is changed, destroyed or a ufo door opens
+ * or closes, the same as the voxel check would see it.
+ * @param tile Tile to update.
+ */
+void VoxelGrid::update(const Tile *tile)
+{
+	std::vector<Uint16> rows(BLOCK_ROWS, 0);
+	bool gravLift = false;
+	for (int i = O_FLOOR; i <= O_OBJECT; ++i)
+	{
+		TilePart tp = (TilePart)i;
+		MapData *mp = tile->getMapData(tp);
+		if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
+			continue;
+		if (mp != 0)
+		{
+			if (tp == O_FLOOR && mp->isGravLift())
+			{
+				gravLift = true;
+			}
+			for (int layer = 0; layer < 12; ++layer)
+			{
+				for (int y = 0; y < 16; ++y)
+				{
+					rows[layer * 16 + y] |= _voxelData->at(mp->getLoftID(layer) * 16 + y);
+				}
+			}
+		}
+	}
+
+	Uint16 block;
+	std::string key((const char*)rows.data(), BLOCK_ROWS * sizeof(Uint16));
+	auto it = _blockIndex.find(key);
+	if (it != _blockIndex.end())
+	{
+		block = it->second;
+	}
+	else if (getBlockCount() < BLOCK_UNKNOWN)
+	{
+		block = (Uint16)getBlockCount();
+		_blocks.insert(_blocks.end(), rows.begin(), rows.end());
+		_blockIndex[key] = block;
+	}
+	else
+	{
+		// out of space, leave it to the slow path
+		block = BLOCK_UNKNOWN;
+	}
+	_tiles[_save->getTileIndex(tile->getPosition())] = block | (gravLift ? FLAG_GRAV_LIFT : 0);
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL_types.h>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class Tile;
+
+/**
+ * Bit-packed voxel occupancy of the static terrain of a battle.
+ * Each tile points to a block of 12 layers x 16 rows x 16 bits, made by
+ * combining the LOFTs of all its solid parts. Tiles with the same parts share
+ * the same block, so all of them fit in a few kilobytes. Units are not part
+ * of the grid, they are checked separately as they move all the time.
+ */
+class VoxelGrid
+{
+public:
+	/// Block of a tile without any solid voxel.
+	static const Uint16 BLOCK_EMPTY = 0;
+	/// Block of a tile that isn't in the grid yet, or didn't fit in it.
+	static const Uint16 BLOCK_UNKNOWN = 0x7FFF;
+	/// Flag set on tiles with a grav lift floor, which need an extra check.
+	static const Uint16 FLAG_GRAV_LIFT = 0x8000;
+	/// Number of rows in a block.
+	static const int BLOCK_ROWS = 12 * 16;
+private:
+	SavedBattleGame *_save;
+	const std::vector<Uint16> *_voxelData;
+	std::vector<Uint16> _tiles;
+	std::vector<Uint16> _blocks;
+	std::unordered_map<std::string, Uint16> _blockIndex;
+public:
+	/// Creates an empty grid for a battle.
+	VoxelGrid(SavedBattleGame *save, const std::vector<Uint16> *voxelData);
+	/// Cleans up the grid.
+	~VoxelGrid();
+	/// Marks all tiles as unknown.
+	void clear();
+	/// Updates the grid entry of one tile.
+	void update(const Tile *tile);
+	/// Gets the grid entry of a tile, a block index and flags.
+	Uint16 getTile(int index) const { return _tiles[index]; }
+	/// Checks if a voxel is solid in a block.
+	bool isSolid(Uint16 block, Position voxel) const
+	{
+		return _blocks[(block & ~FLAG_GRAV_LIFT) * BLOCK_ROWS + ((voxel.z % 24) / 2) * 16 + voxel.y % 16] & (1 << (15 - voxel.x % 16));
+	}
+	/// Gets the number of different blocks in the grid.
+	size_t getBlockCount() const { return _blocks.size() / BLOCK_ROWS; }
+};
+
+}
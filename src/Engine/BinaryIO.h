@@ -0,0 +1,95 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <SDL_types.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Appends a little endian number to a binary buffer,
+ * as used by the cache files in the user folder.
+ * @param out Buffer to append to.
+ * @param value Number to write.
+ * @param bytes Number of bytes to write.
+ */
+inline void putBinaryNum(std::string &out, Uint64 value, int bytes)
+{
+	for (int i = 0; i < bytes; ++i)
+	{
+		out.push_back((char)(value >> (i * 8)));
+	}
+}
+
+/**
+ * Appends a string to a binary buffer, preceded by its length.
+ * @param out Buffer to append to.
+ * @param str String to write.
+ */
+inline void putBinaryStr(std::string &out, const std::string &str)
+{
+	putBinaryNum(out, str.size(), 4);
+	out += str;
+}
+
+/**
+ * Reads back the data written by putBinaryNum() and putBinaryStr(),
+ * going bad instead of running past the end.
+ */
+struct BinaryReader
+{
+	const std::string &data;
+	size_t pos;
+	bool ok;
+
+	/// Starts reading at the beginning of a buffer.
+	BinaryReader(const std::string &d) : data(d), pos(0), ok(true) { }
+
+	/// Reads a little endian number of some bytes.
+	Uint64 num(int bytes)
+	{
+		Uint64 value = 0;
+		if (pos + bytes > data.size())
+		{
+			ok = false;
+			return 0;
+		}
+		for (int i = 0; i < bytes; ++i)
+		{
+			value |= (Uint64)(unsigned char)data[pos++] << (i * 8);
+		}
+		return value;
+	}
+
+	/// Reads a string preceded by its length.
+	std::string str()
+	{
+		size_t len = num(4);
+		if (!ok || pos + len > data.size())
+		{
+			ok = false;
+			return "";
+		}
+		pos += len;
+		return data.substr(pos - len, len);
+	}
+};
+
+}
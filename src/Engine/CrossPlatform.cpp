@@ -26,6 +26,7 @@
 #include <fstream>
 #include <string>
 #include <list>
+#include <mutex>
 #include <stdint.h>
 #include <time.h>
 #include <signal.h>
@@ -77,6 +78,8 @@
 #include <cxxabi.h>
 #include <dlfcn.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include "Unicode.h"
 #endif		/* #ifdef _WIN32 */
 #include <SDL.h>
@@ -857,7 +860,8 @@ time_t getDateModified(const std::string &path)
 #ifdef _WIN32
 	time_t rv = 0;
 	auto pathW = pathToWindows(path);
-	auto fh = CreateFileW(pathW.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+	// backup semantics are needed to open folders
+	auto fh = CreateFileW(pathW.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
 	if (fh == INVALID_HANDLE_VALUE) {
 		return 0;
 	}
@@ -1033,6 +1037,95 @@ std::unique_ptr<std::istream> readFile(const std::string& filename) {
 	return std::unique_ptr<std::istream>(new std::istringstream(datastr));
 }
 
+/**
+ * Reads the raw bytes of a file.
+ * @param filename - what to readFile
+ * @return the file contents
+ */
+std::vector<unsigned char> readFileRaw(const std::string& filename) {
+	SDL_RWops *rwops = SDL_RWFromFile(filename.c_str(), "rb");
+	if (!rwops) {
+		std::string err = "Failed to read " + filename + ": " + SDL_GetError();
+		Log(LOG_ERROR) << err;
+		throw Exception(err);
+	}
+	size_t size;
+	unsigned char *data = (unsigned char *)SDL_LoadFile_RW(rwops, &size, SDL_TRUE);
+	if (data == NULL) {
+		std::string err = "Failed to read " + filename + ": " + SDL_GetError();
+		Log(LOG_ERROR) << err;
+		throw Exception(err);
+	}
+	std::vector<unsigned char> datavec(data, data + size);
+	SDL_free(data);
+	return datavec;
+}
+
+/**
+ * Maps a whole file into memory for reading, so its pages are only
+ * loaded when used and are shared with the OS file cache.
+ * @param filename - what to map
+ * @param size - receives the size of the file
+ * @return the mapped data, or NULL if the file can't be mapped (eg. it's empty or not a real file).
+ */
+void *mapFile(const std::string& filename, size_t &size) {
+	size = 0;
+#ifdef _WIN32
+	auto pathW = pathToWindows(filename);
+	HANDLE fh = CreateFileW(pathW.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fh == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fh, &fileSize) || fileSize.QuadPart == 0 || (Uint64)fileSize.QuadPart > SIZE_MAX) {
+		CloseHandle(fh);
+		return NULL;
+	}
+	HANDLE mh = CreateFileMappingW(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(fh);
+	if (mh == NULL) {
+		return NULL;
+	}
+	void *data = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mh); // the view keeps the mapping alive
+	if (data == NULL) {
+		return NULL;
+	}
+	size = (size_t)fileSize.QuadPart;
+	return data;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping stays valid
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+	size = info.st_size;
+	return data;
+#endif
+}
+
+/**
+ * Releases a file mapped with mapFile().
+ * @param data - the mapped data
+ * @param size - the size of the file
+ */
+void unmapFile(void *data, size_t size) {
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
 /**
  * Gets an istream to a file's bytes at least up to and including first "\n---" sequence.
  * To be used only for savegames.
@@ -1472,6 +1565,7 @@ static bool logToFile(const std::string& filename, const std::string& data) {
 static const size_t LOG_BUFFER_LIMIT = 1<<10;
 static std::list<std::pair<int, std::string>> logBuffer;
 static std::string logFileName;
+static std::recursive_mutex logMutex; // the background save and worker threads can log too
 const std::string& getLogFileName() { return logFileName; }
 
 /**
@@ -1492,6 +1586,7 @@ void log(int level, const std::ostringstream& baremsgstream) {
 			  << baremsgstream.str() << std::endl;
 	auto msg = msgstream.str();
 
+	std::lock_guard<std::recursive_mutex> lock(logMutex);
 	int effectiveLevel = Logger::reportingLevel();
 	if (effectiveLevel >= LOG_DEBUG) {
 		fwrite(msg.c_str(), msg.size(), 1, stderr);
@@ -93,6 +93,12 @@ namespace CrossPlatform
 	bool writeFile(const std::string& filename, const std::vector<unsigned char>& data);
 	/// Reads in a file
 	std::unique_ptr<std::istream> readFile(const std::string& filename);
+	/// Reads in the raw bytes of a file
+	std::vector<unsigned char> readFileRaw(const std::string& filename);
+	/// Maps a whole file into memory for reading
+	void *mapFile(const std::string& filename, size_t &size);
+	/// Releases a file mapped with mapFile()
+	void unmapFile(void *data, size_t size);
 	/// Reads file until "\n---" sequence is met or to the end. To be used only for savegames.
 	std::unique_ptr<std::istream> getYamlSaveHeader (const std::string& filename);
 	/// Flashes the game window.
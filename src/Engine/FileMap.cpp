@@ -36,18 +36,25 @@
  * A. somename.zip is always scanned before somename/ directory.
  */
 
+#include <algorithm>
+#include <list>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <istream>
+#include <mutex>
+#include <time.h>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "FileMap.h"
+#include "BinaryIO.h"
 #include "Unicode.h"
 #include "Logger.h"
 #include "CrossPlatform.h"
 #include "Options.h"
 #include "Exception.h"
+#include "Profiler.h"
 
 #define MINIZ_NO_STDIO
 #include "../../libs/miniz/miniz.h"
@@ -176,6 +183,159 @@ namespace OpenXcom
 namespace FileMap
 {
 
+/// Serializes all reads from the zip archives and the blob cache, the state of an archive can't be shared between threads.
+static std::mutex zipMutex;
+
+/// A usable entry of a zip file, as listed in its central directory.
+struct ZipEntry {
+	mz_uint index;
+	std::string name;	// sanitized
+	bool dir;
+};
+
+/**
+ * A zip file mapped into the VFS. Zips whose listing came from the index
+ * are only opened when a file is first read from them.
+ */
+struct ZipArchive {
+	std::string path;
+	std::string stamp;		// size and date of the file, tells apart versions of it in the blob cache
+	SDL_RWops *rwops;		// owned
+	mz_zip_archive *mz;		// NULL until opened
+	std::string error;		// why it couldn't be opened
+	std::vector<ZipEntry> entries;
+	std::unordered_map<mz_uint, std::shared_ptr<const std::string>> preloaded;	// files kept in the index, eg. metadata.yml
+
+	ZipArchive(const std::string& zippath, SDL_RWops *ops, const std::string& zipstamp) :
+		path(zippath), stamp(zipstamp), rwops(ops), mz(NULL), error(), entries(), preloaded() { }
+	~ZipArchive() {
+		if (mz) {
+			mz_zip_reader_end_rwops(mz);
+			SDL_free(mz);
+		} else if (rwops) {
+			SDL_RWclose(rwops);
+		}
+	}
+	/// Gets the miniz context, opening the archive if needed. Needs zipMutex held.
+	mz_zip_archive *open() {
+		if (mz == NULL && error.empty()) {
+			mz = (mz_zip_archive *) SDL_malloc(sizeof(mz_zip_archive));
+			if (!mz) {
+				Log(LOG_FATAL) << "ZipArchive::open(" << path << "): " << SDL_GetError();
+				throw Exception("Out of memory");
+			}
+			if (!mz_zip_reader_init_rwops(mz, rwops)) {
+				error = mz_zip_get_error_string(mz_zip_get_last_error(mz));
+				SDL_free(mz);
+				mz = NULL;
+			}
+		}
+		return mz;
+	}
+};
+
+/// Zipped files already decompressed, the most recently used first.
+typedef std::pair<std::string, std::shared_ptr<const std::string>> Blob;
+static std::list<Blob> BlobCache;
+static std::unordered_map<std::string, std::list<Blob>::iterator> BlobIndex;
+static size_t BlobCacheSize = 0;
+/// Blobs read through open RWops, so they stay alive after leaving the cache.
+static std::unordered_map<SDL_RWops *, std::shared_ptr<const std::string>> OpenBlobs;
+
+/**
+ * Gets the data of a zipped file. It's only decompressed if it isn't in
+ * the cache yet, which keeps up to "oxceZipCacheSize" MB of recently used files.
+ * @param frec - record of a zipped file
+ * @param error - receives the reason if it fails
+ * @return the data, or NULL on failure
+ */
+static std::shared_ptr<const std::string> zipExtract(const FileRecord &frec, std::string &error) {
+	ZipArchive *zip = (ZipArchive *)frec.zip;
+	std::lock_guard<std::mutex> lock(zipMutex);
+	auto pre = zip->preloaded.find(frec.findex);
+	if (pre != zip->preloaded.end()) {
+		return pre->second;
+	}
+	std::string key = frec.fullpath + "|" + zip->stamp;
+	auto cached = BlobIndex.find(key);
+	if (cached != BlobIndex.end()) {
+		Profiler::count("FileMap::zipExtract cache hits");
+		BlobCache.splice(BlobCache.begin(), BlobCache, cached->second);
+		return cached->second->second;
+	}
+	Profiler::count("FileMap::zipExtract cache misses");
+	mz_zip_archive *mz = zip->open();
+	if (!mz) {
+		error = zip->error;
+		return nullptr;
+	}
+	size_t size;
+	void *data = mz_zip_reader_extract_to_heap(mz, frec.findex, &size, 0);
+	if (data == NULL) {
+		error = mz_zip_get_error_string(mz_zip_get_last_error(mz));
+		return nullptr;
+	}
+	auto blob = std::make_shared<const std::string>((const char *)data, size);
+	mz_free(data);
+
+	// big files would push out everything else
+	size_t budget = (size_t)std::max(Options::oxceZipCacheSize, 0) * 1024 * 1024;
+	if (size <= budget / 4) {
+		BlobCache.push_front(std::make_pair(key, blob));
+		BlobIndex[key] = BlobCache.begin();
+		BlobCacheSize += size;
+		while (BlobCacheSize > budget) {
+			BlobCacheSize -= BlobCache.back().second->size();
+			BlobIndex.erase(BlobCache.back().first);
+			BlobCache.pop_back();
+		}
+	}
+	return blob;
+}
+
+static int blobops_close(struct SDL_RWops *context) {
+	if (context) {
+		{
+			std::lock_guard<std::mutex> lock(zipMutex);
+			OpenBlobs.erase(context);
+		}
+		SDL_FreeRW(context);
+	}
+	return 0;
+}
+
+/**
+ * Warps a zipped file in RWops, sharing the data with the cache.
+ * @param frec - record of a zipped file
+ * @return the RWops, or NULL with the SDL error set
+ */
+static SDL_RWops *zipGetRWops(const FileRecord &frec) {
+	std::string error;
+	auto blob = zipExtract(frec, error);
+	if (!blob) {
+		SDL_SetError("miniz extract: %s", error.c_str());
+		return NULL;
+	}
+	SDL_RWops *rv = SDL_RWFromConstMem(blob->data(), blob->size());
+	if (rv) {
+		rv->close = blobops_close;
+		std::lock_guard<std::mutex> lock(zipMutex);
+		OpenBlobs[rv] = blob;
+	}
+	return rv;
+}
+
+static int mapops_close(struct SDL_RWops *context) {
+	if (context) {
+		//HACK: technically speaking `hidden` is an implementation detail, but we need it to unmap the file (similar to `mzops_close`)
+		if (context->hidden.mem.base) {
+			CrossPlatform::unmapFile(context->hidden.mem.base, context->hidden.mem.stop - context->hidden.mem.base);
+		}
+		SDL_FreeRW(context);
+	}
+	return 0;
+}
+
 static inline std::string concatPaths(const std::string& basePath, const std::string& relativePath)
 {
 	if(basePath.size() == 0) throw Exception("Need correct basePath");
@@ -211,7 +371,7 @@ SDL_RWops *FileRecord::getRWops() const
 {
 	SDL_RWops *rv;
 	if (zip != NULL) {
-		rv = SDL_RWFromMZ((mz_zip_archive *)zip, findex);
+		rv = zipGetRWops(*this);
 	} else {
 		rv = SDL_RWFromFile(fullpath.c_str(), "rb");
 	}
@@ -222,9 +382,24 @@ SDL_RWops *FileRecord::getRWops() const
 SDL_RWops *FileRecord::getRWopsReadAll() const
 {
 	SDL_RWops *rv;
+	size_t mappedSize = 0;
+	void *mapped = NULL;
 	if (zip != NULL)
 	{
-		rv = SDL_RWFromMZ((mz_zip_archive *)zip, findex);
+		rv = zipGetRWops(*this);
+	}
+	else if ((mapped = CrossPlatform::mapFile(fullpath, mappedSize)))
+	{
+		// the pages get loaded only when read, straight from the OS file cache
+		rv = SDL_RWFromConstMem(mapped, mappedSize);
+		if (rv)
+		{
+			rv->close = mapops_close;
+		}
+		else
+		{
+			CrossPlatform::unmapFile(mapped, mappedSize);
+		}
 	}
 	else
 	{
@@ -265,17 +440,14 @@ SDL_RWops *FileRecord::getRWopsReadAll() const
 std::unique_ptr<std::istream> FileRecord::getIStream() const
 {
 	if (zip != NULL) {
-		size_t size;
-		void *data = mz_zip_reader_extract_to_heap((mz_zip_archive *)zip, findex, &size, 0);
-		if (data == NULL) {
-			auto err = "FileRecord::getIStream(): failed to decompress " + fullpath + ": ";
-			err += mz_zip_get_error_string(mz_zip_get_last_error((mz_zip_archive *)zip));
+		std::string error;
+		auto blob = zipExtract(*this, error);
+		if (!blob) {
+			auto err = "FileRecord::getIStream(): failed to decompress " + fullpath + ": " + error;
 			Log(LOG_FATAL) << err;
 			throw Exception(err);
 		}
-		std::string a_string((char *)data, size);
-		auto rv = new std::stringstream(a_string);
-		mz_free(data);
+		auto rv = new std::stringstream(*blob);
 		return std::unique_ptr<std::istream>(rv);
 	} else {
 		return CrossPlatform::readFile(fullpath);
@@ -295,6 +467,53 @@ YAML::Node FileRecord::getYAML() const
 	}
 }
 
+/**
+ * Reads the whole file without reporting any errors,
+ * so it can be done on several threads at once.
+ * @param text Receives the contents of the file.
+ * @return True if the file was read.
+ */
+bool FileRecord::tryGetText(std::string &text) const
+{
+	if (zip != NULL) {
+		std::string error;
+		auto blob = zipExtract(*this, error);
+		if (!blob) { return false; }
+		text = *blob;
+	} else {
+		SDL_RWops *rwops = SDL_RWFromFile(fullpath.c_str(), "r");
+		if (!rwops) { return false; }
+		size_t size;
+		char *data = (char *)SDL_LoadFile_RW(rwops, &size, SDL_TRUE);
+		if (data == NULL) { return false; }
+		text.assign(data, size);
+		SDL_free(data);
+	}
+	return true;
+}
+
+/**
+ * Parses the file without reporting any errors, so it can be done
+ * on several threads at once. On failure the caller should fall back
+ * to getYAML(), which reports the error the usual way.
+ * @param doc Receives the parsed document.
+ * @return True if the file was read and parsed.
+ */
+bool FileRecord::tryGetYAML(YAML::Node &doc) const
+{
+	std::string text;
+	if (!tryGetText(text)) { return false; }
+	try
+	{
+		doc = YAML::Load(text);
+	}
+	catch (...)
+	{
+		return false;
+	}
+	return true;
+}
+
 std::vector<YAML::Node> FileRecord::getAllYAML() const
 {
 	try
@@ -329,8 +548,12 @@ static std::string hexDumpBogusData(const std::string& bogus) {
 }
 /* recursively list a directory */
 typedef std::vector<std::pair<std::string, std::string>> dirlist_t; // <dirname, basename>
-static bool ls_r(const std::string &basePath, const std::string &relPath, dirlist_t& dlist) {
+typedef std::vector<std::pair<std::string, time_t>> dirstamps_t; // <dirname, date modified>
+static bool ls_r(const std::string &basePath, const std::string &relPath, dirlist_t& dlist, dirstamps_t *stamps = NULL) {
 	auto fullDir = concatOptionalPaths(basePath, relPath);
+	if (stamps) {
+		stamps->push_back(std::make_pair(relPath, CrossPlatform::getDateModified(fullDir)));
+	}
 	auto files = CrossPlatform::getFolderContents(fullDir);
 	//Log(LOG_VERBOSE) << "ls_r: listing "<<fullDir<<" count="<<files.size();
 	for (auto i = files.begin(); i != files.end(); ++i) {
@@ -338,7 +561,7 @@ static bool ls_r(const std::string &basePath, const std::string &relPath, dirlis
 			auto fullpath = concatPaths(fullDir, std::get<0>(*i));
 			if (CrossPlatform::folderExists(fullpath)) {
 				auto nextRelPath = concatOptionalPaths(relPath, std::get<0>(*i));
-				ls_r(basePath, nextRelPath, dlist);
+				ls_r(basePath, nextRelPath, dlist, stamps);
 				continue;
 			}
 		} else {
@@ -353,10 +576,329 @@ static bool isRuleset(const std::string& fname) {
 	auto canext = canonicalize(last4);
 	return last4 == ".rul";
 }
+/** checks if a zip entry is the metadata.yml of a mod, either at the top level or in a top-level dir */
+static bool isModMetadata(const std::string& fname) {
+	auto cfname = canonicalize(fname);
+	auto slashpos = cfname.find_first_of('/');
+	if (slashpos == cfname.npos) { return cfname == "metadata.yml"; }
+	return cfname.substr(slashpos + 1) == "metadata.yml";
+}
+
+/* persisted index of the folders and zips mapped into the VFS */
+typedef std::vector<std::pair<mz_uint, std::string>> preloads_t; // <entry index, data>
+struct IndexedDir {
+	dirstamps_t stamps;	// every folder in the tree, the listing is valid while none of them changes
+	dirlist_t files;
+};
+struct IndexedZip {
+	std::string stamp;	// size and date of the zip
+	std::vector<ZipEntry> entries;
+	preloads_t preloaded;
+};
+/**
+ * Keeps the listings of folders and zips between runs, so the next
+ * startup doesn't need to walk the folders or read the central directories
+ * of the zips, as long as nothing changed. It's stored in the user folder,
+ * and anything not looked up during a run gets dropped on the next save.
+ */
+class VFSIndex {
+	static const Uint32 VERSION = 1;
+	std::unordered_map<std::string, IndexedDir> _dirs;
+	std::unordered_map<std::string, IndexedZip> _zips;
+	std::unordered_set<std::string> _used;
+	bool _loaded, _dirty;
+
+	/** things modified in the last couple of seconds might change again without the date changing */
+	static bool isSettled(time_t modified) {
+		return modified != 0 && modified < time(NULL) - 2;
+	}
+	static std::string getFilename() { return Options::getUserFolder() + "vfs.cache"; }
+
+	void load() {
+		_loaded = true;
+		SDL_RWops *rwops = SDL_RWFromFile(getFilename().c_str(), "rb");
+		if (!rwops) { return; }
+		size_t size;
+		char *raw = (char *)SDL_LoadFile_RW(rwops, &size, SDL_TRUE);
+		if (!raw) { return; }
+		std::string data(raw, size);
+		SDL_free(raw);
+
+		BinaryReader in(data);
+		if (in.str() != "OXCE VFS index" || in.num(4) != VERSION) {
+			Log(LOG_INFO) << "VFSIndex: " << getFilename() << " is from a different version, rebuilding.";
+			return;
+		}
+		for (size_t n = in.num(4); in.ok && n > 0; --n) {
+			std::string path = in.str();
+			IndexedDir &dir = _dirs[path];
+			for (size_t i = in.num(4); in.ok && i > 0; --i) {
+				std::string relpath = in.str();
+				dir.stamps.push_back(std::make_pair(relpath, (time_t)in.num(8)));
+			}
+			for (size_t i = in.num(4); in.ok && i > 0; --i) {
+				std::string dirname = in.str();
+				dir.files.push_back(std::make_pair(dirname, in.str()));
+			}
+		}
+		for (size_t n = in.num(4); in.ok && n > 0; --n) {
+			std::string path = in.str();
+			IndexedZip &zip = _zips[path];
+			zip.stamp = in.str();
+			for (size_t i = in.num(4); in.ok && i > 0; --i) {
+				ZipEntry entry;
+				entry.index = (mz_uint)in.num(4);
+				entry.dir = in.num(1) != 0;
+				entry.name = in.str();
+				zip.entries.push_back(entry);
+			}
+			for (size_t i = in.num(4); in.ok && i > 0; --i) {
+				mz_uint index = (mz_uint)in.num(4);
+				zip.preloaded.push_back(std::make_pair(index, in.str()));
+			}
+		}
+		if (!in.ok) {
+			Log(LOG_WARNING) << "VFSIndex: " << getFilename() << " is damaged, rebuilding.";
+			_dirs.clear();
+			_zips.clear();
+			return;
+		}
+		Log(LOG_VERBOSE) << "VFSIndex: loaded " << _dirs.size() << " folders and " << _zips.size() << " zips.";
+	}
+
+public:
+	VFSIndex() : _dirs(), _zips(), _used(), _loaded(false), _dirty(false) { }
+
+	/**
+	 * Gets the listing of a folder tree, if it didn't change since it was stored.
+	 * @param path - the folder
+	 * @return - the files, or NULL if it needs to be listed again
+	 */
+	const dirlist_t *findDir(const std::string &path) {
+		if (!_loaded) { load(); }
+		auto it = _dirs.find(path);
+		if (it == _dirs.end()) { return NULL; }
+		for (auto &stamp : it->second.stamps) {
+			if (CrossPlatform::getDateModified(concatOptionalPaths(path, stamp.first)) != stamp.second) {
+				return NULL;
+			}
+		}
+		_used.insert(path);
+		return &it->second.files;
+	}
+	/**
+	 * Stores the listing of a folder tree.
+	 * @param path - the folder
+	 * @param dir - the listing and the dates of all its folders
+	 */
+	void addDir(const std::string &path, IndexedDir &&dir) {
+		if (!_loaded) { load(); }
+		for (auto &stamp : dir.stamps) {
+			if (!isSettled(stamp.second)) { return; }
+		}
+		_dirs[path] = std::move(dir);
+		_used.insert(path);
+		_dirty = true;
+	}
+	/**
+	 * Gets the listing of a zip, if it didn't change since it was stored.
+	 * @param path - the zip
+	 * @param stamp - current size and date of the zip
+	 * @return - the listing, or NULL if the central directory needs to be read again
+	 */
+	const IndexedZip *findZip(const std::string &path, const std::string &stamp) {
+		if (!_loaded) { load(); }
+		auto it = _zips.find(path);
+		if (it == _zips.end() || it->second.stamp != stamp) { return NULL; }
+		_used.insert(path);
+		return &it->second;
+	}
+	/**
+	 * Stores the listing of a zip.
+	 * @param path - the zip
+	 * @param modified - date of the zip
+	 * @param zip - the listing
+	 */
+	void addZip(const std::string &path, time_t modified, IndexedZip &&zip) {
+		if (!_loaded) { load(); }
+		if (!isSettled(modified)) { return; }
+		_zips[path] = std::move(zip);
+		_used.insert(path);
+		_dirty = true;
+	}
+	/**
+	 * Writes the index if anything changed, dropping whatever wasn't used since loading it.
+	 */
+	void save() {
+		if (!_loaded) { return; }
+		for (auto it = _dirs.begin(); it != _dirs.end(); ) {
+			if (_used.find(it->first) == _used.end()) { it = _dirs.erase(it); _dirty = true; } else { ++it; }
+		}
+		for (auto it = _zips.begin(); it != _zips.end(); ) {
+			if (_used.find(it->first) == _used.end()) { it = _zips.erase(it); _dirty = true; } else { ++it; }
+		}
+		if (!_dirty) { return; }
+		_dirty = false;
+
+		std::string out;
+		putBinaryStr(out, "OXCE VFS index");
+		putBinaryNum(out, VERSION, 4);
+		putBinaryNum(out, _dirs.size(), 4);
+		for (auto &dir : _dirs) {
+			putBinaryStr(out, dir.first);
+			putBinaryNum(out, dir.second.stamps.size(), 4);
+			for (auto &stamp : dir.second.stamps) {
+				putBinaryStr(out, stamp.first);
+				putBinaryNum(out, (Uint64)stamp.second, 8);
+			}
+			putBinaryNum(out, dir.second.files.size(), 4);
+			for (auto &file : dir.second.files) {
+				putBinaryStr(out, file.first);
+				putBinaryStr(out, file.second);
+			}
+		}
+		putBinaryNum(out, _zips.size(), 4);
+		for (auto &zip : _zips) {
+			putBinaryStr(out, zip.first);
+			putBinaryStr(out, zip.second.stamp);
+			putBinaryNum(out, zip.second.entries.size(), 4);
+			for (auto &entry : zip.second.entries) {
+				putBinaryNum(out, entry.index, 4);
+				putBinaryNum(out, entry.dir, 1);
+				putBinaryStr(out, entry.name);
+			}
+			putBinaryNum(out, zip.second.preloaded.size(), 4);
+			for (auto &pre : zip.second.preloaded) {
+				putBinaryNum(out, pre.first, 4);
+				putBinaryStr(out, pre.second);
+			}
+		}
+		if (!CrossPlatform::writeFile(getFilename(), std::vector<unsigned char>(out.begin(), out.end()))) {
+			Log(LOG_WARNING) << "VFSIndex: failed to write " << getFilename();
+			return;
+		}
+		Log(LOG_VERBOSE) << "VFSIndex: saved " << _dirs.size() << " folders and " << _zips.size() << " zips.";
+	}
+};
+static VFSIndex TheIndex;
+
+/**
+ * Lists a folder tree, from the index if it's still valid.
+ * @param dirpath - the folder
+ * @param dlist - receives the files
+ */
+static bool listDir(const std::string &dirpath, dirlist_t &dlist) {
+	if (!Options::oxceFileMapIndex) {
+		return ls_r(dirpath, "", dlist);
+	}
+	auto indexed = TheIndex.findDir(dirpath);
+	if (indexed) {
+		dlist = *indexed;
+		return true;
+	}
+	IndexedDir dir;
+	if (!ls_r(dirpath, "", dlist, &dir.stamps)) {
+		return false;
+	}
+	dir.files = dlist;
+	TheIndex.addDir(dirpath, std::move(dir));
+	return true;
+}
+
+static std::vector<ZipArchive *> ZipArchives; // zips shared between layers that came from the same file
+
+/**
+ * Opens a zip right away and lists its usable entries.
+ * @param log_ctx - prefix for the log messages
+ * @param rwops - the zip data, owned by the archive from here on
+ * @param zippath - the file path to associate this with
+ * @param stamp - tells apart versions of the same file
+ * @return - the archive, or NULL if it isn't a readable zip
+ */
+static ZipArchive *newZipArchive(const std::string& log_ctx, SDL_RWops *rwops, const std::string& zippath, const std::string& stamp) {
+	auto zip = new ZipArchive(zippath, rwops, stamp);
+	mz_zip_archive *mz;
+	{
+		std::lock_guard<std::mutex> lock(zipMutex);
+		mz = zip->open();
+	}
+	if (!mz) {
+		// whoa, no opening the file
+		Log(LOG_WARNING) << log_ctx << "Ignoring zip: " << zip->error;
+		delete zip;
+		return NULL;
+	}
+	mz_uint filecount = mz_zip_reader_get_num_files(mz);
+	for (mz_uint fi = 0; fi < filecount; ++fi) {
+		mz_zip_archive_file_stat fistat;
+		mz_zip_reader_file_stat(mz, fi, &fistat);
+
+		std::string fname = fistat.m_filename;
+		if (!sanitizeZipEntryName(fname)) {
+			Log(LOG_WARNING) << "Bogus filename " << hexDumpBogusData(fname) << " in " << zippath << ", ignoring.";
+			continue;
+		}
+		if (fistat.m_is_encrypted || !fistat.m_is_supported) { continue; }
+		ZipEntry entry;
+		entry.index = fi;
+		entry.name = fname;
+		entry.dir = fistat.m_is_directory;
+		zip->entries.push_back(entry);
+	}
+	ZipArchives.push_back(zip);
+	return zip;
+}
+/**
+ * Opens a zip file. If the index has its listing, the zip
+ * itself only gets opened when a file is read from it.
+ * @param log_ctx - prefix for the log messages
+ * @param zippath - path to the .zip
+ * @return - the archive, or NULL if it isn't a readable zip
+ */
+static ZipArchive *openZipFile(const std::string& log_ctx, const std::string& zippath) {
+	SDL_RWops *rwops = SDL_RWFromFile(zippath.c_str(), "r");
+	if (!rwops) {
+		Log(LOG_WARNING) << log_ctx << "Ignoring zip '" << zippath << "': " << SDL_GetError();
+		return NULL;
+	}
+	time_t modified = CrossPlatform::getDateModified(zippath);
+	std::string stamp = std::to_string((long long)SDL_RWseek(rwops, 0, RW_SEEK_END)) + ":" + std::to_string((long long)modified);
+	SDL_RWseek(rwops, 0, RW_SEEK_SET);
+	if (!Options::oxceFileMapIndex) {
+		return newZipArchive(log_ctx, rwops, zippath, stamp);
+	}
+	auto indexed = TheIndex.findZip(zippath, stamp);
+	if (indexed) {
+		auto zip = new ZipArchive(zippath, rwops, stamp);
+		zip->entries = indexed->entries;
+		for (auto &pre : indexed->preloaded) {
+			zip->preloaded[pre.first] = std::make_shared<const std::string>(pre.second);
+		}
+		ZipArchives.push_back(zip);
+		return zip;
+	}
+	auto zip = newZipArchive(log_ctx, rwops, zippath, stamp);
+	if (zip) {
+		IndexedZip index;
+		index.stamp = stamp;
+		index.entries = zip->entries;
+		// keep the mod metadata too, so scanning the mods doesn't open the zip at all
+		for (auto &entry : zip->entries) {
+			if (entry.dir || !isModMetadata(entry.name)) { continue; }
+			size_t size;
+			void *data = mz_zip_reader_extract_to_heap(zip->mz, entry.index, &size, 0);
+			if (data) {
+				index.preloaded.push_back(std::make_pair(entry.index, std::string((char *)data, size)));
+				mz_free(data);
+			}
+		}
+		TheIndex.addZip(zippath, modified, std::move(index));
+	}
+	return zip;
+}
 
 typedef std::unordered_map<std::string, FileRecord> FileSet;
 static const NameSet emptySet;
-static mz_zip_archive *newZipContext(const std::string& log_ctx, SDL_RWops *rwops);
 
 struct VFSLayer {
 	std::string fullpath;				// the origin
@@ -418,12 +960,9 @@ struct VFSLayer {
 	*/
 	bool mapZipFile(const std::string& zippath, const std::string& prefix, bool ignore_ruls = false) {
 		std::string log_ctx = "mapZipFile(" + zippath + ",  '" + prefix + "',  '" + (ignore_ruls ? "true" : "false") + "'): ";
-		SDL_RWops *rwops = SDL_RWFromFile(zippath.c_str(), "r");
-		if (!rwops) {
-			Log(LOG_WARNING) << log_ctx << "Ignoring zip '" << zippath << "': " << SDL_GetError();
-			return false;
-		}
-		return mapZipFileRW(rwops, zippath, prefix, ignore_ruls);
+		ZipArchive *zip = openZipFile(log_ctx, zippath);
+		if (!zip) { return false; }
+		return mapZip(zip, zippath, prefix, ignore_ruls);
 	}
 	/** maps a zipped moddir from an SDL_RWops
 	* @param rwops - SDL_RWops with the zip data
@@ -434,7 +973,7 @@ struct VFSLayer {
 	*/
 	bool mapZipFileRW(SDL_RWops *rwops, const std::string& zippath, const std::string& prefix, bool ignore_ruls = false) {
 		std::string log_ctx = "mapZipFileRW(rwops, '" + zippath + "', '" + prefix + "',  '" + (ignore_ruls ? "true" : "false") + "'): ";
-		mz_zip_archive *zip = newZipContext(log_ctx, rwops);
+		ZipArchive *zip = newZipArchive(log_ctx, rwops, zippath, "embedded");
 		if (!zip) { return false; }
 		return mapZip(zip, zippath, prefix, ignore_ruls);
 	}
@@ -445,7 +984,7 @@ struct VFSLayer {
 	* @param ignore_ruls - skip rulesets
 	* @return - did we map anything (false, i.e if failed to unzip)
 	*/
-	bool mapZip(mz_zip_archive *zip, const std::string& zippath, const std::string& prefix, bool ignore_ruls = false) {
+	bool mapZip(ZipArchive *zip, const std::string& zippath, const std::string& prefix, bool ignore_ruls = false) {
 		std::string log_ctx = "mapZip(zip, '" + zippath + "', '" + prefix + "',  '" + (ignore_ruls ? "true" : "false") + "'): ";
 		if (mapped) {
 			auto err=  log_ctx + "Fatal: already mapped.";
@@ -460,31 +999,22 @@ struct VFSLayer {
 		}
 		mapped = true;
 		fullpath = zippath;
-		mz_uint filecount = mz_zip_reader_get_num_files(zip);
 
 		FileRecord frec;
 		frec.zip = zip;
 
 		mz_uint mapped_count = 0;
-		for (mz_uint fi = 0; fi < filecount; ++fi) {
-			mz_zip_archive_file_stat fistat;
-			mz_zip_reader_file_stat(zip, fi, &fistat);
-
-			std::string fname = fistat.m_filename;
-			if (!sanitizeZipEntryName(fname)) {
-				Log(LOG_WARNING) << "Bogus filename " << hexDumpBogusData(fname) << " in " << zippath << ", ignoring.";
-				continue;
-			}
+		for (const auto& entry : zip->entries) {
+			const std::string& fname = entry.name;
 			std::string relfname = fname;
-			if (fistat.m_is_encrypted || !fistat.m_is_supported) { continue; }
-			if (fistat.m_is_directory) { continue; }
+			if (entry.dir) { continue; }
 			if (fname.size() <= prefixlen) { continue; }
 			if (prefixlen > 0) { // well, cut out the prefix to get the real relfname.
 				auto tprefix = fname.substr(0, prefixlen);
 				if (tprefix != prefix) { continue; }
 				relfname = fname.substr(prefixlen, fname.npos);
 			}
-			frec.findex = fi;
+			frec.findex = entry.index;
 			frec.fullpath = concatPaths(fullpath, fname);
 
 			if (isRuleset(relfname) && ignore_ruls) { continue; }
@@ -502,7 +1032,7 @@ struct VFSLayer {
 			throw Exception(err);
 		}
 		dirlist_t dlist;
-		if (!ls_r(dirpath, "", dlist)) {
+		if (!listDir(dirpath, dlist)) {
 			return false;
 		}
 		fullpath = dirpath;
@@ -685,37 +1215,18 @@ struct VFS {
 static std::unordered_map<std::string, ModRecord *> ModsAvailable;
 static std::unordered_set<VFSLayer *> MappedVFSLayers; // owned here so we can have some sense of their lifetime
 												       // only the layers that get dropped on FileMap::clear()
-static std::vector<mz_zip_archive *> ZipContexts;	   // zip decompression contexts shared between layers that came from
-													   // the same .zip. this makes the whole thing very thread-unsafe
 static VFS TheVFS;
 
 const RSOrder &getRulesets() { return TheVFS.get_rulesets(); }
 
-static mz_zip_archive *newZipContext(const std::string& log_ctx, SDL_RWops *rwops) {
-	mz_zip_archive *zip = (mz_zip_archive *) SDL_malloc(sizeof(mz_zip_archive));
-	if (!zip) {
-		Log(LOG_FATAL) << log_ctx << ": " << SDL_GetError();
-		throw Exception("Out of memory");
-	}
-	if (!mz_zip_reader_init_rwops(zip, rwops)) {
-		// whoa, no opening the file
-		Log(LOG_WARNING) << log_ctx << "Ignoring zip: " << mz_zip_get_error_string(mz_zip_get_last_error(zip));
-		SDL_RWclose(rwops);
-		SDL_free(zip);
-		return NULL;
-	}
-	ZipContexts.push_back(zip);
-	return zip;
-}
-
 void clear(bool clearOnly, bool embeddedOnly) {
 	TheVFS.clear();
 	for(auto i : ModsAvailable ) { delete i.second; }
 	ModsAvailable.clear();
 	for (auto i : MappedVFSLayers ) { delete i; }
 	MappedVFSLayers.clear();
-	for (auto i : ZipContexts) { mz_zip_reader_end_rwops(i); SDL_free(i); }
-	ZipContexts.clear();
+	for (auto i : ZipArchives) { delete i; }
+	ZipArchives.clear();
 	if (!clearOnly)
 	{
 		Log(LOG_VERBOSE) << "FileMap::clear(): mapping 'common'";
@@ -769,6 +1280,7 @@ void setup(const std::vector<const ModInfo* >& active, bool embeddedOnly)
 	if (LOG_VERBOSE <= Logger::reportingLevel()) {
 		TheVFS.dump(Logger().get(LOG_VERBOSE), "\n" + log_ctx, Options::listVFSContents);
 	}
+	TheIndex.save();
 }
 [[gnu::unused]]
 static void dump_mods_layers(std::ostream &out, const std::string& prefix, bool verbose) {
@@ -861,7 +1373,7 @@ static bool mapExtResources(ModRecord *mrec, const std::string& basename, bool e
  * @param zipfname  - full path to the .zip_open
  * @param prefix    - prefix (subdir) in the .zip if any
  */
-static void mapZippedMod(mz_zip_archive *zip, const std::string& zipfname, const std::string& prefix) {
+static void mapZippedMod(ZipArchive *zip, const std::string& zipfname, const std::string& prefix) {
 	std::string log_ctx = "mapZippedMod(" + zipfname + ", '" + prefix + "'): ";
 	auto layer = new VFSLayer(concatPaths(zipfname, prefix));
 	if (!layer->mapZip(zip, zipfname, prefix)) {
@@ -901,44 +1413,41 @@ static void mapZippedMod(mz_zip_archive *zip, const std::string& zipfname, const
  * @param rwops - SDL_RWops to the zip data
  * @param fullpath - full path to associate with the .zip.
  */
-void scanModZipRW(SDL_RWops *rwops, const std::string& fullpath) {
-	std::string log_ctx = "scanModZipRW(rwops, " + fullpath + "): ";
-	mz_zip_archive *mzip = newZipContext(log_ctx, rwops);
-
-	if (!mzip) { return; }
+static void scanZippedMods(ZipArchive *zip, const std::string& fullpath, const std::string& log_ctx) {
 	// check if this is maybe a zip of a single mod (metadata.yml at the top level)
-	if (mz_zip_reader_locate_file_v2(mzip, "metadata.yml", NULL, 0, NULL)) {
-		Log(LOG_VERBOSE) << log_ctx << "retrying as a single-mod .zip";
-		mapZippedMod(mzip, fullpath, "");
-		return;
-	}
-	mz_uint filecount = mz_zip_reader_get_num_files(mzip);
-	for (mz_uint fi = 0; fi < filecount; ++fi) {
-		mz_zip_archive_file_stat fistat;
-		mz_zip_reader_file_stat(mzip, fi, &fistat);
-		std::string prefix = fistat.m_filename;
-		if (!sanitizeZipEntryName(prefix)) {
-			Log(LOG_WARNING) << "Bogus dirname " << hexDumpBogusData(prefix) << " in " << fullpath << ", ignoring.";
-			continue;
+	for (const auto& entry : zip->entries) {
+		if (!entry.dir && canonicalize(entry.name) == "metadata.yml") {
+			Log(LOG_VERBOSE) << log_ctx << "retrying as a single-mod .zip";
+			mapZippedMod(zip, fullpath, "");
+			return;
 		}
-		if (fistat.m_is_encrypted || !fistat.m_is_supported) { continue; }
-		if (!fistat.m_is_directory) { continue; } // skip files, we're only interested in toplevel dirs.
+	}
+	for (const auto& entry : zip->entries) {
+		if (!entry.dir) { continue; } // skip files, we're only interested in toplevel dirs.
+		const std::string& prefix = entry.name;
 		auto slashpos = prefix.find_first_of("/"); // miniz returns dirnames with trailing slashes
 		if (slashpos != prefix.size() - 1) { continue; } // not top-level: skip.
-		mapZippedMod(mzip, fullpath, prefix);
+		mapZippedMod(zip, fullpath, prefix);
 	}
 }
-/** Filesystem wrapper for scanModZipRW()
+/** now this scans a zip of mods or of a single mod
+ * @param rwops - SDL_RWops to the zip data
+ * @param fullpath - full path to associate with the .zip.
+ */
+void scanModZipRW(SDL_RWops *rwops, const std::string& fullpath) {
+	std::string log_ctx = "scanModZipRW(rwops, " + fullpath + "): ";
+	ZipArchive *zip = newZipArchive(log_ctx, rwops, fullpath, "embedded");
+	if (!zip) { return; }
+	scanZippedMods(zip, fullpath, log_ctx);
+}
+/** Filesystem wrapper for scanModZipRW(), using the index when it can
  * @param fullpath - full path to the .zip.
  */
 void scanModZip(const std::string& fullpath) {
 	std::string log_ctx = "scanModZip(" + fullpath + "): ";
-	SDL_RWops *rwops = SDL_RWFromFile(fullpath.c_str(), "r");
-	if (!rwops) {
-		Log(LOG_WARNING) << log_ctx << "Ignoring zip: " << SDL_GetError();
-		return;
-	}
-	scanModZipRW(rwops, fullpath);
+	ZipArchive *zip = openZipFile(log_ctx, fullpath);
+	if (!zip) { return; }
+	scanZippedMods(zip, fullpath, log_ctx);
 }
 /**
  * Extracts a single file to an ConstMem RWops object
@@ -1231,6 +1740,7 @@ void checkModsDependencies() {
 		}
 	}
 	drop_mods(log_ctx, drop_list);
+	TheIndex.save();
 }
 // returns currently mapped bunch of mods.
 std::map<std::string, ModInfo> getModInfos() {
@@ -52,6 +52,10 @@ namespace FileMap
 
 		std::unique_ptr<std::istream> getIStream() const;
 		YAML::Node getYAML() const;
+		/// Reads the whole file quietly, safe to use from worker threads.
+		bool tryGetText(std::string &text) const;
+		/// Parses the file quietly, safe to use from worker threads.
+		bool tryGetYAML(YAML::Node &doc) const;
 		std::vector<YAML::Node> getAllYAML() const;
 	};
 
@@ -25,17 +25,20 @@
 #include "State.h"
 #include "Screen.h"
 #include "Sound.h"
+#include "SurfaceSet.h"
 #include "Music.h"
 #include "Language.h"
 #include "Logger.h"
 #include "../Interface/Cursor.h"
 #include "../Interface/FpsCounter.h"
 #include "../Mod/Mod.h"
+#include "../Savegame/BackgroundSave.h"
 #include "../Savegame/SavedGame.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "Action.h"
 #include "Exception.h"
 #include "Options.h"
+#include "Parallel.h"
 #include "CrossPlatform.h"
 #include "FileMap.h"
 #include "Unicode.h"
@@ -110,6 +113,8 @@ Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _save(0
  */
 Game::~Game()
 {
+	// finish writing any autosave before the game goes away
+	BackgroundSave::wait();
 	Sound::stop();
 	Music::stop();
 
@@ -127,6 +132,9 @@ Game::~Game()
 	delete _screen;
 	delete _fpsCounter;
 
+	// join the worker threads while SDL and the logger are still around
+	Parallel::quit();
+
 	Mix_CloseAudio();
 
 	SDL_Quit();
@@ -147,11 +155,7 @@ void Game::run()
 	while (!_quit)
 	{
 		// Clean up states
-		while (!_deleted.empty())
-		{
-			delete _deleted.back();
-			_deleted.pop_back();
-		}
+		cleanupStates();
 
 		// Initialize active state
 		if (!_init)
@@ -459,6 +463,28 @@ void Game::popState()
 	_init = false;
 }
 
+/**
+ * Deletes the states that were popped from the stack,
+ * once nothing can be referencing them anymore.
+ */
+void Game::cleanupStates()
+{
+	if (_deleted.empty())
+	{
+		return;
+	}
+	while (!_deleted.empty())
+	{
+		delete _deleted.back();
+		_deleted.pop_back();
+	}
+	// battles keep pointers to the frames in their tiles
+	if (!_save || !_save->getSavedBattle())
+	{
+		SurfaceSet::trimCache();
+	}
+}
+
 /**
  * Sets a new saved game for the game to use.
  * @param save Pointer to the saved game.
@@ -477,7 +503,9 @@ void Game::loadMods()
 	Mod::resetGlobalStatics();
 	delete _mod;
 	_mod = new Mod();
+	SurfaceSet::setCacheActive(false);
 	_mod->loadAll();
+	SurfaceSet::setCacheActive(true);
 }
 
 /**
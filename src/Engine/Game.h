@@ -83,6 +83,10 @@ public:
 	void pushState(State *state);
 	/// Pops the last state from the state stack.
 	void popState();
+	/// Gets the state on top of the state stack.
+	State *getTopState() const { return _states.empty() ? 0 : _states.back(); }
+	/// Deletes the states popped since the last cycle.
+	void cleanupStates();
 	/// Gets the currently loaded language.
 	Language *getLanguage() const { return _lang; }
 	/// Gets the currently loaded saved game.
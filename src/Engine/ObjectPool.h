@@ -0,0 +1,182 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <memory>
+#include <new>
+#include <vector>
+#include <stddef.h>
+#include <SDL_types.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Storage for objects of one type that get created and deleted all the
+ * time, like the items and units of a battle. The objects live in chunks
+ * of slots instead of separate heap blocks, deleted slots get reused by
+ * the next object, and all chunks are dropped at once when the pool is
+ * empty.
+ *
+ * Every object has a 32-bit handle: the slot index in the low bits and
+ * a generation in the high bits, which changes each time the slot is
+ * freed. Unlike a pointer, a handle of a deleted object can be checked,
+ * it simply doesn't match anymore. Generations wrap after 4096 reuses of
+ * the same slot, so it's a safety check, not an identity.
+ *
+ * Not thread safe, the objects are only created and deleted on the main thread.
+ */
+template<typename T>
+class ObjectPool
+{
+public:
+	/// Handle that never refers to an object.
+	static constexpr Uint32 INVALID_HANDLE = 0xFFFFFFFF;
+private:
+	static constexpr int CHUNK_SIZE = 256;
+	static constexpr int GENERATION_SHIFT = 20;
+	static constexpr Uint32 INDEX_MASK = (1 << GENERATION_SHIFT) - 1;
+
+	struct Slot
+	{
+		Uint32 handle;
+		bool live;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	std::vector<std::unique_ptr<Slot[]>> _chunks;
+	std::vector<Uint32> _free;
+	size_t _count;
+	Uint32 _epoch;
+
+	/// Gets the slot holding an object.
+	static Slot *getSlotOf(const void *p)
+	{
+		return reinterpret_cast<Slot*>(const_cast<unsigned char*>(static_cast<const unsigned char*>(p)) - offsetof(Slot, storage));
+	}
+	/// Gets a slot by index.
+	Slot *getSlot(Uint32 index) const
+	{
+		return &_chunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+	}
+public:
+	/// Creates an empty pool.
+	ObjectPool() : _count(0), _epoch(0) { }
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool &operator=(const ObjectPool&) = delete;
+
+	/**
+	 * Gets memory for a new object, to be used by operator new.
+	 * @return Uninitialized memory for one object.
+	 */
+	void *allocate()
+	{
+		if (_free.empty())
+		{
+			Uint32 first = _chunks.size() * CHUNK_SIZE;
+			if (first + CHUNK_SIZE > INDEX_MASK)
+			{
+				throw std::bad_alloc();
+			}
+			_chunks.emplace_back(new Slot[CHUNK_SIZE]);
+			for (int i = CHUNK_SIZE - 1; i >= 0; --i)
+			{
+				Slot &slot = _chunks.back()[i];
+				slot.handle = (_epoch << GENERATION_SHIFT) | (first + i);
+				slot.live = false;
+				_free.push_back(first + i);
+			}
+		}
+		Slot *slot = getSlot(_free.back());
+		_free.pop_back();
+		slot->live = true;
+		++_count;
+		return slot->storage;
+	}
+
+	/**
+	 * Gives back the memory of a deleted object, to be used by operator delete.
+	 * The slot gets a new generation, so the old handle stops working.
+	 * @param p Memory from allocate().
+	 */
+	void deallocate(void *p)
+	{
+		Slot *slot = getSlotOf(p);
+		Uint32 index = slot->handle & INDEX_MASK;
+		slot->handle = (((slot->handle >> GENERATION_SHIFT) + 1) << GENERATION_SHIFT) | index;
+		slot->live = false;
+		_free.push_back(index);
+		--_count;
+	}
+
+	/**
+	 * Drops all the chunks in one go if no object is left, eg. at the end of a battle.
+	 * Slots made afterwards start at a different generation, so old handles stay invalid.
+	 * @return True if the memory was released.
+	 */
+	bool release()
+	{
+		if (_count != 0)
+		{
+			return false;
+		}
+		_chunks.clear();
+		_chunks.shrink_to_fit();
+		_free.clear();
+		_free.shrink_to_fit();
+		++_epoch;
+		return true;
+	}
+
+	/**
+	 * Gets the handle of an object in the pool.
+	 * @param object Pointer to the object.
+	 * @return Handle of the object.
+	 */
+	static Uint32 getHandle(const T *object)
+	{
+		return getSlotOf(object)->handle;
+	}
+
+	/**
+	 * Gets an object by its handle.
+	 * @param handle Handle of the object.
+	 * @return Pointer to the object, or null if it was deleted.
+	 */
+	T *get(Uint32 handle) const
+	{
+		Uint32 index = handle & INDEX_MASK;
+		if (handle == INVALID_HANDLE || index >= _chunks.size() * CHUNK_SIZE)
+		{
+			return nullptr;
+		}
+		Slot *slot = getSlot(index);
+		if (!slot->live || slot->handle != handle)
+		{
+			return nullptr;
+		}
+		return reinterpret_cast<T*>(slot->storage);
+	}
+
+	/// Gets the number of objects in the pool.
+	size_t getCount() const { return _count; }
+	/// Gets the number of objects the pool can hold without growing.
+	size_t getCapacity() const { return _chunks.size() * CHUNK_SIZE; }
+};
+
+}
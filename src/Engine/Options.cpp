@@ -52,6 +52,7 @@ std::map<std::string, std::string> _commandLine;
 std::vector<OptionInfo> _info;
 std::map<std::string, ModInfo> _modInfos;
 std::string _masterMod;
+std::string _benchmark;
 int _passwordCheck = -1;
 bool _loadLastSave = false;
 bool _loadLastSaveExpended = false;
@@ -243,6 +244,18 @@ void create()
 	_info.push_back(OptionInfo("oxceEnablePaletteFlickerFix", &oxceEnablePaletteFlickerFix, false));
 	_info.push_back(OptionInfo("oxcePersonalLayoutIncludingArmor", &oxcePersonalLayoutIncludingArmor, true));
 	_info.push_back(OptionInfo("oxceManufactureFilterSuppliesOK", &oxceManufactureFilterSuppliesOK, false));
+	_info.push_back(OptionInfo("oxceWorkerThreads", &oxceWorkerThreads, 0)); // 0 = number of CPU cores
+	_info.push_back(OptionInfo("oxceIncrementalLighting", &oxceIncrementalLighting, true));
+	_info.push_back(OptionInfo("oxceBinarySaves", &oxceBinarySaves, false));
+	_info.push_back(OptionInfo("oxceBackgroundAutosave", &oxceBackgroundAutosave, true));
+	_info.push_back(OptionInfo("oxcePartialMapRedraw", &oxcePartialMapRedraw, true));
+	_info.push_back(OptionInfo("oxceMapRedrawOverlay", &oxceMapRedrawOverlay, false));
+	_info.push_back(OptionInfo("oxceScalerBands", &oxceScalerBands, 0)); // 0 = one band per worker thread, 1 = single-threaded
+	_info.push_back(OptionInfo("oxceFileMapIndex", &oxceFileMapIndex, true));
+	_info.push_back(OptionInfo("oxceZipCacheSize", &oxceZipCacheSize, 32)); // in MB, 0 = no cache
+	_info.push_back(OptionInfo("oxceSpriteCacheSize", &oxceSpriteCacheSize, 128)); // in MB, 0 = no limit
+	_info.push_back(OptionInfo("oxceRulesetCache", &oxceRulesetCache, true));
+	_info.push_back(OptionInfo("oxceGeoFastForward", &oxceGeoFastForward, true));
 
 	// OXCE hidden but moddable
 	_info.push_back(OptionInfo("oxceStartUpTextMode", &oxceStartUpTextMode, 0, "", "HIDDEN"));
@@ -514,6 +527,10 @@ static void loadArgs()
 				{
 					_masterMod = argv[i];
 				}
+				else if (argname == "benchmark")
+				{
+					_benchmark = argv[i];
+				}
 				else
 				{
 					//save this command line option for now, we will apply it later
@@ -546,6 +563,20 @@ static bool showHelp()
 	help << "        use PATH as the default Config Folder instead of auto-detecting" << std::endl << std::endl;
 	help << "-master MOD" << std::endl;
 	help << "        set MOD to the current master mod (eg. -master xcom2)" << std::endl << std::endl;
+	help << "-benchmark battle -benchmarkSave FILE [-benchmarkTurns N] [-benchmarkSeed SEED]" << std::endl;
+	help << "        run the battle in save FILE without video for N turns and log the timings" << std::endl << std::endl;
+	help << "-benchmark pathfinding -benchmarkSave FILE [-benchmarkRepeat N]" << std::endl;
+	help << "        compare the pathfinding searches of all units in save FILE with the reference ones" << std::endl << std::endl;
+	help << "-benchmark lighting -benchmarkSave FILE [-benchmarkRepeat N]" << std::endl;
+	help << "        compare the incremental unit lighting in save FILE with the full recalculation" << std::endl << std::endl;
+	help << "-benchmark tracing -benchmarkSave FILE [-benchmarkRepeat N]" << std::endl;
+	help << "        compare the line and arc traces between all units in save FILE with the voxel by voxel ones" << std::endl << std::endl;
+	help << "-benchmark tiles -benchmarkSave FILE [-benchmarkRepeat N]" << std::endl;
+	help << "        compare scanning fire, smoke and light through the tiles and the tile store, in save FILE and a 100x100x8 map" << std::endl << std::endl;
+	help << "-benchmark save -benchmarkSave FILE [-benchmarkRepeat N]" << std::endl;
+	help << "        save and load save FILE in YAML and binary, and check both hold the same game" << std::endl << std::endl;
+	help << "-benchmark blit -benchmarkSave FILE [-benchmarkRepeat N]" << std::endl;
+	help << "        blit BIGOBS.PCK and the unit sprites of save FILE with every set of blit kernels and compare them" << std::endl << std::endl;
 	help << "-KEY VALUE" << std::endl;
 	help << "        override option KEY with VALUE (eg. -displayWidth 640)" << std::endl << std::endl;
 	help << "-help" << std::endl;
@@ -573,6 +604,34 @@ static bool showHelp()
 
 const std::map<std::string, ModInfo> &getModInfos() { return _modInfos; }
 
+/**
+ * Gets the benchmark requested with "-benchmark NAME".
+ * @return Benchmark name, empty for a normal game.
+ */
+const std::string &getBenchmark()
+{
+	return _benchmark;
+}
+
+/**
+ * Gets the raw value of a command line argument
+ * that doesn't correspond to any option, eg. benchmark parameters.
+ * @param name Argument name, without the dash.
+ * @param defaultValue Value returned when the argument is missing.
+ * @return Argument value.
+ */
+std::string getCommandLineArg(const std::string &name, const std::string &defaultValue)
+{
+	std::string argname = name;
+	std::transform(argname.begin(), argname.end(), argname.begin(), ::tolower);
+	auto it = _commandLine.find(argname);
+	if (it != _commandLine.end())
+	{
+		return it->second;
+	}
+	return defaultValue;
+}
+
 /**
  * Splits the game's User folder by master mod,
  * creating a subfolder for each one.
@@ -116,6 +116,10 @@ namespace Options
 	bool getLoadLastSave();
 	/// And do it only at startup
 	void expendLoadLastSave();
+	/// Gets the benchmark requested on the command line, if any.
+	const std::string &getBenchmark();
+	/// Gets the raw value of a command line argument.
+	std::string getCommandLineArg(const std::string &name, const std::string &defaultValue = "");
 }
 
 }
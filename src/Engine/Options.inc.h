@@ -82,6 +82,18 @@ OPT bool oxceEnableSlackingIndicator;
 OPT bool oxceEnablePaletteFlickerFix;
 OPT bool oxcePersonalLayoutIncludingArmor;
 OPT bool oxceManufactureFilterSuppliesOK;
+OPT int oxceWorkerThreads;
+OPT bool oxceIncrementalLighting;
+OPT bool oxceBinarySaves;
+OPT bool oxceBackgroundAutosave;
+OPT bool oxcePartialMapRedraw;
+OPT bool oxceMapRedrawOverlay;
+OPT int oxceScalerBands;
+OPT bool oxceFileMapIndex;
+OPT int oxceZipCacheSize;
+OPT int oxceSpriteCacheSize;
+OPT bool oxceRulesetCache;
+OPT bool oxceGeoFastForward;
 
 // OXCE hidden, but moddable via fixedUserOptions and/or recommendedUserOptions
 OPT int oxceStartUpTextMode;
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Options.h"
+
+namespace OpenXcom
+{
+
+namespace Parallel
+{
+
+namespace
+{
+
+/// Upper limit of threads used when the count is detected automatically.
+const int MAX_AUTO_THREADS = 8;
+
+std::mutex _jobMutex;
+std::mutex _mutex;
+std::condition_variable _wake, _finished;
+const std::function<void(size_t, int)> *_job = 0;
+size_t _jobSize = 0;
+std::atomic<size_t> _next(0);
+int _busy = 0;
+unsigned _generation = 0;
+bool _quit = false;
+std::exception_ptr _error;
+/// Index of the thread while it works on a job, -1 outside of jobs.
+thread_local int _thread = -1;
+
+/**
+ * Takes work items until there are none left.
+ * @param thread Index of the thread doing the work.
+ */
+void work(int thread)
+{
+	_thread = thread;
+	try
+	{
+		for (size_t i = _next++; i < _jobSize; i = _next++)
+		{
+			(*_job)(i, thread);
+		}
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_error)
+		{
+			_error = std::current_exception();
+		}
+		_next = _jobSize;
+	}
+	_thread = -1;
+}
+
+/**
+ * Main loop of a worker thread, waits for jobs and helps with them.
+ * @param thread Index of the thread.
+ * @param seen Generation of the last job posted before the thread started.
+ */
+void workerLoop(int thread, unsigned seen)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_wake.wait(lock, [&] { return _quit || _generation != seen; });
+		if (_quit)
+		{
+			return;
+		}
+		seen = _generation;
+		lock.unlock();
+		work(thread);
+		lock.lock();
+		if (--_busy == 0)
+		{
+			_finished.notify_one();
+		}
+	}
+}
+
+/**
+ * Owns the worker threads, so they get stopped on any kind of exit.
+ */
+struct Workers
+{
+	std::vector<std::thread> threads;
+
+	~Workers()
+	{
+		stop();
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_quit = true;
+		}
+		_wake.notify_all();
+		for (auto &t : threads)
+		{
+			t.join();
+		}
+		threads.clear();
+		_quit = false;
+	}
+
+	void start(int count)
+	{
+		for (int i = 1; i <= count; ++i)
+		{
+			threads.push_back(std::thread(workerLoop, i, _generation));
+		}
+	}
+};
+
+Workers _workers;
+
+}
+
+/**
+ * Gets the number of threads that share parallel work. It's set by
+ * the "oxceWorkerThreads" option, with 0 using the number of CPU cores.
+ * @return Number of threads, at least 1.
+ */
+int getThreadCount()
+{
+	int threads = Options::oxceWorkerThreads;
+	if (threads <= 0)
+	{
+		threads = std::min<int>(std::thread::hardware_concurrency(), MAX_AUTO_THREADS);
+	}
+	return std::max(threads, 1);
+}
+
+/**
+ * Runs a function for every index in [0, count). The items are handed out
+ * to the threads in no particular order, so the function must only write to
+ * data belonging to its index (or to its thread). Returns when all of them
+ * are done. Nested calls, or calls while another thread is already using
+ * the workers, simply run the loop in place on the current thread.
+ * @param count Number of work items.
+ * @param func Function called with the item index and the thread index,
+ * where the calling thread is 0.
+ */
+void forEach(size_t count, const std::function<void(size_t index, int thread)> &func)
+{
+	int threads = getThreadCount();
+	std::unique_lock<std::mutex> jobLock(_jobMutex, std::defer_lock);
+	if (threads == 1 || count < 2 || _thread != -1 || !jobLock.try_lock())
+	{
+		int thread = std::max(_thread, 0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			func(i, thread);
+		}
+		return;
+	}
+
+	if ((int)_workers.threads.size() != threads - 1)
+	{
+		_workers.stop();
+		_workers.start(threads - 1);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_job = &func;
+		_jobSize = count;
+		_next = 0;
+		_busy = threads - 1;
+		_error = nullptr;
+		++_generation;
+	}
+	_wake.notify_all();
+	work(0);
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_finished.wait(lock, [] { return _busy == 0; });
+		_job = 0;
+		std::swap(error, _error);
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+/**
+ * Stops the worker threads, they get started again when needed.
+ */
+void quit()
+{
+	std::lock_guard<std::mutex> jobLock(_jobMutex);
+	_workers.stop();
+}
+
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <functional>
+#include <stddef.h>
+
+namespace OpenXcom
+{
+
+/**
+ * A small pool of worker threads for splitting independent work items.
+ * The calling thread always takes part in the work, so with one thread
+ * everything runs in place exactly like a normal loop.
+ */
+namespace Parallel
+{
+	/// Gets the number of threads that share the work, including the caller.
+	int getThreadCount();
+	/// Runs a function for every index in [0, count), spread over the threads.
+	void forEach(size_t count, const std::function<void(size_t index, int thread)> &func);
+	/// Stops the worker threads.
+	void quit();
+}
+
+}
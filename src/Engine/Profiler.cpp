@@ -0,0 +1,151 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <iomanip>
+
+namespace OpenXcom
+{
+
+namespace Profiler
+{
+
+bool enabled = false;
+
+namespace
+{
+
+struct TimerEntry
+{
+	uint64_t total = 0;
+	uint64_t max = 0;
+	int64_t samples = 0;
+};
+
+std::mutex _mutex;
+std::map<std::string, int64_t> _counters;
+std::map<std::string, TimerEntry> _timers;
+
+}
+
+/**
+ * Gets a monotonic timestamp, not affected by changes of the system clock.
+ * @return Microseconds since an unspecified point in time.
+ */
+uint64_t now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Adds a value to a named counter. Safe to call from worker threads.
+ * @param name Name of the counter.
+ * @param value Value to add.
+ */
+void addCount(const char *name, int64_t value)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_counters[name] += value;
+}
+
+/**
+ * Adds a timed sample to a named timer. Samples for a specific object
+ * are stored in a separate timer named "name[id]" as well as in the total.
+ * @param name Name of the timer.
+ * @param id Object id, or -1 for none.
+ * @param micro Duration of the sample in microseconds.
+ */
+void addTime(const char *name, int id, uint64_t micro)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto add = [&](TimerEntry &entry)
+	{
+		entry.total += micro;
+		entry.max = std::max(entry.max, micro);
+		entry.samples += 1;
+	};
+	add(_timers[name]);
+	if (id != -1)
+	{
+		add(_timers[std::string(name) + "[" + std::to_string(id) + "]"]);
+	}
+}
+
+/**
+ * Gets the current value of a named counter.
+ * @param name Name of the counter.
+ * @return Counter value, zero if it was never touched.
+ */
+int64_t getCount(const char *name)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _counters.find(name);
+	return it != _counters.end() ? it->second : 0;
+}
+
+/**
+ * Gets the accumulated time of a named timer.
+ * @param name Name of the timer.
+ * @return Total microseconds, zero if it was never touched.
+ */
+uint64_t getTime(const char *name)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _timers.find(name);
+	return it != _timers.end() ? it->second.total : 0;
+}
+
+/**
+ * Clears all the counters and timers.
+ */
+void reset()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_counters.clear();
+	_timers.clear();
+}
+
+/**
+ * Writes all the counters and timers, one per line.
+ * @param out Stream to write to.
+ */
+void report(std::ostream &out)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (auto& c : _counters)
+	{
+		out << std::left << std::setw(48) << c.first << " count=" << c.second << std::endl;
+	}
+	for (auto& t : _timers)
+	{
+		out << std::left << std::setw(48) << t.first
+			<< " total=" << std::fixed << std::setprecision(3) << t.second.total / 1000.0 << "ms"
+			<< " calls=" << t.second.samples
+			<< " avg=" << t.second.total / 1000.0 / t.second.samples << "ms"
+			<< " max=" << t.second.max / 1000.0 << "ms" << std::endl;
+	}
+}
+
+}
+
+}
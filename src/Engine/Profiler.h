@@ -0,0 +1,83 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ostream>
+#include <stdint.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Named counters and timers for measuring the game logic.
+ * Collection is off by default, so the hooks in the engine
+ * only cost a flag check during normal play.
+ */
+namespace Profiler
+{
+	/// Is the collection of counters turned on?
+	extern bool enabled;
+
+	/// Gets a monotonic timestamp in microseconds.
+	uint64_t now();
+	/// Adds a value to a named counter.
+	void addCount(const char *name, int64_t value);
+	/// Adds a timed sample to a named timer.
+	void addTime(const char *name, int id, uint64_t micro);
+	/// Gets the current value of a named counter.
+	int64_t getCount(const char *name);
+	/// Gets the accumulated microseconds of a named timer.
+	uint64_t getTime(const char *name);
+	/// Clears all counters and timers.
+	void reset();
+	/// Writes all counters and timers, sorted by name.
+	void report(std::ostream &out);
+
+	/**
+	 * Adds a value to a named counter when profiling is on.
+	 * @param name Static name of the counter.
+	 * @param value Value to add.
+	 */
+	inline void count(const char *name, int64_t value = 1)
+	{
+		if (enabled)
+		{
+			addCount(name, value);
+		}
+	}
+
+	/**
+	 * Measures the lifetime of the object as a sample of a named timer.
+	 */
+	class Scope
+	{
+		const char *_name;
+		int _id;
+		bool _active;
+		uint64_t _start;
+	public:
+		/// Starts measuring, optionally for a single object (eg. unit id).
+		Scope(const char *name, int id = -1) : _name(name), _id(id), _active(enabled), _start(_active ? now() : 0) { }
+		/// Stops measuring and stores the sample.
+		~Scope() { if (_active) addTime(_name, _id, now() - _start); }
+		Scope(const Scope&) = delete;
+		Scope &operator=(const Scope&) = delete;
+	};
+}
+
+}
@@ -22,6 +22,7 @@
 #define __HQX_H_
 
 #include <stdint.h>
+#include <limits.h>
 
 #if 0 /*defined( __GNUC__ )*/
 #ifdef __MINGW32__
@@ -48,8 +49,8 @@ HQX_API void HQX_CALLCONV hq2x_32(const uint32_t* src, uint32_t* dest, int width
 HQX_API void HQX_CALLCONV hq3x_32(const uint32_t* src, uint32_t* dest, int width, int height );
 HQX_API void HQX_CALLCONV hq4x_32(const uint32_t* src, uint32_t* dest, int width, int height );
 
-HQX_API void HQX_CALLCONV hq2x_32_rb(const uint32_t* src, uint32_t src_rowBytes, uint32_t* dest, uint32_t dest_rowBytes, int width, int height );
-HQX_API void HQX_CALLCONV hq3x_32_rb(const uint32_t* src, uint32_t src_rowBytes, uint32_t* dest, uint32_t dest_rowBytes, int width, int height );
-HQX_API void HQX_CALLCONV hq4x_32_rb(const uint32_t* src, uint32_t src_rowBytes, uint32_t* dest, uint32_t dest_rowBytes, int width, int height );
+HQX_API void HQX_CALLCONV hq2x_32_rb(const uint32_t* src, uint32_t src_rowBytes, uint32_t* dest, uint32_t dest_rowBytes, int width, int height, int yFirst = 0, int yLast = INT_MAX );
+HQX_API void HQX_CALLCONV hq3x_32_rb(const uint32_t* src, uint32_t src_rowBytes, uint32_t* dest, uint32_t dest_rowBytes, int width, int height, int yFirst = 0, int yLast = INT_MAX );
+HQX_API void HQX_CALLCONV hq4x_32_rb(const uint32_t* src, uint32_t src_rowBytes, uint32_t* dest, uint32_t dest_rowBytes, int width, int height, int yFirst = 0, int yLast = INT_MAX );
 
 #endif
@@ -499,3 +499,116 @@ void scale(unsigned scale, void* void_dst, unsigned dst_slice, const void* void_
 	}
 }
 
+
+/**
+ * Apply the Scale effect on a horizontal band of a bitmap.
+ * Only the destination rows of the source rows [first, last) are written,
+ * but the whole source bitmap is read, so the result is exactly the same as
+ * the matching part of ::scale(). Different bands can be done at the same time.
+ * \param scale Scale factor. 2, 203 (fox 2x3), 204 (for 2x4), 3 or 4.
+ * \param void_dst Pointer at the first pixel of the destination bitmap.
+ * \param dst_slice Size in bytes of a destination bitmap row.
+ * \param void_src Pointer at the first pixel of the source bitmap.
+ * \param src_slice Size in bytes of a source bitmap row.
+ * \param pixel Bytes per pixel of the source and destination bitmap.
+ * \param width Horizontal size in pixels of the source bitmap.
+ * \param height Vertical size in pixels of the source bitmap.
+ * \param first First source row of the band.
+ * \param last Source row after the end of the band.
+ */
+void scale_part(unsigned scale, void* void_dst, unsigned dst_slice, const void* void_src, unsigned src_slice, unsigned pixel, unsigned width, unsigned height, unsigned first, unsigned last)
+{
+	const unsigned char* src = (const unsigned char*)void_src;
+	unsigned char* dst;
+	unsigned char* mid[6];
+	unsigned char* buf = 0;
+	unsigned mid_slice = 0;
+	unsigned rows;
+	unsigned y;
+
+	if (last > height)
+		last = height;
+	if (first >= last)
+		return;
+
+	switch (scale) {
+	case 203 :
+	case 303 :
+	case 3 :
+		rows = 3;
+		break;
+	case 204 :
+	case 404 :
+	case 4 :
+		rows = 4;
+		break;
+	default :
+		rows = 2;
+		break;
+	}
+
+	if (rows == 4 && scale != 204) {
+		/* scale2x of the source rows y-1, y and y+1, two rows each */
+		mid_slice = 2 * pixel * width;
+		mid_slice = (mid_slice + 0x7) & ~0x7;
+		buf = (unsigned char*)malloc(6 * mid_slice);
+		if (!buf)
+			return;
+		for (y = 0; y < 6; ++y)
+			mid[y] = buf + y * mid_slice;
+	}
+
+	for (y = first; y < last; ++y) {
+		const unsigned char* src0 = SCSRC(y > 0 ? y - 1 : 0);
+		const unsigned char* src1 = SCSRC(y);
+		const unsigned char* src2 = SCSRC(y < height - 1 ? y + 1 : height - 1);
+		dst = (unsigned char*)void_dst + y * rows * dst_slice;
+
+		switch (scale) {
+		case 202 :
+		case 2 :
+			stage_scale2x(SCDST(0), SCDST(1), src0, src1, src2, pixel, width);
+			break;
+		case 203 :
+			stage_scale2x3(SCDST(0), SCDST(1), SCDST(2), src0, src1, src2, pixel, width);
+			break;
+		case 204 :
+			stage_scale2x4(SCDST(0), SCDST(1), SCDST(2), SCDST(3), src0, src1, src2, pixel, width);
+			break;
+		case 303 :
+		case 3 :
+			stage_scale3x(SCDST(0), SCDST(1), SCDST(2), src0, src1, src2, pixel, width);
+			break;
+		case 404 :
+		case 4 : {
+			/* the buffer rows of source row i are mid[2*(i%3)] and mid[2*(i%3)+1] */
+			unsigned i;
+			unsigned char** cur;
+			unsigned char** prev;
+			unsigned char** next;
+			if (y == first) {
+				for (i = (y > 0 ? y - 1 : 0); i <= y; ++i) {
+					stage_scale2x(mid[2 * (i % 3)], mid[2 * (i % 3) + 1], SCSRC(i > 0 ? i - 1 : 0), SCSRC(i), SCSRC(i < height - 1 ? i + 1 : height - 1), pixel, width);
+				}
+			}
+			if (y < height - 1) {
+				i = y + 1;
+				stage_scale2x(mid[2 * (i % 3)], mid[2 * (i % 3) + 1], src1, src2, SCSRC(i < height - 1 ? i + 1 : height - 1), pixel, width);
+			}
+			cur = &mid[2 * (y % 3)];
+			prev = &mid[2 * ((y + 2) % 3)];
+			next = &mid[2 * ((y + 1) % 3)];
+			stage_scale4x(SCDST(0), SCDST(1), SCDST(2), SCDST(3),
+				y > 0 ? prev[1] : cur[0], cur[0], cur[1], y < height - 1 ? next[0] : cur[1],
+				pixel, width);
+			break;
+		}
+		}
+	}
+
+	free(buf);
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	scale2x_mmx_emms();
+#endif
+}
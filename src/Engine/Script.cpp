@@ -32,6 +32,7 @@
 #include "Surface.h"
 #include "ShaderDraw.h"
 #include "ShaderMove.h"
+#include "ShaderKernels.h"
 #include "Exception.h"
 #include "../fallthrough.h"
 #include "Collections.h"
@@ -525,7 +526,14 @@ void ScriptWorkerBlit::executeBlit(Surface* src, Surface* dest, int x, int y, in
 	}
 	else
 	{
-		ShaderDraw<helper::StandardShade>(destShader, srcShader, ShaderScalar(shade));
+		ShaderDrawRows(
+			[&](int size, Uint8* destRow, const Uint8* srcRow)
+			{
+				ShaderKernels::shadeRow(destRow, srcRow, size, shade);
+			},
+			destShader,
+			srcShader
+		);
 	}
 }
 
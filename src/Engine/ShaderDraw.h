@@ -31,12 +31,12 @@ static inline First&& GetFirst(First&& f, Rest&&... r)
 }
 
 /**
- * Universal blit function implementation.
- * @param f called function.
+ * Universal blit function implementation, iterating over rows.
+ * @param row called function, gets the row length and all control objects.
  * @param src source surfaces control objects.
  */
-template<typename Func, typename... SrcType>
-static inline void ShaderDrawImpl(Func&& f, helper::controler<SrcType>... src)
+template<typename RowFunc, typename... SrcType>
+static inline void ShaderDrawRowsImpl(RowFunc&& row, helper::controler<SrcType>... src)
 {
 	//get basic draw range in 2d space
 	GraphSubset end_temp = GetFirst(src...).get_range();
@@ -77,28 +77,44 @@ static inline void ShaderDrawImpl(Func&& f, helper::controler<SrcType>... src)
 		//set final iteration range
 		(src.set_x(begin_x, end_x), ...);
 
-		int size_x = end_x-begin_x;
-		//iteration on x-axis
-		for (int x = size_x / 4; x>0; --x)
-		{
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-		}
-		if (size_x & 2)
-		{
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-		}
-		if (size_x & 1)
-		{
-			f(src.get_ref()...); (src.inc_x(), ...);
-		}
+		row(end_x-begin_x, src...);
 	}
 
 };
 
+/**
+ * Universal blit function implementation.
+ * @param f called function.
+ * @param src source surfaces control objects.
+ */
+template<typename Func, typename... SrcType>
+static inline void ShaderDrawImpl(Func&& f, helper::controler<SrcType>... src)
+{
+	ShaderDrawRowsImpl(
+		[&](int size_x, helper::controler<SrcType>&... s)
+		{
+			//iteration on x-axis
+			for (int x = size_x / 4; x>0; --x)
+			{
+				f(s.get_ref()...); (s.inc_x(), ...);
+				f(s.get_ref()...); (s.inc_x(), ...);
+				f(s.get_ref()...); (s.inc_x(), ...);
+				f(s.get_ref()...); (s.inc_x(), ...);
+			}
+			if (size_x & 2)
+			{
+				f(s.get_ref()...); (s.inc_x(), ...);
+				f(s.get_ref()...); (s.inc_x(), ...);
+			}
+			if (size_x & 1)
+			{
+				f(s.get_ref()...); (s.inc_x(), ...);
+			}
+		},
+		src...
+	);
+};
+
 /**
  * Universal blit function.
  * @tparam ColorFunc class that contains static function `func`.
@@ -122,6 +138,19 @@ static inline void ShaderDrawFunc(Func&& f, const SrcType&... src_frame)
 	ShaderDrawImpl(std::forward<Func>(f), helper::controler<SrcType>(src_frame)...);
 }
 
+/**
+ * Blit function working on whole rows at once.
+ * Pixels of a row have to be next to each other in memory, so it only
+ * takes plain surfaces like `ShaderBase` or `ShaderMove`, not scalars.
+ * @param f function called with the row length and a pointer to the first pixel of the row in every surface.
+ * @param src_frame destination and source surfaces modified by function.
+ */
+template<typename Func, typename... SrcType>
+static inline void ShaderDrawRows(Func&& f, const SrcType&... src_frame)
+{
+	ShaderDrawRowsImpl([&](int size_x, auto&... s){ f(size_x, &s.get_ref()...); }, helper::controler<SrcType>(src_frame)...);
+}
+
 namespace helper
 {
 
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ShaderKernels.h"
+#include <algorithm>
+#include "ShaderDraw.h"
+#include "Logger.h"
+#include "Zoom.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define OXCE_SHADER_KERNELS_X86
+#define OXCE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define OXCE_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define OXCE_SHADER_KERNELS_X86
+#define OXCE_TARGET_SSE41
+#define OXCE_TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+namespace OpenXcom
+{
+
+namespace ShaderKernels
+{
+
+namespace
+{
+
+typedef void (*ShadeRowFunc)(Uint8 *dest, const Uint8 *src, int count, int shade);
+typedef void (*ColorReplaceRowFunc)(Uint8 *dest, const Uint8 *src, int count, int shade, int newColor);
+
+void shadeRowInit(Uint8 *dest, const Uint8 *src, int count, int shade);
+void colorReplaceRowInit(Uint8 *dest, const Uint8 *src, int count, int shade, int newColor);
+
+/// Kernels in use, they pick the best level on the first call.
+ShadeRowFunc _shadeRow = shadeRowInit;
+ColorReplaceRowFunc _colorReplaceRow = colorReplaceRowInit;
+Level _level = LEVEL_SCALAR;
+
+void shadeRowScalar(Uint8 *dest, const Uint8 *src, int count, int shade)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		helper::StandardShade::func(dest[i], src[i], shade);
+	}
+}
+
+void colorReplaceRowScalar(Uint8 *dest, const Uint8 *src, int count, int shade, int newColor)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		helper::ColorReplace::func(dest[i], src[i], shade, newColor);
+	}
+}
+
+#ifdef OXCE_SHADER_KERNELS_X86
+
+OXCE_TARGET_SSE41 void shadeRowSSE41(Uint8 *dest, const Uint8 *src, int count, int shade)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i group = _mm_set1_epi8((char)helper::ColorGroup);
+	const __m128i black = _mm_set1_epi8((char)helper::ColorShade);
+	const __m128i add = _mm_set1_epi8((char)shade);
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		const __m128i transparent = _mm_cmpeq_epi8(s, zero);
+		if (_mm_movemask_epi8(transparent) == 0xFFFF)
+		{
+			continue;
+		}
+		const __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+		const __m128i n = _mm_add_epi8(s, add);
+		// so dark it would flip over to another color - make it black instead
+		const __m128i sameGroup = _mm_cmpeq_epi8(_mm_and_si128(_mm_xor_si128(n, s), group), zero);
+		const __m128i shaded = _mm_blendv_epi8(black, n, sameGroup);
+		_mm_storeu_si128((__m128i*)(dest + i), _mm_blendv_epi8(shaded, d, transparent));
+	}
+	shadeRowScalar(dest + i, src + i, count - i, shade);
+}
+
+OXCE_TARGET_SSE41 void colorReplaceRowSSE41(Uint8 *dest, const Uint8 *src, int count, int shade, int newColor)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i group = _mm_set1_epi8((char)helper::ColorGroup);
+	const __m128i black = _mm_set1_epi8((char)helper::ColorShade);
+	const __m128i add = _mm_set1_epi8((char)shade);
+	const __m128i color = _mm_set1_epi8((char)newColor);
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		const __m128i transparent = _mm_cmpeq_epi8(s, zero);
+		if (_mm_movemask_epi8(transparent) == 0xFFFF)
+		{
+			continue;
+		}
+		const __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+		const __m128i n = _mm_add_epi8(_mm_and_si128(s, black), add);
+		// so dark it would flip over to another color - make it black instead
+		const __m128i sameGroup = _mm_cmpeq_epi8(_mm_and_si128(n, group), zero);
+		const __m128i shaded = _mm_blendv_epi8(black, _mm_or_si128(n, color), sameGroup);
+		_mm_storeu_si128((__m128i*)(dest + i), _mm_blendv_epi8(shaded, d, transparent));
+	}
+	colorReplaceRowScalar(dest + i, src + i, count - i, shade, newColor);
+}
+
+OXCE_TARGET_AVX2 void shadeRowAVX2(Uint8 *dest, const Uint8 *src, int count, int shade)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i group = _mm256_set1_epi8((char)helper::ColorGroup);
+	const __m256i black = _mm256_set1_epi8((char)helper::ColorShade);
+	const __m256i add = _mm256_set1_epi8((char)shade);
+	int i = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+		const __m256i transparent = _mm256_cmpeq_epi8(s, zero);
+		if (_mm256_movemask_epi8(transparent) == -1)
+		{
+			continue;
+		}
+		const __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+		const __m256i n = _mm256_add_epi8(s, add);
+		// so dark it would flip over to another color - make it black instead
+		const __m256i sameGroup = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_xor_si256(n, s), group), zero);
+		const __m256i shaded = _mm256_blendv_epi8(black, n, sameGroup);
+		_mm256_storeu_si256((__m256i*)(dest + i), _mm256_blendv_epi8(shaded, d, transparent));
+	}
+	shadeRowSSE41(dest + i, src + i, count - i, shade);
+}
+
+OXCE_TARGET_AVX2 void colorReplaceRowAVX2(Uint8 *dest, const Uint8 *src, int count, int shade, int newColor)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i group = _mm256_set1_epi8((char)helper::ColorGroup);
+	const __m256i black = _mm256_set1_epi8((char)helper::ColorShade);
+	const __m256i add = _mm256_set1_epi8((char)shade);
+	const __m256i color = _mm256_set1_epi8((char)newColor);
+	int i = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+		const __m256i transparent = _mm256_cmpeq_epi8(s, zero);
+		if (_mm256_movemask_epi8(transparent) == -1)
+		{
+			continue;
+		}
+		const __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+		const __m256i n = _mm256_add_epi8(_mm256_and_si256(s, black), add);
+		// so dark it would flip over to another color - make it black instead
+		const __m256i sameGroup = _mm256_cmpeq_epi8(_mm256_and_si256(n, group), zero);
+		const __m256i shaded = _mm256_blendv_epi8(black, _mm256_or_si256(n, color), sameGroup);
+		_mm256_storeu_si256((__m256i*)(dest + i), _mm256_blendv_epi8(shaded, d, transparent));
+	}
+	colorReplaceRowSSE41(dest + i, src + i, count - i, shade, newColor);
+}
+
+#endif
+
+/**
+ * Picks the best level, then shades the row.
+ */
+void shadeRowInit(Uint8 *dest, const Uint8 *src, int count, int shade)
+{
+	setLevel(getSupportedLevel());
+	Log(LOG_INFO) << "Using " << getLevelName(_level) << " blit kernels.";
+	_shadeRow(dest, src, count, shade);
+}
+
+/**
+ * Picks the best level, then shades and recolors the row.
+ */
+void colorReplaceRowInit(Uint8 *dest, const Uint8 *src, int count, int shade, int newColor)
+{
+	setLevel(getSupportedLevel());
+	Log(LOG_INFO) << "Using " << getLevelName(_level) << " blit kernels.";
+	_colorReplaceRow(dest, src, count, shade, newColor);
+}
+
+}
+
+/**
+ * Gets the best kernels this CPU can run. Builds for other
+ * architectures only have the plain loops.
+ * @return Highest supported level.
+ */
+Level getSupportedLevel()
+{
+#ifdef OXCE_SHADER_KERNELS_X86
+	static const Level supported = Zoom::haveAVX2() ? LEVEL_AVX2 : Zoom::haveSSE41() ? LEVEL_SSE41 : LEVEL_SCALAR;
+	return supported;
+#else
+	return LEVEL_SCALAR;
+#endif
+}
+
+/**
+ * Gets the kernels in use.
+ * @return Current level.
+ */
+Level getLevel()
+{
+	return _level;
+}
+
+/**
+ * Switches the kernels, the benchmark uses it to compare them.
+ * @param level Wanted level, lowered to what the CPU supports.
+ */
+void setLevel(Level level)
+{
+	_level = std::min(level, getSupportedLevel());
+	switch (_level)
+	{
+#ifdef OXCE_SHADER_KERNELS_X86
+	case LEVEL_AVX2:
+		_shadeRow = shadeRowAVX2;
+		_colorReplaceRow = colorReplaceRowAVX2;
+		break;
+	case LEVEL_SSE41:
+		_shadeRow = shadeRowSSE41;
+		_colorReplaceRow = colorReplaceRowSSE41;
+		break;
+#endif
+	default:
+		_shadeRow = shadeRowScalar;
+		_colorReplaceRow = colorReplaceRowScalar;
+		break;
+	}
+}
+
+/**
+ * Gets the name of the kernels of a level, for the log.
+ * @param level Level.
+ * @return Name of the instruction set.
+ */
+const char *getLevelName(Level level)
+{
+	switch (level)
+	{
+	case LEVEL_AVX2:
+		return "AVX2";
+	case LEVEL_SSE41:
+		return "SSE4.1";
+	default:
+		return "scalar";
+	}
+}
+
+/**
+ * Shades a row of pixels. Transparent pixels are skipped, the rest
+ * get darker by the shade, turning black instead of changing color.
+ * @param dest Destination row.
+ * @param src Source row.
+ * @param count Number of pixels.
+ * @param shade Shade offset.
+ */
+void shadeRow(Uint8 *dest, const Uint8 *src, int count, int shade)
+{
+	_shadeRow(dest, src, count, shade);
+}
+
+/**
+ * Shades a row of pixels and moves them to another color group.
+ * @param dest Destination row.
+ * @param src Source row.
+ * @param count Number of pixels.
+ * @param shade Shade offset.
+ * @param newColor New color group, already shifted to the high bits.
+ */
+void colorReplaceRow(Uint8 *dest, const Uint8 *src, int count, int shade, int newColor)
+{
+	_colorReplaceRow(dest, src, count, shade, newColor);
+}
+
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <SDL_types.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Row kernels for the hot 8-bit blits of `ShaderDraw`, shading a whole row
+ * of pixels at once. The instruction set is picked at runtime from what the
+ * CPU supports, with a plain loop as fallback. Every level gives exactly the
+ * same pixels as the matching functor in `helper`.
+ */
+namespace ShaderKernels
+{
+	/// Instruction sets of the kernels.
+	enum Level { LEVEL_SCALAR, LEVEL_SSE41, LEVEL_AVX2, LEVEL_MAX };
+
+	/// Gets the best level this CPU and build support.
+	Level getSupportedLevel();
+	/// Gets the level used by the kernels.
+	Level getLevel();
+	/// Sets the level used by the kernels, up to the supported one.
+	void setLevel(Level level);
+	/// Gets the name of a level.
+	const char *getLevelName(Level level);
+
+	/// Shades a row of pixels, like helper::StandardShade.
+	void shadeRow(Uint8 *dest, const Uint8 *src, int count, int shade);
+	/// Shades and recolors a row of pixels, like helper::ColorReplace.
+	void colorReplaceRow(Uint8 *dest, const Uint8 *src, int count, int shade, int newColor);
+}
+
+}
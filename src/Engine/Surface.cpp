@@ -19,6 +19,7 @@
 #include "Surface.h"
 #include "ShaderDraw.h"
 #include "ShaderMove.h"
+#include "ShaderKernels.h"
 #include <vector>
 #include <algorithm>
 #include <SDL_gfxPrimitives.h>
@@ -355,6 +356,49 @@ void Surface::loadScr(const std::string& filename)
 	std::vector<char> buffer((std::istreambuf_iterator<char>(*(istream))), (std::istreambuf_iterator<char>()));
 	loadRaw(buffer);
 }
+/**
+ * Decodes an 8-bit PNG file with LodePNG, without touching any surface
+ * or reporting anything, so many files can be decoded on the worker threads
+ * at once. Anything else is left to loadImage(), which falls back to SDL_Image.
+ * @param filename Filename of the image.
+ * @return The decoded image.
+ */
+Surface::DecodedImage Surface::decodeImage(const std::string &filename)
+{
+	DecodedImage image;
+	image.filename = filename;
+	std::string data;
+	if (!CrossPlatform::compareExt(filename, "png") || !FileMap::fileExists(filename) || !FileMap::at(filename)->tryGetText(data))
+	{
+		return image;
+	}
+	if (data.size() > 8 + 12 + 12) // minimal PNG file size: header and two empty chunks
+	{
+		lodepng::State state;
+		state.decoder.color_convert = 0;
+		unsigned error = lodepng::decode(image.pixels, image.width, image.height, state, (const unsigned char*)data.data(), data.size());
+		if (!error)
+		{
+			LodePNGColorMode *color = &state.info_png.color;
+			if (lodepng_get_bpp(color) == 8)
+			{
+				image.palette.resize(color->palettesize);
+				memcpy(image.palette.data(), color->palette, color->palettesize * sizeof(SDL_Color));
+				image.decoded = true;
+			}
+		}
+		else
+		{
+			image.error = lodepng_error_text(error);
+		}
+	}
+	if (!image.decoded)
+	{
+		image.pixels.clear();
+	}
+	return image;
+}
+
 /**
  * Loads the contents of an image file of a
  * known format into the surface.
@@ -362,96 +406,83 @@ void Surface::loadScr(const std::string& filename)
  */
 void Surface::loadImage(const std::string &filename)
 {
+	loadImage(decodeImage(filename));
+}
+
+/**
+ * Loads an image decoded ahead of time into the surface.
+ * Images LodePNG couldn't decode are loaded by SDL_Image instead.
+ * @param image The decoded image.
+ */
+void Surface::loadImage(const DecodedImage &image)
+{
+	const std::string &filename = image.filename;
+
 	// Destroy current surface (will be replaced)
 	_alignedBuffer = nullptr;
 	_surface = nullptr;
 
 	Log(LOG_VERBOSE) << "Loading image: " << filename;
-	auto rw = FileMap::getRWops(filename);
-	if (!rw) { return; } // relevant message gets logged in FileMap.
 
-	// Try loading with LodePNG first
-	if (CrossPlatform::compareExt(filename, "png"))
+	// Try the LodePNG result first
+	if (image.decoded)
 	{
-		size_t size;
-		void *data = SDL_LoadFile_RW(rw, &size, SDL_FALSE);
-		if ((data != NULL) && (size > 8 + 12 + 12)) // minimal PNG file size: header and two empty chunks
+		unsigned width = image.width, height = image.height;
+		*this = Surface(width, height, 0, 0);
+		setPalette(image.palette.data(), 0, (int)image.palette.size());
+
+		ShaderDrawFunc(
+			[](Uint8& dest, const unsigned char& src)
+			{
+				dest = src;
+			},
+			ShaderSurface(this),
+			ShaderSurface(SurfaceRaw<const unsigned char>(image.pixels, width, height))
+		);
+		int transparent = 0;
+		for (int c = 0; c < _surface->format->palette->ncolors; ++c)
 		{
-			std::vector<unsigned char> png;
-			png.resize(size);
-			memcpy(&png[0], data, size);
-
-			std::vector<unsigned char> image;
-			unsigned width, height;
-			lodepng::State state;
-			state.decoder.color_convert = 0;
-			unsigned error = lodepng::decode(image, width, height, state, png);
-			if (!error)
+			SDL_Color *palColor = _surface->format->palette->colors + c;
+			if (palColor->unused == 0)
 			{
-				LodePNGColorMode *color = &state.info_png.color;
-				unsigned bpp = lodepng_get_bpp(color);
-				if (bpp == 8)
-				{
-					*this = Surface(width, height, 0, 0);
-					setPalette((SDL_Color*)color->palette, 0, color->palettesize);
-
-					ShaderDrawFunc(
-						[](Uint8& dest, unsigned char& src)
-						{
-							dest = src;
-						},
-						ShaderSurface(this),
-						ShaderSurface(SurfaceRaw<unsigned char>(image, width, height))
-					);
-					int transparent = 0;
-					for (int c = 0; c < _surface->format->palette->ncolors; ++c)
-					{
-						SDL_Color *palColor = _surface->format->palette->colors + c;
-						if (palColor->unused == 0)
-						{
-							transparent = c;
-							break;
-						}
-					}
-					FixTransparent(_surface, transparent);
-					if (transparent != 0)
-					{
-						Log(LOG_WARNING) << "Image " << filename << " (from lodepng) has incorrect transparent color index " << transparent << " (instead of 0).";
-					}
-				}
-			} else {
-				Log(LOG_ERROR) << "Image " << filename << " lodepng failed:" << lodepng_error_text(error);
+				transparent = c;
+				break;
 			}
 		}
-		if (data) { SDL_free(data); }
+		FixTransparent(_surface, transparent);
+		if (transparent != 0)
+		{
+			Log(LOG_WARNING) << "Image " << filename << " (from lodepng) has incorrect transparent color index " << transparent << " (instead of 0).";
+		}
+		return;
 	}
-	if (_surface)
+	if (!image.error.empty())
 	{
-		SDL_RWclose(rw);
+		Log(LOG_ERROR) << "Image " << filename << " lodepng failed:" << image.error;
 	}
-	else // Otherwise default to SDL_Image
+
+	// Otherwise default to SDL_Image
+	auto rw = FileMap::getRWops(filename);
+	if (!rw) { return; } // relevant message gets logged in FileMap.
+	auto surface = NewSdlSurface(IMG_Load_RW(rw, SDL_TRUE));
+	if (!surface)
 	{
-		SDL_RWseek(rw, RW_SEEK_SET, 0); // rewind in case .png was no PNG at all
-		auto surface = NewSdlSurface(IMG_Load_RW(rw, SDL_TRUE));
-		if (!surface)
-		{
-			std::string err = filename + ":" + IMG_GetError();
-			throw Exception(err);
-		}
-		if (surface->format->BitsPerPixel != 8)
-		{
-			std::string err = filename + ": OpenXcom supports only 8bit images.";
-			throw Exception(err);
-		}
+		std::string err = filename + ":" + IMG_GetError();
+		throw Exception(err);
+	}
+	if (surface->format->BitsPerPixel != 8)
+	{
+		std::string err = filename + ": OpenXcom supports only 8bit images.";
+		throw Exception(err);
+	}
 
-		*this = Surface(surface->w, surface->h, 0, 0);
-		setPalette(surface->format->palette->colors, 0, surface->format->palette->ncolors);
-		RawCopySurf(_surface, surface);
-		FixTransparent(_surface, surface->format->colorkey);
-		if (surface->format->colorkey != 0)
-		{
-			Log(LOG_WARNING) << "Image " << filename << " (from SDL) has incorrect transparent color index " << surface->format->colorkey << " (instead of 0).";
-		}
+	*this = Surface(surface->w, surface->h, 0, 0);
+	setPalette(surface->format->palette->colors, 0, surface->format->palette->ncolors);
+	RawCopySurf(_surface, surface);
+	FixTransparent(_surface, surface->format->colorkey);
+	if (surface->format->colorkey != 0)
+	{
+		Log(LOG_WARNING) << "Image " << filename << " (from SDL) has incorrect transparent color index " << surface->format->colorkey << " (instead of 0).";
 	}
 }
 
@@ -953,11 +984,23 @@ void Surface::blitRaw(SurfaceRaw<Uint8> destSurf, SurfaceRaw<const Uint8> srcSur
 	{
 		--newBaseColor;
 		newBaseColor <<= 4;
-		ShaderDraw<helper::ColorReplace>(ShaderSurface(destSurf), src, ShaderScalar(shade), ShaderScalar(newBaseColor));
+		ShaderDrawRows(
+			[&](int size, Uint8* dest, const Uint8* source)
+			{
+				ShaderKernels::colorReplaceRow(dest, source, size, shade, newBaseColor);
+			},
+			ShaderSurface(destSurf), src
+		);
 	}
 	else
 	{
-		ShaderDraw<helper::StandardShade>(ShaderSurface(destSurf), src, ShaderScalar(shade));
+		ShaderDrawRows(
+			[&](int size, Uint8* dest, const Uint8* source)
+			{
+				ShaderKernels::shadeRow(dest, source, size, shade);
+			},
+			ShaderSurface(destSurf), src
+		);
 	}
 }
 
@@ -992,7 +1035,13 @@ void Surface::blitNShade(SurfaceRaw<Uint8> surface, int x, int y, int shade, Gra
 
 	dest.setDomain(range);
 
-	ShaderDraw<helper::StandardShade>(dest, src, ShaderScalar(shade));
+	ShaderDrawRows(
+		[&](int size, Uint8* destRow, const Uint8* srcRow)
+		{
+			ShaderKernels::shadeRow(destRow, srcRow, size, shade);
+		},
+		dest, src
+	);
 }
 
 /**
@@ -81,6 +81,23 @@ public:
 	/// Zero whole surface.
 	static void CleanSdlSurface(SDL_Surface* surface);
 
+	/**
+	 * An image file decoded ahead of time, waiting to be loaded into a surface.
+	 */
+	struct DecodedImage
+	{
+		std::string filename;
+		std::vector<unsigned char> pixels;
+		std::vector<SDL_Color> palette;
+		unsigned width = 0, height = 0;
+		/// Decoder error, if any.
+		std::string error;
+		/// Was it decoded? If not, loading falls back to SDL_Image.
+		bool decoded = false;
+	};
+	/// Decodes an 8-bit PNG file, safe to use from worker threads.
+	static DecodedImage decodeImage(const std::string &filename);
+
 protected:
 	UniqueBufferPtr _alignedBuffer;
 	UniqueSurfacePtr _surface;
@@ -129,6 +146,8 @@ public:
 	void loadBdy(const std::string &filename);
 	/// Loads a general image file.
 	void loadImage(const std::string &filename);
+	/// Loads an image decoded ahead of time.
+	void loadImage(const DecodedImage &image);
 	/// Clears the surface's contents with a specified colour.
 	void clear();
 	/// Offsets the surface's colors by a set amount.
@@ -17,14 +17,76 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "SurfaceSet.h"
+#include <algorithm>
+#include <assert.h>
 #include <climits>
+#include <iterator>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
 #include "Surface.h"
 #include "Exception.h"
 #include "FileMap.h"
+#include "Logger.h"
+#include "Options.h"
+#include "Profiler.h"
 
 namespace OpenXcom
 {
 
+namespace
+{
+
+/// All the sets alive, for trimming the cache.
+std::unordered_set<SurfaceSet*> _allSets;
+/// Counts the frame uses, for finding the least recently used ones.
+Uint64 _cacheTick = 0;
+/// Are the frames decoded now allowed to be dropped?
+bool _cacheActive = false;
+
+/**
+ * Checks that the sets and the cache above are only used by the thread
+ * that made the first set, the main one. The worker threads only ever
+ * decode images, never frames of a set.
+ * @return True on the main thread.
+ */
+bool isMainThread()
+{
+	static const std::thread::id mainThread = std::this_thread::get_id();
+	return std::this_thread::get_id() == mainThread;
+}
+
+/**
+ * Finds where the next frame starts in PCK data, reading
+ * it the same way the decoder does.
+ * @param data PCK data.
+ * @param pos Start of the frame.
+ * @return Start of the next frame.
+ */
+size_t skipPckFrame(const std::vector<Uint8> &data, size_t pos)
+{
+	if (pos >= data.size())
+	{
+		return pos;
+	}
+	++pos; // empty rows
+	while (pos < data.size())
+	{
+		Uint8 value = data[pos++];
+		if (value == 255)
+		{
+			break;
+		}
+		if (value == 254 && pos < data.size())
+		{
+			++pos;
+		}
+	}
+	return pos;
+}
+
+}
+
 /**
  * Sets up a new empty surface set for frames of the specified size.
  * @param width Frame width in pixels.
@@ -32,7 +94,32 @@ namespace OpenXcom
  */
 SurfaceSet::SurfaceSet(int width, int height) : _width(width), _height(height), _sharedFrames(INT_MAX)
 {
+	assert(isMainThread());
+	_allSets.insert(this);
+}
+
+/**
+ * Copies the frames of an existing set.
+ * @param other Set to copy.
+ */
+SurfaceSet::SurfaceSet(const SurfaceSet& other) :
+	_frames(other._frames), _width(other._width), _height(other._height), _sharedFrames(other._sharedFrames),
+	_pck(other._pck), _lazy(other._lazy), _palette(other._palette), _paletteSet(other._paletteSet)
+{
+	assert(isMainThread());
+	_allSets.insert(this);
+}
 
+/**
+ * Takes over the frames of an existing set.
+ * @param other Set to move from.
+ */
+SurfaceSet::SurfaceSet(SurfaceSet&& other) :
+	_frames(std::move(other._frames)), _width(other._width), _height(other._height), _sharedFrames(other._sharedFrames),
+	_pck(std::move(other._pck)), _lazy(std::move(other._lazy)), _palette(std::move(other._palette)), _paletteSet(std::move(other._paletteSet))
+{
+	assert(isMainThread());
+	_allSets.insert(this);
 }
 
 /**
@@ -40,7 +127,8 @@ SurfaceSet::SurfaceSet(int width, int height) : _width(width), _height(height),
  */
 SurfaceSet::~SurfaceSet()
 {
-
+	assert(isMainThread());
+	_allSets.erase(this);
 }
 
 /**
@@ -55,6 +143,7 @@ SurfaceSet::~SurfaceSet()
 void SurfaceSet::loadPck(const std::string &pck, const std::string &tab)
 {
 	_frames.clear();
+	_lazy.clear();
 
 	int nframes = 0;
 
@@ -79,54 +168,90 @@ void SurfaceSet::loadPck(const std::string &pck, const std::string &tab)
 		{
 			nframes = size / 4;
 		}
-		for (int frame = 0; frame < nframes; ++frame)
-		{
-			_frames.push_back(Surface(_width, _height));
-		}
 	}
 	else
 	{
 		nframes = 1;
-		_frames.push_back(Surface(_width, _height));
 	}
 
+	// keep the compressed data, the frames get decoded when used
 	auto imgFile = FileMap::getIStream(pck);
-	Uint8 value;
-
+	auto data = std::make_shared<std::vector<Uint8> >(std::istreambuf_iterator<char>(*imgFile), std::istreambuf_iterator<char>());
+	_pck = data;
+	_frames.resize(nframes);
+	_lazy.resize(nframes);
+	size_t pos = 0;
 	for (int frame = 0; frame < nframes; ++frame)
 	{
-		int x = 0, y = 0;
-
-		// Lock the surface
-		_frames[frame].lock();
+		_lazy[frame].offset = (Uint32)pos;
+		_lazy[frame].lastUse = 0;
+		pos = skipPckFrame(*data, pos);
+	}
+}
 
-		imgFile->read((char*)&value, 1);
-		for (int i = 0; i < value; ++i)
+/**
+ * Decodes a frame from the PCK data, with the palette set so far.
+ * While the cache is active, the frame can be dropped again later.
+ * @param i Frame number in the set.
+ */
+void SurfaceSet::decodeFrame(int i)
+{
+	assert(isMainThread());
+	Profiler::count("SurfaceSet::getFrame cache misses");
+	const std::vector<Uint8> &data = *_pck;
+	Surface &frame = _frames[i];
+	frame = Surface(_width, _height);
+	for (int c = 0; c < (int)_paletteSet.size(); )
+	{
+		int first = c;
+		while (c < (int)_paletteSet.size() && _paletteSet[c])
 		{
-			for (int j = 0; j < _width; ++j)
-			{
-				_frames[frame].setPixelIterative(&x, &y, 0);
-			}
+			++c;
+		}
+		if (c > first)
+		{
+			frame.setPalette(&_palette[first], first, c - first);
 		}
+		++c;
+	}
 
-		while (imgFile->read((char*)&value, 1) && value != 255)
+	frame.lock();
+	size_t pos = _lazy[i].offset;
+	if (pos < data.size())
+	{
+		int x = 0, y = data[pos++];
+		while (pos < data.size())
 		{
+			Uint8 value = data[pos++];
+			if (value == 255)
+			{
+				break;
+			}
 			if (value == 254)
 			{
-				imgFile->read((char*)&value, 1);
-				for (int i = 0; i < value; ++i)
+				if (pos < data.size())
 				{
-					_frames[frame].setPixelIterative(&x, &y, 0);
+					x += data[pos++];
+					y += x / _width;
+					x %= _width;
 				}
 			}
 			else
 			{
-				_frames[frame].setPixelIterative(&x, &y, value);
+				frame.setPixelIterative(&x, &y, value);
 			}
 		}
+	}
+	frame.unlock();
 
-		// Unlock the surface
-		_frames[frame].unlock();
+	if (_cacheActive)
+	{
+		_lazy[i].lastUse = ++_cacheTick;
+	}
+	else
+	{
+		// anything used while loading could still get changed
+		_lazy[i].offset = RESIDENT;
 	}
 }
 
@@ -193,6 +318,17 @@ Surface *SurfaceSet::getFrame(int i)
 	{
 		if (_frames[i])
 		{
+			if ((size_t)i < _lazy.size() && _lazy[i].lastUse != 0)
+			{
+				assert(isMainThread());
+				Profiler::count("SurfaceSet::getFrame cache hits");
+				_lazy[i].lastUse = ++_cacheTick;
+			}
+			return &_frames[i];
+		}
+		if ((size_t)i < _lazy.size() && _lazy[i].offset != RESIDENT)
+		{
+			decodeFrame(i);
 			return &_frames[i];
 		}
 	}
@@ -215,10 +351,28 @@ Surface *SurfaceSet::addFrame(int i)
 	{
 		_frames.resize(i + 1);
 	}
+	if (!_lazy.empty())
+	{
+		_lazy.resize(_frames.size(), LazyFrame{ RESIDENT, 0 });
+		_lazy[i] = LazyFrame{ RESIDENT, 0 };
+	}
 	_frames[i] = Surface(_width, _height);
 	return &_frames[i];
 }
 
+/**
+ * Keeps a frame in memory for good, so any changes made
+ * to it after loading don't get lost by trimCache().
+ * @param i Frame number in the set.
+ */
+void SurfaceSet::pinFrame(int i)
+{
+	if (getFrame(i) && (size_t)i < _lazy.size())
+	{
+		_lazy[i] = LazyFrame{ RESIDENT, 0 };
+	}
+}
+
 /**
  * Returns the full width of a frame in the set.
  * @return Width in pixels.
@@ -283,6 +437,78 @@ void SurfaceSet::setPalette(const SDL_Color *colors, int firstcolor, int ncolors
 		if (_frames[i])
 			_frames[i].setPalette(colors, firstcolor, ncolors);
 	}
+	// remembered for the frames decoded later
+	if (_palette.empty())
+	{
+		_palette.resize(256);
+		_paletteSet.resize(256, false);
+	}
+	for (int c = 0; c < ncolors && firstcolor + c < 256; ++c)
+	{
+		_palette[firstcolor + c] = colors[c];
+		_paletteSet[firstcolor + c] = true;
+	}
+}
+
+/**
+ * Sets if the frames decoded from now on can be dropped from memory.
+ * It's off while the mods are loading, as they can change any frame.
+ * @param active Is the cache active?
+ */
+void SurfaceSet::setCacheActive(bool active)
+{
+	assert(isMainThread());
+	_cacheActive = active;
+}
+
+/**
+ * Drops the least recently used frames decoded during play, until
+ * they fit in the "oxceSpriteCacheSize" budget. They are decoded again
+ * when needed. Only safe while nothing holds on to frame pointers,
+ * which means outside of battles and between states.
+ */
+void SurfaceSet::trimCache()
+{
+	assert(isMainThread());
+	size_t budget = (size_t)std::max(Options::oxceSpriteCacheSize, 0) * 1024 * 1024;
+	if (budget == 0)
+	{
+		return;
+	}
+	std::vector<std::tuple<Uint64, SurfaceSet*, int> > cached;
+	size_t used = 0;
+	for (auto *set : _allSets)
+	{
+		for (size_t i = 0; i < set->_lazy.size(); ++i)
+		{
+			if (set->_lazy[i].lastUse != 0)
+			{
+				cached.push_back(std::make_tuple(set->_lazy[i].lastUse, set, (int)i));
+				used += set->_width * set->_height;
+			}
+		}
+	}
+	if (used <= budget)
+	{
+		return;
+	}
+	std::sort(cached.begin(), cached.end());
+	size_t dropped = 0;
+	for (auto &c : cached)
+	{
+		if (used <= budget)
+		{
+			break;
+		}
+		SurfaceSet *set = std::get<1>(c);
+		int i = std::get<2>(c);
+		set->_frames[i] = Surface();
+		set->_lazy[i].lastUse = 0;
+		used -= set->_width * set->_height;
+		++dropped;
+	}
+	Profiler::count("SurfaceSet::trimCache dropped frames", dropped);
+	Log(LOG_VERBOSE) << "SurfaceSet::trimCache(): dropped " << dropped << " frames, " << used / 1024 << " KB of frames left.";
 }
 
 }
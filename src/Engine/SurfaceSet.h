@@ -20,6 +20,7 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <SDL.h>
 
 namespace OpenXcom
@@ -32,21 +33,38 @@ class Surface;
  * Used to manage single images that contain series of
  * frames inside, like animated sprites, making them easier
  * to access without constant cropping.
+ * Frames of PCK sets are only decoded when first used, and the ones
+ * decoded during play can be dropped again by trimCache().
  */
 class SurfaceSet
 {
 private:
+	/// Frame that doesn't come from the PCK data, or has to stay in memory.
+	static const Uint32 RESIDENT = 0xFFFFFFFF;
+	/// Where a frame is in the PCK data and when it was last used.
+	struct LazyFrame
+	{
+		Uint32 offset;
+		Uint64 lastUse;
+	};
+
 	std::vector<Surface> _frames;
 	int _width, _height;
 	int _sharedFrames;
+	std::shared_ptr<const std::vector<Uint8> > _pck;
+	std::vector<LazyFrame> _lazy;
+	std::vector<SDL_Color> _palette;
+	std::vector<bool> _paletteSet;
 
+	/// Decodes a frame from the PCK data.
+	void decodeFrame(int i);
 public:
 	/// Crates a surface set with frames of the specified size.
 	SurfaceSet(int width, int height);
 	/// Creates a surface set from an existing one.
-	SurfaceSet(const SurfaceSet& other) = default;
+	SurfaceSet(const SurfaceSet& other);
 	/// Creates a surface set from an existing one.
-	SurfaceSet(SurfaceSet&& other) = default;
+	SurfaceSet(SurfaceSet&& other);
 	/// Cleans up the surface set.
 	~SurfaceSet();
 	/// Assignment operator.
@@ -62,6 +80,8 @@ public:
 	Surface *getFrame(int i);
 	/// Creates a new surface and returns a pointer to it.
 	Surface *addFrame(int i);
+	/// Keeps a frame in memory for good.
+	void pinFrame(int i);
 	/// Gets the width of all frames.
 	int getWidth() const;
 	/// Gets the height of all frames.
@@ -76,6 +96,11 @@ public:
 	size_t getTotalFrames() const;
 	/// Sets the surface set's palette.
 	void setPalette(const SDL_Color *colors, int firstcolor = 0, int ncolors = 256);
+
+	/// Sets if frames decoded from now on can be dropped from memory.
+	static void setCacheActive(bool active);
+	/// Drops the least recently used frames over the memory budget.
+	static void trimCache();
 };
 
 }
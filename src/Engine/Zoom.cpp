@@ -19,9 +19,12 @@
 
 #include "Zoom.h"
 
+#include <algorithm>
+#include <functional>
 #include "Surface.h"
 #include "Logger.h"
 #include "Options.h"
+#include "Parallel.h"
 #include "Screen.h"
 
 #include "OpenGL.h"
@@ -61,6 +64,39 @@
 namespace OpenXcom
 {
 
+namespace
+{
+
+/// Smallest band worth giving to a thread, xBRZ also gets slower on very thin slices.
+const int MIN_BAND_ROWS = 16;
+
+/**
+ * Splits the rows of a scaling job into horizontal bands and spreads them
+ * over the worker threads. The number of bands is set by the "oxceScalerBands"
+ * option, with 0 using one band per thread and 1 doing everything in place.
+ * @param rows Number of rows to split.
+ * @param func Function called with the first row of a band and the row after its end.
+ */
+void forEachBand(int rows, const std::function<void(int first, int last)> &func)
+{
+	int bands = Options::oxceScalerBands;
+	if (bands <= 0)
+	{
+		bands = Parallel::getThreadCount();
+	}
+	bands = std::min(bands, rows / MIN_BAND_ROWS);
+	if (bands <= 1)
+	{
+		func(0, rows);
+		return;
+	}
+	Parallel::forEach(bands, [&](size_t band, int)
+	{
+		func(rows * (int)band / bands, rows * ((int)band + 1) / bands);
+	});
+}
+
+}
 
 /**
  * Optimized 8-bit zoomer for resizing by a factor of 2. Doesn't flip.
@@ -647,6 +683,74 @@ bool Zoom::haveSSE2()
 
 #endif
 
+/**
+ * Checks the SSE4.1 feature bit returned by the CPUID instruction
+ * @return Does the CPU support SSE4.1?
+ */
+bool Zoom::haveSSE41()
+{
+#if defined(__GNUC__) && (__i386__ || __x86_64__)
+	unsigned int CPUInfo[4] = {0, 0, 0, 0};
+	__get_cpuid(1, CPUInfo, CPUInfo+1, CPUInfo+2, CPUInfo+3);
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	int CPUInfo[4];
+	__cpuid(CPUInfo, 1);
+#else
+	unsigned int CPUInfo[4] = {0, 0, 0, 0};
+#endif
+
+	return (CPUInfo[2] & 0x00080000) ? true : false;
+}
+
+/**
+ * Checks the AVX2 feature bit returned by the CPUID instruction,
+ * and that the OS saves the AVX registers on task switches.
+ * @return Can AVX2 instructions be used?
+ */
+bool Zoom::haveAVX2()
+{
+#if defined(__GNUC__) && (__i386__ || __x86_64__)
+	unsigned int CPUInfo[4] = {0, 0, 0, 0};
+	if (__get_cpuid_max(0, 0) < 7)
+	{
+		return false;
+	}
+	__get_cpuid(1, CPUInfo, CPUInfo+1, CPUInfo+2, CPUInfo+3);
+	if ((CPUInfo[2] & 0x18000000) != 0x18000000) // OSXSAVE and AVX
+	{
+		return false;
+	}
+	unsigned int xcr0, xcr0High;
+	__asm__ ("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+	if ((xcr0 & 0x6) != 0x6) // XMM and YMM state
+	{
+		return false;
+	}
+	__cpuid_count(7, 0, CPUInfo[0], CPUInfo[1], CPUInfo[2], CPUInfo[3]);
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	int CPUInfo[4];
+	__cpuid(CPUInfo, 0);
+	if (CPUInfo[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(CPUInfo, 1);
+	if ((CPUInfo[2] & 0x18000000) != 0x18000000) // OSXSAVE and AVX
+	{
+		return false;
+	}
+	if ((_xgetbv(0) & 0x6) != 0x6) // XMM and YMM state
+	{
+		return false;
+	}
+	__cpuidex(CPUInfo, 7, 0);
+#else
+	unsigned int CPUInfo[4] = {0, 0, 0, 0};
+#endif
+
+	return (CPUInfo[1] & 0x00000020) ? true : false;
+}
+
 /**
  * Wrapper around various software and OpenGL screen buffer pushing functions which zoom.
  * Basically called just from Screen::flip()
@@ -719,8 +823,7 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 	static Uint32 *sax, *say;
 	Uint32 *csax, *csay;
 	int csx, csy;
-	Uint8 *sp, *dp, *csp;
-	int dgap;
+	Uint8 *csp;
 	static bool proclaimed = false;
 
 	if (Screen::use32bitScaler())
@@ -732,7 +835,10 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 			{
 				if (dst->w == src->w * (int)factor && dst->h == src->h * (int)factor)
 				{
-					xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::RGB);
+					forEachBand(src->h, [&](int first, int last)
+					{
+						xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::RGB, xbrz::ScalerCfg(), first, last);
+					});
 					return 0;
 				}
 			}
@@ -748,23 +854,32 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 				initDone = true;
 			}
 
-			// HQX_API void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
+			// HQX_API void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int yFirst, int yLast );
 
 			if (dst->w == src->w * 2 && dst->h == src->h * 2)
 			{
-				hq2x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				forEachBand(src->h, [&](int first, int last)
+				{
+					hq2x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, first, last);
+				});
 				return 0;
 			}
 
 			if (dst->w == src->w * 3 && dst->h == src->h * 3)
 			{
-				hq3x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				forEachBand(src->h, [&](int first, int last)
+				{
+					hq3x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, first, last);
+				});
 				return 0;
 			}
 
 			if (dst->w == src->w * 4 && dst->h == src->h * 4)
 			{
-				hq4x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				forEachBand(src->h, [&](int first, int last)
+				{
+					hq4x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, first, last);
+				});
 				return 0;
 			}
 		}
@@ -777,7 +892,10 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 		{
 			if (dst->w == src->w * (int)factor && dst->h == src->h * (int)factor && !scale_precondition(factor, src->format->BytesPerPixel, src->w, src->h))
 			{
-				scale(factor, dst->pixels, dst->pitch, src->pixels, src->pitch, src->format->BytesPerPixel, src->w, src->h);
+				forEachBand(src->h, [&](int first, int last)
+				{
+					scale_part(factor, dst->pixels, dst->pitch, src->pixels, src->pitch, src->format->BytesPerPixel, src->w, src->h, first, last);
+				});
 				return 0;
 			}
 		}
@@ -853,9 +971,7 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 	/*
 	* Pointer setup
 	*/
-	sp = csp = (Uint8 *) src->pixels;
-	dp = (Uint8 *) dst->pixels;
-	dgap = dst->pitch - dst->w;
+	csp = (Uint8 *) src->pixels;
 
 	if (flipx) csp += (src->w-1);
 	if (flipy) csp  = ( (Uint8*)csp + src->pitch*(src->h-1) );
@@ -888,38 +1004,48 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 		csay++;
 	}
 	/*
-	* Draw
+	* Draw, each band starts from its own first row
 	*/
-	csay = say;
-	for (y = 0; y < dst->h; y++) {
-		csax = sax;
-		sp = csp;
-		for (x = 0; x < dst->w; x++) {
-			/*
-			* Draw
-			*/
-			*dp = *sp;
+	forEachBand(dst->h, [&](int first, int last)
+	{
+		Uint8 *bsp = csp;
+		Uint32 *bsay = say;
+		for (int by = 0; by < first; by++) {
+			bsp += (*bsay);
+			bsay++;
+		}
+		Uint8 *dp = (Uint8 *) dst->pixels + first * dst->pitch;
+		int dgap = dst->pitch - dst->w;
+		for (int by = first; by < last; by++) {
+			Uint32 *bsax = sax;
+			Uint8 *sp = bsp;
+			for (int bx = 0; bx < dst->w; bx++) {
+				/*
+				* Draw
+				*/
+				*dp = *sp;
+				/*
+				* Advance source pointers
+				*/
+				sp += (*bsax);
+				bsax++;
+				/*
+				* Advance destination pointer
+				*/
+				dp++;
+			}
 			/*
-			* Advance source pointers
+			* Advance source pointer (for row)
 			*/
-			sp += (*csax);
-			csax++;
+			bsp += (*bsay);
+			bsay++;
+
 			/*
-			* Advance destination pointer
+			* Advance destination pointers
 			*/
-			dp++;
+			dp += dgap;
 		}
-		/*
-		* Advance source pointer (for row)
-		*/
-		csp += (*csay);
-		csay++;
-
-		/*
-		* Advance destination pointers
-		*/
-		dp += dgap;
-	}
+	});
 
 	/*
 	* Never remove temp arrays
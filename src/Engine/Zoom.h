@@ -34,6 +34,10 @@ class Zoom
 	static int _zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy);
 	/// Check for SSE2 instructions using CPUID.
 	static bool haveSSE2();
+	/// Check for SSE4.1 instructions using CPUID.
+	static bool haveSSE41();
+	/// Check for AVX2 instructions using CPUID.
+	static bool haveAVX2();
 
 private:
 
@@ -714,6 +714,7 @@ void GeoscapeState::init()
 void GeoscapeState::think()
 {
 	State::think();
+	SaveGameState::checkBackgroundSave(OPT_GEOSCAPE, _palette);
 
 	_zoomInEffectTimer->think(this, 0);
 	_zoomOutEffectTimer->think(this, 0);
@@ -859,6 +860,17 @@ void GeoscapeState::timeAdvance()
 		case TIME_5SEC:
 			time5Seconds();
 		}
+
+		// the following steps up to the next event can take the fast lane
+		if (Options::oxceGeoFastForward && !_pause)
+		{
+			int quiet = countQuietTicks(timeSpan - i - 1);
+			if (quiet > 0)
+			{
+				skipQuietTicks(quiet);
+				i += quiet;
+			}
+		}
 	}
 
 	_pause = !_dogfightsToBeStarted.empty() || _zoomInEffectTimer->isRunning() || _zoomOutEffectTimer->isRunning();
@@ -887,6 +899,184 @@ const std::vector<Craft*>* GeoscapeState::updateActiveCrafts()
 	return &_activeCrafts;
 }
 
+namespace
+{
+
+/**
+ * Checks if a moving target surely won't reach its destination in
+ * a number of 5 second steps, even if the destination comes straight
+ * at it. Each step covers about the speed in radians, the margin takes
+ * care of the meet point and rounding; near the poles, where a step of
+ * longitude gets longer, it just gives up.
+ * @param mover Moving target.
+ * @param steps Number of steps.
+ * @return True if it can't get there in time.
+ */
+bool cannotReachWithin(const MovingTarget *mover, int steps)
+{
+	const Target *dest = mover->getDestination();
+	if (dest == 0)
+	{
+		return true;
+	}
+	if (mover->reachedDestination())
+	{
+		return false;
+	}
+	double reach = mover->getSpeedRadian();
+	const MovingTarget *movingDest = dynamic_cast<const MovingTarget*>(dest);
+	if (movingDest != 0)
+	{
+		reach += movingDest->getSpeedRadian();
+	}
+	const double maxLat = M_PI * 80 / 180;
+	const double drift = 2 * (steps + 1) * reach;
+	if (std::abs(mover->getLatitude()) + drift > maxLat || std::abs(dest->getLatitude()) + drift > maxLat)
+	{
+		return false;
+	}
+	return mover->getDistance(dest) > drift + mover->getSpeedRadian();
+}
+
+/**
+ * Checks if a shield stays as it is during the next steps.
+ * @param shield Current shield.
+ * @param capacity Shield capacity.
+ * @param recharge Recharge per step, in hundredths.
+ * @return True if no recharge happens, random or not.
+ */
+bool shieldIsSteady(int shield, int capacity, int recharge)
+{
+	return shield != -1 && (shield >= capacity || recharge == 0);
+}
+
+}
+
+/**
+ * Counts how many of the coming 5 second steps would do nothing but
+ * move the UFOs and craft (and count down the landed UFOs), so they can
+ * skip all the checks. This stops before the next 10 minute step, before
+ * anything could reach its destination or timer, and whenever something
+ * would change state, use the RNG or open a window on the next step, so
+ * the game plays out exactly the same.
+ * @param maxTicks Maximum number of steps wanted.
+ * @return Number of quiet steps, 0 if the next one isn't.
+ */
+int GeoscapeState::countQuietTicks(int maxTicks) const
+{
+	SavedGame *save = _game->getSavedGame();
+	if ((_timeSpeed == _btn5Secs || _timeSpeed == _btn1Min) && _game->getMod()->getHunterKillerFastRetarget())
+	{
+		return 0;
+	}
+	if (save->getBases()->empty() || save->getEnding() == END_LOSE || !_dogfights.empty() || !_dogfightsToBeStarted.empty())
+	{
+		return 0;
+	}
+
+	// stop one step before the 10 minute trigger
+	const GameTime *time = save->getTime();
+	int ticks = std::min(maxTicks, (60 - time->getSecond()) / 5 + 12 * (9 - time->getMinute() % 10) - 1);
+	if (ticks <= 0)
+	{
+		return 0;
+	}
+
+	for (std::vector<Ufo*>::const_iterator i = save->getUfos()->begin(); i != save->getUfos()->end() && ticks > 0; ++i)
+	{
+		const Ufo *ufo = *i;
+		switch (ufo->getStatus())
+		{
+		case Ufo::FLYING:
+			if (!shieldIsSteady(ufo->getShield(), ufo->getCraftStats().shieldCapacity, ufo->getCraftStats().shieldRechargeInGeoscape))
+			{
+				return 0;
+			}
+			if (!ufo->isEscorting())
+			{
+				while (ticks > 0 && !cannotReachWithin(ufo, ticks))
+				{
+					ticks /= 2;
+				}
+			}
+			break;
+		case Ufo::LANDED:
+			ticks = std::min(ticks, (int)((ufo->getSecondsRemaining() - 1) / 5));
+			break;
+		case Ufo::CRASHED:
+			if (ufo->getSecondsRemaining() == 0 || !ufo->getDetected())
+			{
+				return 0;
+			}
+			break;
+		case Ufo::DESTROYED:
+			return 0;
+		}
+	}
+
+	for (std::vector<Base*>::const_iterator i = save->getBases()->begin(); i != save->getBases()->end() && ticks > 0; ++i)
+	{
+		for (std::vector<Craft*>::const_iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end() && ticks > 0; ++j)
+		{
+			const Craft *craft = *j;
+			if (craft->isDestroyed())
+			{
+				return 0;
+			}
+			if (!shieldIsSteady(craft->getShield(), craft->getCraftStats().shieldCapacity, craft->getCraftStats().shieldRechargeInGeoscape))
+			{
+				return 0;
+			}
+			if (craft->getDestination() != 0)
+			{
+				const Ufo *u = dynamic_cast<const Ufo*>(craft->getDestination());
+				if (u != 0)
+				{
+					if (!u->getDetected() || u->getStatus() == Ufo::DESTROYED || (u->getStatus() == Ufo::LANDED && craft->isInDogfight()))
+					{
+						return 0;
+					}
+				}
+				else if (craft->isInDogfight())
+				{
+					return 0;
+				}
+				while (ticks > 0 && !cannotReachWithin(craft, ticks))
+				{
+					ticks /= 2;
+				}
+			}
+		}
+	}
+	return ticks;
+}
+
+/**
+ * Runs 5 second steps found by countQuietTicks(), only advancing
+ * the time and letting the UFOs and craft think, in the same order
+ * time5Seconds() does.
+ * @param ticks Number of steps.
+ */
+void GeoscapeState::skipQuietTicks(int ticks)
+{
+	SavedGame *save = _game->getSavedGame();
+	for (int t = 0; t < ticks; ++t)
+	{
+		save->getTime()->advance();
+		for (std::vector<Ufo*>::iterator i = save->getUfos()->begin(); i != save->getUfos()->end(); ++i)
+		{
+			(*i)->think();
+		}
+		for (std::vector<Base*>::iterator i = save->getBases()->begin(); i != save->getBases()->end(); ++i)
+		{
+			for (std::vector<Craft*>::iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); ++j)
+			{
+				(*j)->think();
+			}
+		}
+	}
+}
+
 /**
  * Takes care of any game logic that has to
  * run every game second, like craft movement.
@@ -65,6 +65,10 @@ private:
 
 	/// Update list of active crafts.
 	const std::vector<Craft*>* updateActiveCrafts();
+	/// Counts the coming 5 second steps where only the movement changes.
+	int countQuietTicks(int maxTicks) const;
+	/// Runs 5 second steps that only move things around.
+	void skipQuietTicks(int ticks);
 
 	void cbxRegionChange(Action *action);
 	void cbxZoneChange(Action *action);
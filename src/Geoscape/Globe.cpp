@@ -61,6 +61,7 @@ namespace OpenXcom
 
 const double Globe::ROTATE_LONGITUDE = 0.10;
 const double Globe::ROTATE_LATITUDE = 0.06;
+const double Globe::SHADOW_MOVE_PIXELS = 0.5;
 
 Uint8 Globe::OCEAN_COLOR;
 bool Globe::OCEAN_SHADING;
@@ -325,6 +326,7 @@ struct CreateShadow
  * @param y Y position in pixels.
  */
 Globe::Globe(Game* game, int cenX, int cenY, int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _cenX(cenX), _cenY(cenY), _rotLon(0.0), _rotLat(0.0), _hoverLon(0.0), _hoverLat(0.0), _craftLon(0.0), _craftLat(0.0), _craftRange(0.0), _game(game), _hover(false), _craft(false), _blink(-1),
+																					_cacheLon(0.0), _cacheLat(0.0), _cacheRadius(0.0), _cacheX(0), _cacheY(0), _cacheValid(false), _shadowValid(false),
 																					_isMouseScrolling(false), _isMouseScrolled(false), _xBeforeMouseScrolling(0), _yBeforeMouseScrolling(0), _lonBeforeMouseScrolling(0.0), _latBeforeMouseScrolling(0.0), _mouseScrollingStartTime(0), _totalMouseMoveX(0), _totalMouseMoveY(0), _mouseMovedOverThreshold(false)
 {
 	_rules = game->getMod()->getGlobe();
@@ -334,6 +336,7 @@ Globe::Globe(Game* game, int cenX, int cenY, int width, int height, int x, int y
 	_countries = new Surface(width, height, x, y);
 	_markers = new Surface(width, height, x, y);
 	_radars = new Surface(width, height, x, y);
+	_land = new Surface(width, height, x, y);
 	_clipper = new FastLineClip(x, x+width, y, y+height);
 
 	// Animation timers
@@ -365,9 +368,10 @@ Globe::~Globe()
 	delete _markers;
 	delete _texture;
 	delete _radars;
+	delete _land;
 	delete _clipper;
 
-	for (std::list<Polygon*>::iterator i = _cacheLand.begin(); i != _cacheLand.end(); ++i)
+	for (std::vector<Polygon*>::iterator i = _landPolygons.begin(); i != _landPolygons.end(); ++i)
 	{
 		delete *i;
 	}
@@ -447,46 +451,7 @@ bool Globe::pointBack(double lon, double lat) const
 
 Polygon* Globe::getPolygonFromLonLat(double lon, double lat) const
 {
-	const double zDiscard=0.75f;
-	double coslat = cos(lat);
-	double sinlat = sin(lat);
-
-	for (std::list<Polygon*>::iterator i = _rules->getPolygons()->begin(); i != _rules->getPolygons()->end(); ++i)
-	{
-		double x, y, z, x2, y2;
-		double clat, clon;
-		z = 0;
-		for (int j = 0; j < (*i)->getPoints(); ++j)
-		{
-			z = coslat * cos((*i)->getLatitude(j)) * cos((*i)->getLongitude(j) - lon) + sinlat * sin((*i)->getLatitude(j));
-			if (z<zDiscard) break; //discarded
-		}
-		if (z<zDiscard) continue; //discarded
-
-		bool odd = false;
-
-		clat = (*i)->getLatitude(0); //initial point
-		clon = (*i)->getLongitude(0);
-		x = cos(clat) * sin(clon - lon);
-		y = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
-
-		for (int j = 0; j < (*i)->getPoints(); ++j)
-		{
-			int k = (j + 1) % (*i)->getPoints(); //index of next point in poly
-			clat = (*i)->getLatitude(k);
-			clon = (*i)->getLongitude(k);
-
-			x2 = cos(clat) * sin(clon - lon);
-			y2 = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
-			if ( ((y>0)!=(y2>0)) && (0 < (x2-x)*(0-y)/(y2-y)+x) )
-				odd = !odd;
-			x = x2;
-			y = y2;
-
-		}
-		if (odd) return *i;
-	}
-	return NULL;
+	return _rules->getPolygonAt(lon, lat);
 }
 
 /**
@@ -832,39 +797,59 @@ std::vector<Target*> Globe::getTargets(int x, int y, bool craft, Craft *currentC
 }
 
 /**
- * Takes care of pre-calculating all the polygons currently visible
- * on the globe and caching them so they only need to be recalculated
- * when the globe is actually moved.
+ * Checks if the land layer was drawn for the current view.
+ * @return True if the globe hasn't moved since.
  */
-void Globe::cachePolygons()
+bool Globe::isCacheValid() const
 {
-	cache(_rules->getPolygons(), &_cacheLand);
+	return _cacheValid && _cacheLon == _cenLon && _cacheLat == _cenLat && _cacheRadius == _radius && _cacheX == _cenX && _cacheY == _cenY;
 }
 
 /**
- * Caches a set of polygons.
- * @param polygons Pointer to list of polygons.
- * @param cache Pointer to cache.
+ * Takes care of pre-calculating all the polygons currently visible
+ * on the globe and caching them so they only need to be recalculated
+ * when the globe is actually moved. The polygon vertices are turned into
+ * unit vectors once, so moving the globe only needs a rotation of each.
  */
-void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
+void Globe::cachePolygons()
 {
-	// Clear existing cache
-	for (std::list<Polygon*>::iterator i = cache->begin(); i != cache->end(); ++i)
+	std::list<Polygon*> *polygons = _rules->getPolygons();
+	if (_landPolygons.size() != polygons->size())
 	{
-		delete *i;
+		for (std::vector<Polygon*>::iterator i = _landPolygons.begin(); i != _landPolygons.end(); ++i)
+		{
+			delete *i;
+		}
+		_landPolygons.clear();
+		_landVectors.clear();
+		for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); ++i)
+		{
+			_landPolygons.push_back(new Polygon(**i));
+			for (int j = 0; j < (*i)->getPoints(); ++j)
+			{
+				double lon = (*i)->getLongitude(j), lat = (*i)->getLatitude(j);
+				_landVectors.push_back(Cord(cos(lat) * cos(lon), cos(lat) * sin(lon), sin(lat)));
+			}
+		}
 	}
-	cache->clear();
 
-	// Pre-calculate values to cache
-	for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); ++i)
+	const double cosLon = cos(_cenLon), sinLon = sin(_cenLon);
+	const double cosLat = cos(_cenLat), sinLat = sin(_cenLat);
+	_cacheLand.clear();
+	std::vector<Cord>::const_iterator v = _landVectors.begin();
+	for (std::vector<Polygon*>::iterator i = _landPolygons.begin(); i != _landPolygons.end(); ++i)
 	{
+		Polygon *p = *i;
+		std::vector<Cord>::const_iterator first = v;
+		v += p->getPoints();
+
 		// Is quad on the back face?
 		double closest = 0.0;
 		double z;
 		double furthest = 0.0;
-		for (int j = 0; j < (*i)->getPoints(); ++j)
+		for (std::vector<Cord>::const_iterator j = first; j != v; ++j)
 		{
-			z = cos(_cenLat) * cos((*i)->getLatitude(j)) * cos((*i)->getLongitude(j) - _cenLon) + sin(_cenLat) * sin((*i)->getLatitude(j));
+			z = cosLat * (j->x * cosLon + j->y * sinLon) + sinLat * j->z;
 			if (z > closest)
 				closest = z;
 			else if (z < furthest)
@@ -873,18 +858,16 @@ void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
 		if (-furthest > closest)
 			continue;
 
-		Polygon* p = new Polygon(**i);
-
-		// Convert coordinates
+		// Convert coordinates, same as polarToCart
 		for (int j = 0; j < p->getPoints(); ++j)
 		{
-			Sint16 x, y;
-			polarToCart(p->getLongitude(j), p->getLatitude(j), &x, &y);
-			p->setX(j, x);
-			p->setY(j, y);
+			const Cord &c = first[j];
+			double front = c.x * cosLon + c.y * sinLon;
+			p->setX(j, _cenX + (Sint16)floor(_radius * (c.y * cosLon - c.x * sinLon)));
+			p->setY(j, _cenY + (Sint16)floor(_radius * (cosLat * c.z - sinLat * front)));
 		}
 
-		cache->push_back(p);
+		_cacheLand.push_back(p);
 	}
 }
 
@@ -903,6 +886,7 @@ void Globe::setPalette(const SDL_Color *colors, int firstcolor, int ncolors)
 	_countries->setPalette(colors, firstcolor, ncolors);
 	_markers->setPalette(colors, firstcolor, ncolors);
 	_radars->setPalette(colors, firstcolor, ncolors);
+	_land->setPalette(colors, firstcolor, ncolors);
 }
 
 /**
@@ -939,34 +923,52 @@ void Globe::rotate()
 }
 
 /**
- * Draws the whole globe, part by part.
+ * Draws the whole globe, part by part. The ocean and land only get
+ * drawn again when the globe moves, and the shadow when the globe moves
+ * or the sun moves far enough to make a difference, as they are the
+ * slow parts and the time keeps redrawing the globe.
  */
 void Globe::draw()
 {
-	if (_redraw)
+	_redraw = false;
+	bool moved = !isCacheValid();
+	if (moved)
 	{
 		cachePolygons();
+		drawOcean();
+		drawLand();
+		_cacheLon = _cenLon;
+		_cacheLat = _cenLat;
+		_cacheRadius = _radius;
+		_cacheX = _cenX;
+		_cacheY = _cenY;
+		_cacheValid = true;
 	}
-	Surface::draw();
-	drawOcean();
-	drawLand();
 	drawRadars();
 	drawFlights();
-	drawShadow();
+	Cord sun = getSunDirection(_cenLon, _cenLat);
+	if (moved || !_shadowValid || acos(Clamp(sun.x * _shadowSun.x + sun.y * _shadowSun.y + sun.z * _shadowSun.z, -1.0, 1.0)) * _radius >= SHADOW_MOVE_PIXELS)
+	{
+		copy(_land);
+		drawShadow();
+		_shadowSun = sun;
+		_shadowValid = true;
+	}
 	drawMarkers();
 	drawDetail();
 }
 
 
 /**
- * Renders the ocean, shading it according to the time of day.
+ * Renders the ocean on the land layer, before shading.
  */
 void Globe::drawOcean()
 {
-	lock();
-	drawCircle(_cenX+1, _cenY, _radius+20, OCEAN_COLOR);
+	_land->clear();
+	_land->lock();
+	_land->drawCircle(_cenX+1, _cenY, _radius+20, OCEAN_COLOR);
 //	ShaderDraw<Ocean>(ShaderSurface(this));
-	unlock();
+	_land->unlock();
 }
 
 
@@ -974,7 +976,7 @@ void Globe::drawOcean()
 
 /**
  * Renders the land, taking all the visible world polygons
- * and texturing and shading them accordingly.
+ * and texturing them on the land layer, before shading.
  */
 void Globe::drawLand()
 {
@@ -990,7 +992,7 @@ void Globe::drawLand()
 		}
 
 		// Apply textures according to zoom and shade
-		drawTexturedPolygon(x, y, (*i)->getPoints(), _texture->getFrame((*i)->getTexture() + _zoomTexture), 0, 0);
+		_land->drawTexturedPolygon(x, y, (*i)->getPoints(), _texture->getFrame((*i)->getTexture() + _zoomTexture), 0, 0);
 	}
 }
 
@@ -2041,16 +2043,17 @@ void Globe::toggleRadarLines()
  */
 void Globe::resize()
 {
-	Surface *surfaces[4] = {this, _markers, _countries, _radars};
+	Surface *surfaces[5] = {this, _markers, _countries, _radars, _land};
 	int width = Options::baseXGeoscape - 64;
 	int height = Options::baseYGeoscape;
 
-	for (int i = 0; i < 4; ++i)
+	for (int i = 0; i < 5; ++i)
 	{
 		surfaces[i]->setWidth(width);
 		surfaces[i]->setHeight(height);
 		surfaces[i]->invalidate();
 	}
+	_cacheValid = false;
 	_clipper->Wxrig = width;
 	_clipper->Wybot = height;
 	_cenX = width / 2;
@@ -52,6 +52,8 @@ private:
 	static const int CITY_MARKER = 8;
 	static const double ROTATE_LONGITUDE;
 	static const double ROTATE_LATITUDE;
+	/// How far the sun has to move, in pixels at the globe edge, to redraw the shadow.
+	static const double SHADOW_MOVE_PIXELS;
 
 	RuleGlobe *_rules;
 	Sint16 _cenX, _cenY;
@@ -60,11 +62,21 @@ private:
 	size_t _zoom, _zoomOld, _zoomTexture;
 	SurfaceSet *_texture, *_markerSet;
 	Game *_game;
-	Surface *_markers, *_countries, *_radars;
+	Surface *_markers, *_countries, *_radars, *_land;
 	bool _hover, _craft;
 	int _blink;
 	Timer *_blinkTimer, *_rotTimer;
 	std::list<Polygon*> _cacheLand;
+	///copy of each polygon and the unit vector of each vertex, in rule order
+	std::vector<Polygon*> _landPolygons;
+	std::vector<Cord> _landVectors;
+	///view of the land layer
+	double _cacheLon, _cacheLat, _cacheRadius;
+	Sint16 _cacheX, _cacheY;
+	bool _cacheValid;
+	///sun direction of the shadow currently drawn
+	Cord _shadowSun;
+	bool _shadowValid;
 	FastLineClip *_clipper;
 	double _radius, _radiusStep;
 	///normal of each pixel in earth globe per zoom level
@@ -87,8 +99,8 @@ private:
 	Polygon* getPolygonFromLonLat(double lon, double lat) const;
 	/// Checks if a target is near a point.
 	bool targetNear(Target* target, int x, int y) const;
-	/// Caches a set of polygons.
-	void cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache);
+	/// Checks if the land layer matches the current view.
+	bool isCacheValid() const;
 	/// Get position of sun relative to given position in polar cords and date.
 	Cord getSunDirection(double lon, double lat) const;
 	/// Draw globe range circle.
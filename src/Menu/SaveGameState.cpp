@@ -24,11 +24,13 @@
 #include "../Engine/Options.h"
 #include "../Engine/Screen.h"
 #include "../Engine/CrossPlatform.h"
+#include "../Engine/Language.h"
 #include "../Engine/LocalizedText.h"
 #include "../Engine/Unicode.h"
 #include "../Interface/Text.h"
 #include "ErrorMessageState.h"
 #include "MainMenuState.h"
+#include "../Savegame/BackgroundSave.h"
 #include "../Savegame/SavedGame.h"
 #include "../Mod/Mod.h"
 #include "../Mod/RuleInterface.h"
@@ -137,7 +139,8 @@ void SaveGameState::think()
 {
 	State::think();
 	// Make sure it gets drawn properly
-	if (_firstRun < 10)
+	bool background = Options::oxceBackgroundAutosave && (_type == SAVE_AUTO_GEOSCAPE || _type == SAVE_AUTO_BATTLESCAPE);
+	if (_firstRun < 10 && !background)
 	{
 		_firstRun++;
 	}
@@ -165,6 +168,24 @@ void SaveGameState::think()
 			break;
 		}
 
+		if (background)
+		{
+			// only the snapshot is taken now, the save thread writes it
+			try
+			{
+				BackgroundSave::start(_game->getSavedGame()->takeSnapshot(_game->getMod()), _filename);
+			}
+			catch (Exception &e)
+			{
+				error(e.what());
+			}
+			catch (YAML::Exception &e)
+			{
+				error(e.what());
+			}
+			return;
+		}
+
 		// Save the game
 		try
 		{
@@ -209,14 +230,48 @@ void SaveGameState::think()
  * @param msg Error message.
  */
 void SaveGameState::error(const std::string &msg)
+{
+	error(_origin, _palette, msg);
+}
+
+/**
+ * Pops up a window with an error message.
+ * @param origin Game section showing the error.
+ * @param palette Palette of the state showing the error.
+ * @param msg Error message.
+ */
+void SaveGameState::error(OptionsOrigin origin, SDL_Color *palette, const std::string &msg)
 {
 	Log(LOG_ERROR) << msg;
 	std::ostringstream error;
-	error << tr("STR_SAVE_UNSUCCESSFUL") << Unicode::TOK_NL_SMALL << msg;
-	if (_origin != OPT_BATTLESCAPE)
-		_game->pushState(new ErrorMessageState(error.str(), _palette, _game->getMod()->getInterface("errorMessages")->getElement("geoscapeColor")->color, "BACK01.SCR", _game->getMod()->getInterface("errorMessages")->getElement("geoscapePalette")->color));
+	error << _game->getLanguage()->getString("STR_SAVE_UNSUCCESSFUL") << Unicode::TOK_NL_SMALL << msg;
+	if (origin != OPT_BATTLESCAPE)
+		_game->pushState(new ErrorMessageState(error.str(), palette, _game->getMod()->getInterface("errorMessages")->getElement("geoscapeColor")->color, "BACK01.SCR", _game->getMod()->getInterface("errorMessages")->getElement("geoscapePalette")->color));
 	else
-		_game->pushState(new ErrorMessageState(error.str(), _palette, _game->getMod()->getInterface("errorMessages")->getElement("battlescapeColor")->color, "TAC00.SCR", _game->getMod()->getInterface("errorMessages")->getElement("battlescapePalette")->color));
+		_game->pushState(new ErrorMessageState(error.str(), palette, _game->getMod()->getInterface("errorMessages")->getElement("battlescapeColor")->color, "TAC00.SCR", _game->getMod()->getInterface("errorMessages")->getElement("battlescapePalette")->color));
+}
+
+/**
+ * Reports the result of an autosave written in the background,
+ * if one finished since the last check. Called by the states
+ * that start autosaves.
+ * @param origin Game section checking the save.
+ * @param palette Palette of the state checking the save.
+ */
+void SaveGameState::checkBackgroundSave(OptionsOrigin origin, SDL_Color *palette)
+{
+	std::string filename, msg;
+	if (BackgroundSave::poll(filename, msg))
+	{
+		if (msg.empty())
+		{
+			Log(LOG_INFO) << "Saved " << filename << " in the background";
+		}
+		else
+		{
+			error(origin, palette, msg);
+		}
+	}
 }
 
 }
@@ -52,6 +52,10 @@ public:
 	void think() override;
 	/// Shows an error message.
 	void error(const std::string &msg);
+	/// Shows an error message over a game section.
+	static void error(OptionsOrigin origin, SDL_Color *palette, const std::string &msg);
+	/// Reports the result of a background autosave.
+	static void checkBackgroundSave(OptionsOrigin origin, SDL_Color *palette);
 };
 
 }
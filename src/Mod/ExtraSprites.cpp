@@ -24,6 +24,7 @@
 #include "../Engine/FileMap.h"
 #include "../Engine/Logger.h"
 #include "../Engine/Exception.h"
+#include "../Engine/Parallel.h"
 #include "../Engine/Unicode.h"
 #include "Mod.h"
 
@@ -168,6 +169,101 @@ bool ExtraSprites::isImageFile(const std::string &filename)
 	return false;
 }
 
+/**
+ * Lists the image files in a folder, in the order they get loaded.
+ * @param folder Folder name, with the trailing slash.
+ * @return Image file names, with the folder.
+ */
+std::vector<std::string> ExtraSprites::getFolderImages(const std::string &folder)
+{
+	std::vector<std::string> contents;
+	for (auto f: FileMap::getVFolderContents(folder)) { contents.push_back(f); }
+	std::sort(contents.begin(), contents.end(), Unicode::naturalCompare);
+	std::vector<std::string> images;
+	for (auto k = contents.begin(); k != contents.end(); ++k)
+	{
+		if (isImageFile(*k))
+			images.push_back(folder + *k);
+	}
+	return images;
+}
+
+/**
+ * Lists all the image files loading the sprite will use.
+ * @return Image file names, in loading order.
+ */
+std::vector<std::string> ExtraSprites::getImageFiles() const
+{
+	std::vector<std::string> files;
+	if (_singleImage)
+	{
+		if (!_sprites.empty())
+			files.push_back(_sprites.begin()->second);
+		return files;
+	}
+	for (std::map<int, std::string>::const_iterator j = _sprites.begin(); j != _sprites.end(); ++j)
+	{
+		const std::string &fileName = j->second;
+		if (fileName[fileName.length() - 1] == '/')
+		{
+			auto images = getFolderImages(fileName);
+			files.insert(files.end(), images.begin(), images.end());
+		}
+		else
+		{
+			files.push_back(fileName);
+		}
+	}
+	return files;
+}
+
+/**
+ * Decodes all the images of a list of sprite packs on the worker threads,
+ * so loading them afterwards only needs to copy the pixels. The packs still
+ * get loaded one by one in the usual order.
+ * @param packs Sprite packs, the ones already loaded are skipped.
+ */
+void ExtraSprites::decodeImages(const std::vector<ExtraSprites*> &packs)
+{
+	std::vector<std::pair<const std::string*, Surface::DecodedImage*> > pending;
+	for (auto *pack : packs)
+	{
+		if (pack->_loaded)
+			continue;
+		for (auto &file : pack->getImageFiles())
+		{
+			auto ins = pack->_decoded.insert(std::make_pair(file, Surface::DecodedImage()));
+			if (ins.second)
+			{
+				pending.push_back(std::make_pair(&ins.first->first, &ins.first->second));
+			}
+		}
+	}
+	Parallel::forEach(pending.size(), [&](size_t i, int)
+	{
+		*pending[i].second = Surface::decodeImage(*pending[i].first);
+	});
+}
+
+/**
+ * Loads an image file into a surface, using the copy
+ * from decodeImages() if there is one.
+ * @param surface Surface to load into.
+ * @param fileName Image file name.
+ */
+void ExtraSprites::loadImage(Surface *surface, const std::string &fileName)
+{
+	auto i = _decoded.find(fileName);
+	if (i != _decoded.end())
+	{
+		surface->loadImage(i->second);
+	}
+	else
+	{
+		surface->loadImage(fileName);
+	}
+}
+
 /**
  * Loads the external sprite into a new or existing surface.
  * @param surface Existing surface.
@@ -189,7 +285,8 @@ Surface *ExtraSprites::loadSurface(Surface *surface)
 		delete surface;
 	}
 	surface = new Surface(_width, _height);
-	surface->loadImage(_sprites.begin()->second);
+	loadImage(surface, _sprites.begin()->second);
+	_decoded.clear();
 	return surface;
 }
 
@@ -232,16 +329,12 @@ SurfaceSet *ExtraSprites::loadSurfaceSet(SurfaceSet *set)
 		{
 			Log(LOG_VERBOSE) << "Loading surface set from folder: " << fileName << " starting at frame: " << startFrame;
 			int offset = startFrame;
-			std::vector<std::string> contents;
-			for (auto f: FileMap::getVFolderContents(fileName)) { contents.push_back(f); }
-			std::sort(contents.begin(), contents.end(), Unicode::naturalCompare);
-			for (auto k = contents.begin(); k != contents.end(); ++k)
+			auto images = getFolderImages(fileName);
+			for (auto k = images.begin(); k != images.end(); ++k)
 			{
-				if (!isImageFile(*k))
-					continue;
 				try
 				{
-					getFrame(set, offset)->loadImage(fileName + *k);
+					loadImage(getFrame(set, offset), *k);
 					offset++;
 				}
 				catch (Exception &e)
@@ -254,12 +347,12 @@ SurfaceSet *ExtraSprites::loadSurfaceSet(SurfaceSet *set)
 		{
 			if (!subdivision)
 			{
-				getFrame(set, startFrame)->loadImage(fileName);
+				loadImage(getFrame(set, startFrame), fileName);
 			}
 			else
 			{
 				Surface temp = Surface(_width, _height);
-				temp.loadImage(fileName);
+				loadImage(&temp, fileName);
 				int xDivision = _width / _subX;
 				int yDivision = _height / _subY;
 				int frames = xDivision * yDivision;
@@ -279,6 +372,7 @@ SurfaceSet *ExtraSprites::loadSurfaceSet(SurfaceSet *set)
 			}
 		}
 	}
+	_decoded.clear();
 	return set;
 }
 
@@ -306,6 +400,7 @@ Surface *ExtraSprites::getFrame(SurfaceSet *set, int index) const
 	if (frame)
 	{
 		Log(LOG_VERBOSE) << "Replacing frame: " << index << ", using index: " << indexWithOffset;
+		set->pinFrame(indexWithOffset);
 		frame->clear();
 	}
 	else
@@ -20,11 +20,12 @@
 #include <yaml-cpp/yaml.h>
 #include <string>
 #include <map>
+#include <vector>
+#include "../Engine/Surface.h"
 
 namespace OpenXcom
 {
 
-class Surface;
 class SurfaceSet;
 struct ModData;
 
@@ -41,8 +42,13 @@ private:
 	bool _singleImage;
 	int _subX, _subY;
 	bool _loaded;
+	std::map<std::string, Surface::DecodedImage> _decoded;
 
 	Surface *getFrame(SurfaceSet *set, int index) const;
+	/// Lists the image files in a folder, in loading order.
+	static std::vector<std::string> getFolderImages(const std::string &folder);
+	/// Loads an image file, decoded ahead if possible.
+	void loadImage(Surface *surface, const std::string &fileName);
 public:
 	/// Creates a blank external sprite set.
 	ExtraSprites();
@@ -68,6 +74,10 @@ public:
 	bool isLoaded() const;
 	/// Checks if a filename is a valid image file.
 	static bool isImageFile(const std::string &filename);
+	/// Lists the image files to load, in loading order.
+	std::vector<std::string> getImageFiles() const;
+	/// Decodes the images of sprite packs on the worker threads.
+	static void decodeImages(const std::vector<ExtraSprites*> &packs);
 	/// Load the external sprite into a surface.
 	Surface *loadSurface(Surface *surface);
 	/// Load the external sprite into a surface set.
@@ -25,6 +25,7 @@
 #include <cassert>
 #include "../Engine/CrossPlatform.h"
 #include "../Engine/FileMap.h"
+#include "../Engine/Parallel.h"
 #include "../Engine/SDL2Helpers.h"
 #include "../Engine/Palette.h"
 #include "../Engine/Font.h"
@@ -106,6 +107,7 @@
 #include "RuleConverter.h"
 #include "RuleSoldierTransformation.h"
 #include "RuleSoldierBonus.h"
+#include "RulesetCache.h"
 
 #define ARRAYLEN(x) (std::size(x))
 
@@ -778,6 +780,7 @@ void Mod::lazyLoadSurface(const std::string &name)
 		std::map<std::string, std::vector<ExtraSprites *> >::const_iterator i = _extraSprites.find(name);
 		if (i != _extraSprites.end())
 		{
+			ExtraSprites::decodeImages(i->second);
 			for (std::vector<ExtraSprites*>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
 			{
 				loadExtraSprite(*j);
@@ -1623,6 +1626,98 @@ static void throwModOnErrorHelper(const std::string& modId, const std::string& e
 	throw Exception(errorStream.str());
 }
 
+/**
+ * Parses the ruleset files of all mods ahead of loading them. The files are
+ * parsed a batch at a time on the worker threads, while the rules themselves
+ * are still loaded one file after another in the usual order. Files that
+ * didn't change since the last run come from the ruleset cache instead.
+ */
+class ModRulesetReader
+{
+	/// Number of files parsed per batch for every thread.
+	static const size_t FILES_PER_THREAD = 8;
+	std::vector<const FileMap::FileRecord*> _files;
+	std::vector<YAML::Node> _docs;
+	std::vector<char> _parsed;
+	size_t _begin, _next;
+	RulesetCache _cache;
+public:
+	/// Lists the ruleset files of all the mods, in loading order.
+	ModRulesetReader(const std::vector<std::pair<std::string, std::vector<FileMap::FileRecord> > > &mods) : _begin(0), _next(0)
+	{
+		for (auto &mod : mods)
+		{
+			for (auto &file : mod.second)
+			{
+				_files.push_back(&file);
+			}
+		}
+	}
+
+	/**
+	 * Gets the parsed contents of the next file. Files that failed to parse
+	 * are read again the usual way, so any error is reported exactly like
+	 * before, at the point where the file is loaded.
+	 * @param filerec The next file, must follow the order of the list.
+	 * @return The YAML document.
+	 */
+	YAML::Node next(const FileMap::FileRecord &filerec)
+	{
+		assert(_next < _files.size() && _files[_next] == &filerec);
+		if (_next >= _begin + _docs.size())
+		{
+			parseBatch();
+		}
+		size_t i = _next++ - _begin;
+		if (!_parsed[i])
+		{
+			return filerec.getYAML();
+		}
+		return _docs[i];
+	}
+
+	/// Saves the documents for the next run, once everything loaded fine.
+	void saveCache()
+	{
+		_cache.save();
+	}
+
+private:
+	/// Parses the files following the next one.
+	void parseBatch()
+	{
+		size_t count = std::min(Parallel::getThreadCount() * FILES_PER_THREAD, _files.size() - _next);
+		_begin = _next;
+		_docs.clear();
+		_docs.resize(count);
+		_parsed.assign(count, 0);
+		Parallel::forEach(count, [&](size_t i, int)
+		{
+			const FileMap::FileRecord *file = _files[_begin + i];
+			std::string text;
+			if (!file->tryGetText(text))
+			{
+				return;
+			}
+			if (_cache.find(file->fullpath, text, _docs[i]))
+			{
+				_parsed[i] = 1;
+				return;
+			}
+			try
+			{
+				_docs[i] = YAML::Load(text);
+			}
+			catch (...)
+			{
+				return;
+			}
+			_parsed[i] = 1;
+			_cache.store(file->fullpath, text, _docs[i]);
+		});
+	}
+};
+
 /**
  * Loads a list of mods specified in the options.
  * List of <modId, rulesetFiles> pairs is fetched from the FileMap / VFS
@@ -1693,13 +1788,14 @@ void Mod::loadAll()
 
 	Log(LOG_INFO) << "Loading rulesets...";
 	// load rest rulesets
+	ModRulesetReader reader(mods);
 	for (size_t i = 0; mods.size() > i; ++i)
 	{
 		try
 		{
 			_modCurrent = &_modData.at(i);
 			_scriptGlobal->setMod((int)_modCurrent->offset);
-			loadMod(mods[i].second, parser);
+			loadMod(mods[i].second, parser, reader);
 		}
 		catch (Exception &e)
 		{
@@ -1707,6 +1803,7 @@ void Mod::loadAll()
 			throwModOnErrorHelper(modId, e.what());
 		}
 	}
+	reader.saveCache();
 	Log(LOG_INFO) << "Loading rulesets done.";
 
 	//back master
@@ -1893,15 +1990,16 @@ void Mod::loadAll()
  * mod loaded should be the master at index 0, then 1, and so on.
  * @param rulesetFiles List of rulesets to load.
  * @param parsers Object with all available parsers.
+ * @param reader Source of the parsed ruleset files.
  */
-void Mod::loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, ModScript &parsers)
+void Mod::loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, ModScript &parsers, ModRulesetReader &reader)
 {
 	for (auto i = rulesetFiles.begin(); i != rulesetFiles.end(); ++i)
 	{
 		Log(LOG_VERBOSE) << "- " << i->fullpath;
 		try
 		{
-			loadFile(*i, parsers);
+			loadFile(reader.next(*i), parsers);
 		}
 		catch (YAML::Exception &e)
 		{
@@ -2059,12 +2157,11 @@ void Mod::loadConstants(const YAML::Node &node)
 /**
  * Loads a ruleset's contents from a YAML file.
  * Rules that match pre-existing rules overwrite them.
- * @param filename YAML filename.
+ * @param doc Parsed YAML file.
  * @param parsers Object with all available parsers.
  */
-void Mod::loadFile(const FileMap::FileRecord &filerec, ModScript &parsers)
+void Mod::loadFile(YAML::Node doc, ModScript &parsers)
 {
-	auto doc = filerec.getYAML();
 
 	if (const YAML::Node &extended = doc["extended"])
 	{
@@ -5091,13 +5188,27 @@ void Mod::loadExtraResources()
 	if (!Options::lazyLoadResources)
 	{
 		Log(LOG_INFO) << "Loading extra resources from ruleset...";
-		for (std::map<std::string, std::vector<ExtraSprites *> >::const_iterator i = _extraSprites.begin(); i != _extraSprites.end(); ++i)
+		// decode a batch of packs on the worker threads, then load them in the usual order
+		const size_t batchSize = 64;
+		std::vector<ExtraSprites*> batch;
+		auto loadBatch = [&]()
 		{
-			for (std::vector<ExtraSprites*>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+			ExtraSprites::decodeImages(batch);
+			for (std::vector<ExtraSprites*>::const_iterator j = batch.begin(); j != batch.end(); ++j)
 			{
 				loadExtraSprite(*j);
 			}
+			batch.clear();
+		};
+		for (std::map<std::string, std::vector<ExtraSprites *> >::const_iterator i = _extraSprites.begin(); i != _extraSprites.end(); ++i)
+		{
+			batch.insert(batch.end(), i->second.begin(), i->second.end());
+			if (batch.size() >= batchSize)
+			{
+				loadBatch();
+			}
 		}
+		loadBatch();
 	}
 
 	if (!Options::mute)
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "RuleGlobe.h"
+#include <algorithm>
 #include <SDL_endian.h>
 #include "../Engine/Exception.h"
 #include "Polygon.h"
@@ -30,10 +31,85 @@
 namespace OpenXcom
 {
 
+namespace
+{
+
+/// Polygons with a vertex further than this from a point (as a cosine) are never hit.
+const double Z_DISCARD = 0.75f;
+
+/**
+ * Converts a polar point to a unit vector.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @param v Vector to fill.
+ */
+void toVector(double lon, double lat, double v[3])
+{
+	v[0] = cos(lat) * cos(lon);
+	v[1] = cos(lat) * sin(lon);
+	v[2] = sin(lat);
+}
+
+/**
+ * Gets the angle between two unit vectors.
+ */
+double angleBetween(const double a[3], const double b[3])
+{
+	return acos(Clamp(a[0] * b[0] + a[1] * b[1] + a[2] * b[2], -1.0, 1.0));
+}
+
+/**
+ * Checks if a point is inside a polygon, the same way as the original
+ * game: the polygon is projected on the plane touching the globe at the
+ * point, and dropped if any of its vertices is too far away.
+ * @param poly Polygon to check.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @param coslat Cosine of the latitude.
+ * @param sinlat Sine of the latitude.
+ * @return True if the point is inside.
+ */
+bool insidePolygon(const Polygon *poly, double lon, double lat, double coslat, double sinlat)
+{
+	double x, y, z, x2, y2;
+	double clat, clon;
+	z = 0;
+	for (int j = 0; j < poly->getPoints(); ++j)
+	{
+		z = coslat * cos(poly->getLatitude(j)) * cos(poly->getLongitude(j) - lon) + sinlat * sin(poly->getLatitude(j));
+		if (z<Z_DISCARD) break; //discarded
+	}
+	if (z<Z_DISCARD) return false; //discarded
+
+	bool odd = false;
+
+	clat = poly->getLatitude(0); //initial point
+	clon = poly->getLongitude(0);
+	x = cos(clat) * sin(clon - lon);
+	y = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
+
+	for (int j = 0; j < poly->getPoints(); ++j)
+	{
+		int k = (j + 1) % poly->getPoints(); //index of next point in poly
+		clat = poly->getLatitude(k);
+		clon = poly->getLongitude(k);
+
+		x2 = cos(clat) * sin(clon - lon);
+		y2 = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
+		if ( ((y>0)!=(y2>0)) && (0 < (x2-x)*(0-y)/(y2-y)+x) )
+			odd = !odd;
+		x = x2;
+		y = y2;
+	}
+	return odd;
+}
+
+}
+
 /**
  * Creates a blank ruleset for globe contents.
  */
-RuleGlobe::RuleGlobe()
+RuleGlobe::RuleGlobe() : _indexValid(false)
 {
 }
 
@@ -62,6 +138,10 @@ RuleGlobe::~RuleGlobe()
  */
 void RuleGlobe::load(const YAML::Node &node)
 {
+	if (node["data"] || node["polygons"])
+	{
+		_indexValid = false;
+	}
 	if (node["data"])
 	{
 		for (std::list<Polygon*>::iterator i = _polygons.begin(); i != _polygons.end(); ++i)
@@ -148,6 +228,162 @@ std::list<Polygon*> *RuleGlobe::getPolygons()
 	return &_polygons;
 }
 
+/**
+ * Builds a lat/lon grid over the globe with the list of polygons that
+ * can contain a point in each cell, in the same order as the polygon list.
+ * A point can only be inside a polygon if it's a positive mix of its vertices
+ * and all of them are close to it, so each polygon gets a bounding cap
+ * and only lands in the cells touching that cap.
+ */
+void RuleGlobe::buildPolygonIndex()
+{
+	const double cellSize = M_PI / INDEX_LAT_CELLS;
+	const double margin = 0.001;
+	const double maxReach = acos(Z_DISCARD) + margin;
+
+	// bounding cap of every cell, from the center to the furthest border point
+	std::vector<double> cellCenters(INDEX_LAT_CELLS * INDEX_LON_CELLS * 3);
+	std::vector<double> cellRadius(INDEX_LAT_CELLS * INDEX_LON_CELLS);
+	for (int row = 0; row < INDEX_LAT_CELLS; ++row)
+	{
+		for (int col = 0; col < INDEX_LON_CELLS; ++col)
+		{
+			int cell = row * INDEX_LON_CELLS + col;
+			double lon = col * cellSize, lat = row * cellSize - M_PI / 2;
+			double *center = &cellCenters[cell * 3];
+			toVector(lon + cellSize / 2, lat + cellSize / 2, center);
+			double radius = 0;
+			for (int i = 0; i <= 2; ++i)
+			{
+				for (int j = 0; j <= 2; ++j)
+				{
+					double border[3];
+					toVector(lon + i * cellSize / 2, lat + j * cellSize / 2, border);
+					radius = std::max(radius, angleBetween(center, border));
+				}
+			}
+			cellRadius[cell] = radius + margin;
+		}
+	}
+
+	std::vector<std::vector<Polygon*> > cells(INDEX_LAT_CELLS * INDEX_LON_CELLS);
+	for (std::list<Polygon*>::iterator i = _polygons.begin(); i != _polygons.end(); ++i)
+	{
+		Polygon *poly = *i;
+		if (poly->getPoints() == 0)
+		{
+			continue;
+		}
+
+		// every vertex must be close to the point, so the first one gives a cap
+		double cap[3];
+		toVector(poly->getLongitude(0), poly->getLatitude(0), cap);
+		double capRadius = maxReach;
+
+		// and the point is between the vertices, so inside their own cap if it's small enough
+		double sum[3] = { 0, 0, 0 };
+		std::vector<double> vertices(poly->getPoints() * 3);
+		for (int j = 0; j < poly->getPoints(); ++j)
+		{
+			toVector(poly->getLongitude(j), poly->getLatitude(j), &vertices[j * 3]);
+			for (int k = 0; k < 3; ++k)
+			{
+				sum[k] += vertices[j * 3 + k];
+			}
+		}
+		double length = sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+		if (length > 0.001)
+		{
+			double centroid[3] = { sum[0] / length, sum[1] / length, sum[2] / length };
+			double radius = 0;
+			for (int j = 0; j < poly->getPoints(); ++j)
+			{
+				radius = std::max(radius, angleBetween(centroid, &vertices[j * 3]));
+			}
+			radius += margin;
+			if (radius < capRadius)
+			{
+				std::copy(centroid, centroid + 3, cap);
+				capRadius = radius;
+			}
+		}
+
+		double capLat = asin(Clamp(cap[2], -1.0, 1.0));
+		int rowMin = std::max(0, (int)floor((capLat - capRadius + M_PI / 2) / cellSize) - 1);
+		int rowMax = std::min(INDEX_LAT_CELLS - 1, (int)floor((capLat + capRadius + M_PI / 2) / cellSize) + 1);
+		for (int row = rowMin; row <= rowMax; ++row)
+		{
+			for (int col = 0; col < INDEX_LON_CELLS; ++col)
+			{
+				int cell = row * INDEX_LON_CELLS + col;
+				if (angleBetween(cap, &cellCenters[cell * 3]) <= capRadius + cellRadius[cell])
+				{
+					cells[cell].push_back(poly);
+				}
+			}
+		}
+	}
+
+	_cellStart.clear();
+	_cellPolygons.clear();
+	for (std::vector<std::vector<Polygon*> >::const_iterator i = cells.begin(); i != cells.end(); ++i)
+	{
+		_cellStart.push_back(_cellPolygons.size());
+		_cellPolygons.insert(_cellPolygons.end(), i->begin(), i->end());
+	}
+	_cellStart.push_back(_cellPolygons.size());
+	_indexValid = true;
+}
+
+/**
+ * Returns the first polygon in the list covering a polar point.
+ * Only the polygons listed for the grid cell of the point get checked,
+ * the grid is built on the first call after the polygons change.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Pointer to the polygon, or NULL if there's only water.
+ */
+Polygon *RuleGlobe::getPolygonAt(double lon, double lat)
+{
+	if (!_indexValid)
+	{
+		buildPolygonIndex();
+	}
+
+	double coslat = cos(lat);
+	double sinlat = sin(lat);
+	if (!(lat >= -M_PI / 2 && lat <= M_PI / 2))
+	{
+		// past the poles, the grid doesn't apply
+		for (std::list<Polygon*>::const_iterator i = _polygons.begin(); i != _polygons.end(); ++i)
+		{
+			if (insidePolygon(*i, lon, lat, coslat, sinlat))
+			{
+				return *i;
+			}
+		}
+		return NULL;
+	}
+
+	const double cellSize = M_PI / INDEX_LAT_CELLS;
+	double wrapLon = fmod(lon, 2 * M_PI);
+	if (wrapLon < 0)
+	{
+		wrapLon += 2 * M_PI;
+	}
+	int col = Clamp((int)(wrapLon / cellSize), 0, INDEX_LON_CELLS - 1);
+	int row = Clamp((int)((lat + M_PI / 2) / cellSize), 0, INDEX_LAT_CELLS - 1);
+	int cell = row * INDEX_LON_CELLS + col;
+	for (int i = _cellStart[cell]; i < _cellStart[cell + 1]; ++i)
+	{
+		if (insidePolygon(_cellPolygons[i], lon, lat, coslat, sinlat))
+		{
+			return _cellPolygons[i];
+		}
+	}
+	return NULL;
+}
+
 /**
  * Returns the list of polylines in the globe.
  * @return Pointer to the list of polylines.
@@ -165,6 +401,7 @@ std::list<Polyline*> *RuleGlobe::getPolylines()
  */
 void RuleGlobe::loadDat(const std::string &filename)
 {
+	_indexValid = false;
 	auto mapFile = FileMap::getIStream(filename);
 	short value[10];
 
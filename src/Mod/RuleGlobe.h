@@ -19,6 +19,7 @@
  */
 #include <list>
 #include <string>
+#include <vector>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -39,7 +40,15 @@ private:
 	std::list<Polygon*> _polygons;
 	std::list<Polyline*> _polylines;
 	std::map<int, Texture*> _textures;
+	std::vector<int> _cellStart;
+	std::vector<Polygon*> _cellPolygons;
+	bool _indexValid;
+
+	/// Builds the lists of polygons that can cover each grid cell.
+	void buildPolygonIndex();
 public:
+	/// Size of the polygon index grid, in cells around and from pole to pole.
+	static const int INDEX_LON_CELLS = 180, INDEX_LAT_CELLS = 90;
 	/// Creates a blank globe ruleset.
 	RuleGlobe();
 	/// Cleans up the globe ruleset.
@@ -48,6 +57,8 @@ public:
 	void load(const YAML::Node& node);
 	/// Gets the list of world polygons.
 	std::list<Polygon*> *getPolygons();
+	/// Gets the world polygon covering a point.
+	Polygon *getPolygonAt(double lon, double lat);
 	/// Gets the list of world polylines.
 	std::list<Polyline*> *getPolylines();
 	/// Loads a set of polygons from a DAT file.
@@ -0,0 +1,353 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "RulesetCache.h"
+#include <vector>
+#include "../Engine/BinaryIO.h"
+#include "../Engine/CrossPlatform.h"
+#include "../Engine/Exception.h"
+#include "../Engine/Logger.h"
+#include "../Engine/Options.h"
+
+namespace OpenXcom
+{
+namespace
+{
+/// Selects the YAML::as_if specialization below.
+struct NodeMarks { };
+}
+}
+
+namespace YAML
+{
+
+/**
+ * Node has no public way to set its mark, but as_if is its friend
+ * and can reach the node data. Used to give the nodes built from the
+ * cache the marks of the parsed file, so errors and !info report the
+ * same lines as without the cache.
+ */
+template<>
+struct as_if<OpenXcom::NodeMarks, void>
+{
+	static void set(Node &node, const Mark &mark)
+	{
+		if (node.m_pNode)
+		{
+			node.m_pNode->set_mark(mark);
+		}
+	}
+};
+
+}
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+const std::string CACHE_MAGIC = "OXCE ruleset cache";
+const Uint32 CACHE_VERSION = 2;
+/// Nodes nested deeper than this mean the cache is damaged.
+const int MAX_DEPTH = 256;
+
+enum NodeKind { KIND_NULL, KIND_SCALAR, KIND_SEQUENCE, KIND_MAP };
+
+/**
+ * Hashes the contents of a file (64-bit FNV-1a).
+ * @param text File contents.
+ * @return Hash value.
+ */
+Uint64 hashText(const std::string &text)
+{
+	Uint64 hash = 14695981039346656037ULL;
+	for (unsigned char c : text)
+	{
+		hash = (hash ^ c) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+/**
+ * Writes a node and everything under it.
+ * @param out Where to write.
+ * @param node Node to write.
+ */
+void writeNode(std::string &out, const YAML::Node &node)
+{
+	NodeKind kind = node.IsScalar() ? KIND_SCALAR : node.IsSequence() ? KIND_SEQUENCE : node.IsMap() ? KIND_MAP : KIND_NULL;
+	putBinaryNum(out, kind, 1);
+	putBinaryNum(out, node.Style(), 1);
+	putBinaryStr(out, node.Tag());
+	YAML::Mark mark = node.Mark();
+	putBinaryNum(out, (Uint32)mark.pos, 4);
+	putBinaryNum(out, (Uint32)mark.line, 4);
+	putBinaryNum(out, (Uint32)mark.column, 4);
+	switch (kind)
+	{
+	case KIND_SCALAR:
+		putBinaryStr(out, node.Scalar());
+		break;
+	case KIND_SEQUENCE:
+		putBinaryNum(out, node.size(), 4);
+		for (const auto &child : node)
+		{
+			writeNode(out, child);
+		}
+		break;
+	case KIND_MAP:
+		putBinaryNum(out, node.size(), 4);
+		for (const auto &child : node)
+		{
+			writeNode(out, child.first);
+			writeNode(out, child.second);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Builds a node and everything under it.
+ * @param in Where to read from.
+ * @param depth How deep the node is.
+ * @return The node, check the reader to see if it's valid.
+ */
+YAML::Node readNode(BinaryReader &in, int depth)
+{
+	YAML::Node node;
+	int kind = (int)in.num(1);
+	int style = (int)in.num(1);
+	std::string tag = in.str();
+	YAML::Mark mark;
+	mark.pos = (Sint32)in.num(4);
+	mark.line = (Sint32)in.num(4);
+	mark.column = (Sint32)in.num(4);
+	if (!in.ok || depth > MAX_DEPTH)
+	{
+		in.ok = false;
+		return node;
+	}
+	switch (kind)
+	{
+	case KIND_SCALAR:
+		node = YAML::Node(in.str());
+		break;
+	case KIND_SEQUENCE:
+		node = YAML::Node(YAML::NodeType::Sequence);
+		for (size_t i = in.num(4); in.ok && i > 0; --i)
+		{
+			node.push_back(readNode(in, depth + 1));
+		}
+		break;
+	case KIND_MAP:
+		node = YAML::Node(YAML::NodeType::Map);
+		for (size_t i = in.num(4); in.ok && i > 0; --i)
+		{
+			YAML::Node key = readNode(in, depth + 1);
+			YAML::Node value = readNode(in, depth + 1);
+			node.force_insert(key, value);
+		}
+		break;
+	case KIND_NULL:
+		node = YAML::Node(YAML::NodeType::Null);
+		break;
+	default:
+		in.ok = false;
+		return node;
+	}
+	node.SetTag(tag);
+	node.SetStyle((YAML::EmitterStyle::value)style);
+	YAML::as_if<NodeMarks, void>::set(node, mark);
+	return node;
+}
+
+}
+
+/**
+ * Loads the cache from the user folder, if it's turned on.
+ */
+RulesetCache::RulesetCache() : _enabled(Options::oxceRulesetCache), _dirty(false)
+{
+	if (!_enabled || !CrossPlatform::fileExists(getFilename()))
+	{
+		return;
+	}
+	std::string data;
+	try
+	{
+		auto raw = CrossPlatform::readFileRaw(getFilename());
+		data.assign(raw.begin(), raw.end());
+	}
+	catch (Exception &)
+	{
+		return;
+	}
+	BinaryReader in(data);
+	if (in.str() != CACHE_MAGIC || in.num(4) != CACHE_VERSION)
+	{
+		Log(LOG_INFO) << "RulesetCache: " << getFilename() << " is from a different version, rebuilding.";
+		return;
+	}
+	for (size_t i = in.num(4); in.ok && i > 0; --i)
+	{
+		std::string path = in.str();
+		Entry &entry = _entries[path];
+		entry.hash = in.num(8);
+		entry.data = in.str();
+		entry.used = false;
+	}
+	if (!in.ok)
+	{
+		Log(LOG_WARNING) << "RulesetCache: " << getFilename() << " is damaged, rebuilding.";
+		_entries.clear();
+		return;
+	}
+	Log(LOG_VERBOSE) << "RulesetCache: loaded " << _entries.size() << " files.";
+}
+
+/**
+ * Cleans up the cache.
+ */
+RulesetCache::~RulesetCache()
+{
+}
+
+/**
+ * Gets the path of the cache file.
+ * @return Full path.
+ */
+std::string RulesetCache::getFilename()
+{
+	return Options::getUserFolder() + "rulesets.cache";
+}
+
+/**
+ * Gets the document of a ruleset file, if the cache has
+ * it for the same contents. Safe to use from worker threads.
+ * @param path Full path of the file.
+ * @param text Contents of the file.
+ * @param doc Receives the document.
+ * @return True if it was found.
+ */
+bool RulesetCache::find(const std::string &path, const std::string &text, YAML::Node &doc)
+{
+	if (!_enabled)
+	{
+		return false;
+	}
+	Uint64 hash = hashText(text);
+	const Entry *entry;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _entries.find(path);
+		if (it == _entries.end() || it->second.hash != hash)
+		{
+			return false;
+		}
+		it->second.used = true;
+		entry = &it->second;
+	}
+	BinaryReader in(entry->data);
+	YAML::Node node = readNode(in, 0);
+	if (!in.ok)
+	{
+		return false;
+	}
+	doc = node;
+	return true;
+}
+
+/**
+ * Stores the document of a ruleset file, to be saved for the
+ * next run. Safe to use from worker threads.
+ * @param path Full path of the file.
+ * @param text Contents of the file.
+ * @param doc The parsed document.
+ */
+void RulesetCache::store(const std::string &path, const std::string &text, const YAML::Node &doc)
+{
+	if (!_enabled)
+	{
+		return;
+	}
+	std::string data;
+	writeNode(data, doc);
+	Uint64 hash = hashText(text);
+	std::lock_guard<std::mutex> lock(_mutex);
+	Entry &entry = _entries[path];
+	entry.hash = hash;
+	entry.data.swap(data);
+	entry.used = true;
+	_dirty = true;
+}
+
+/**
+ * Saves the cache if anything changed, dropping the files that weren't used.
+ * Should only be called once all the rules are loaded without errors.
+ */
+void RulesetCache::save()
+{
+	if (!_enabled)
+	{
+		return;
+	}
+	for (auto it = _entries.begin(); it != _entries.end(); )
+	{
+		if (!it->second.used)
+		{
+			it = _entries.erase(it);
+			_dirty = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+	if (_dirty)
+	{
+		write();
+	}
+}
+
+/**
+ * Writes all the entries to the cache file.
+ */
+void RulesetCache::write()
+{
+	_dirty = false;
+
+	std::string out;
+	putBinaryStr(out, CACHE_MAGIC);
+	putBinaryNum(out, CACHE_VERSION, 4);
+	putBinaryNum(out, _entries.size(), 4);
+	for (auto &entry : _entries)
+	{
+		putBinaryStr(out, entry.first);
+		putBinaryNum(out, entry.second.hash, 8);
+		putBinaryStr(out, entry.second.data);
+	}
+	if (CrossPlatform::writeFile(getFilename(), std::vector<unsigned char>(out.begin(), out.end())))
+	{
+		Log(LOG_VERBOSE) << "RulesetCache: saved " << _entries.size() << " files.";
+	}
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <yaml-cpp/yaml.h>
+#include <SDL_types.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Binary copies of the parsed ruleset files, kept between runs.
+ * Building the nodes back from them is a lot faster than having
+ * yaml-cpp parse the text again. Each file is checked against a hash
+ * of its contents, so only the files that changed get parsed.
+ * The copies keep the line and column of every node, so errors
+ * are reported the same as for a parsed file.
+ */
+class RulesetCache
+{
+private:
+	struct Entry
+	{
+		Uint64 hash;
+		std::string data;
+		bool used;
+	};
+	std::unordered_map<std::string, Entry> _entries;
+	std::mutex _mutex;
+	bool _enabled, _dirty;
+
+	/// Gets the path of the cache file.
+	static std::string getFilename();
+	/// Writes all the entries to the cache file.
+	void write();
+public:
+	/// Loads the cache from the user folder.
+	RulesetCache();
+	/// Cleans up the cache.
+	~RulesetCache();
+	/// Gets the cached document of a ruleset file.
+	bool find(const std::string &path, const std::string &text, YAML::Node &doc);
+	/// Stores the document of a ruleset file.
+	void store(const std::string &path, const std::string &text, const YAML::Node &doc);
+	/// Saves the cache if anything changed.
+	void save();
+};
+
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BackgroundSave.h"
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <yaml-cpp/yaml.h>
+#include "SavedGame.h"
+#include "../Engine/CrossPlatform.h"
+#include "../Engine/Exception.h"
+#include "../Engine/Options.h"
+
+namespace OpenXcom
+{
+
+namespace BackgroundSave
+{
+
+namespace
+{
+
+std::mutex _mutex;
+bool _finished = false;
+std::string _filename, _error;
+
+/**
+ * Owns the save thread, so it gets finished on any kind of exit.
+ */
+struct Worker
+{
+	std::thread thread;
+
+	~Worker()
+	{
+		wait();
+	}
+
+	void wait()
+	{
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+	}
+};
+
+Worker _worker;
+
+/**
+ * Writes the save to a backup file first and then replaces the old save
+ * with it, so a failed write never leaves a broken save behind.
+ * Runs on the save thread, errors are reported back through poll().
+ * @param snapshot Snapshot of the save, freed on this thread too.
+ * @param filename Save filename.
+ */
+void write(SaveSnapshot snapshot, std::string filename)
+{
+	std::string error;
+	try
+	{
+		std::string backup = filename + ".bak";
+		SavedGame::writeSnapshot(snapshot, backup);
+		std::string fullPath = Options::getMasterUserFolder() + filename;
+		std::string bakPath = Options::getMasterUserFolder() + backup;
+		if (!CrossPlatform::moveFile(bakPath, fullPath))
+		{
+			throw Exception("Save backed up in " + backup);
+		}
+	}
+	catch (Exception &e)
+	{
+		error = e.what();
+	}
+	catch (YAML::Exception &e)
+	{
+		error = e.what();
+	}
+	std::lock_guard<std::mutex> lock(_mutex);
+	_finished = true;
+	_filename = filename;
+	_error = error;
+}
+
+}
+
+/**
+ * Starts writing a snapshot to a save file on the save thread.
+ * The snapshot must not share anything with the running game.
+ * @param snapshot Snapshot of the save, taken over by the thread.
+ * @param filename Save filename.
+ */
+void start(SaveSnapshot &&snapshot, const std::string &filename)
+{
+	_worker.wait();
+	_worker.thread = std::thread(write, std::move(snapshot), filename);
+}
+
+/**
+ * Waits until the background save is written, if there is one.
+ * Needed before anything else touches the save files.
+ */
+void wait()
+{
+	_worker.wait();
+}
+
+/**
+ * Checks if a background save finished since the last check,
+ * so the result can be reported on the main thread.
+ * @param filename Returns the name of the save.
+ * @param error Returns the error message, empty if the save worked.
+ * @return True if a save finished.
+ */
+bool poll(std::string &filename, std::string &error)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_finished)
+	{
+		return false;
+	}
+	_finished = false;
+	filename = _filename;
+	error = _error;
+	return true;
+}
+
+}
+
+}
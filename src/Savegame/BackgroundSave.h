@@ -0,0 +1,42 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+
+namespace OpenXcom
+{
+
+struct SaveSnapshot;
+
+/**
+ * Writes autosaves on a background thread, so the game doesn't
+ * stop while the save is emitted and written to disk. Only one save
+ * is written at a time, starting another one waits for the previous.
+ */
+namespace BackgroundSave
+{
+	/// Starts writing a snapshot to a save file in the background.
+	void start(SaveSnapshot &&snapshot, const std::string &filename);
+	/// Waits until the background save is written.
+	void wait();
+	/// Checks if a background save finished since the last check.
+	bool poll(std::string &filename, std::string &error);
+}
+
+}
@@ -26,6 +26,7 @@
 #include "../Mod/RuleItem.h"
 #include "../Mod/RuleSkill.h"
 #include "../Mod/RuleInventory.h"
+#include "../Engine/ObjectPool.h"
 #include "../Engine/Collections.h"
 #include "../Engine/Surface.h"
 #include "../Engine/SurfaceSet.h"
@@ -95,6 +96,67 @@ BattleItem::~BattleItem()
 {
 }
 
+/**
+ * Allocates the memory of a new item in the item pool,
+ * instead of a separate heap block per item.
+ * @param size Size of the object.
+ * @return Memory for the item.
+ */
+void *BattleItem::operator new(size_t size)
+{
+	if (size != sizeof(BattleItem))
+	{
+		return ::operator new(size);
+	}
+	return getPool().allocate();
+}
+
+/**
+ * Returns the memory of a deleted item to the item pool.
+ * @param p Memory of the item.
+ * @param size Size of the object.
+ */
+void BattleItem::operator delete(void *p, size_t size)
+{
+	if (size != sizeof(BattleItem))
+	{
+		::operator delete(p);
+		return;
+	}
+	getPool().deallocate(p);
+}
+
+/**
+ * Gets the pool holding all items. It's never destroyed, so items
+ * can still be deleted safely while the program exits.
+ * @return The item pool.
+ */
+ObjectPool<BattleItem> &BattleItem::getPool()
+{
+	static ObjectPool<BattleItem> *pool = new ObjectPool<BattleItem>();
+	return *pool;
+}
+
+/**
+ * Gets an item by its handle.
+ * @param handle Handle from getHandle().
+ * @return Pointer to the item, or null if it was deleted.
+ */
+BattleItem *BattleItem::getByHandle(Uint32 handle)
+{
+	return getPool().get(handle);
+}
+
+/**
+ * Gets the handle of the item. Unlike the pointer, it can be
+ * kept around and checked after the item gets deleted.
+ * @return Handle of the item.
+ */
+Uint32 BattleItem::getHandle() const
+{
+	return ObjectPool<BattleItem>::getHandle(this);
+}
+
 /**
  * Loads the item from a YAML file.
  * @param node YAML node.
@@ -24,6 +24,7 @@
 namespace OpenXcom
 {
 
+template<typename T> class ObjectPool;
 class RuleItem;
 class RuleInventory;
 class BattleUnit;
@@ -78,6 +79,16 @@ public:
 	BattleItem(const RuleItem *rules, int *id);
 	/// Cleans up the item.
 	~BattleItem();
+	/// Allocates an item in the item pool.
+	static void *operator new(size_t size);
+	/// Frees an item from the item pool.
+	static void operator delete(void *p, size_t size);
+	/// Gets the pool holding all items.
+	static ObjectPool<BattleItem> &getPool();
+	/// Gets an item by its handle.
+	static BattleItem *getByHandle(Uint32 handle);
+	/// Gets the handle of the item.
+	Uint32 getHandle() const;
 	/// Loads the item from YAML.
 	void load(const YAML::Node& node, Mod *mod, const ScriptGlobal *shared);
 	/// Saves the item to YAML.
@@ -20,6 +20,7 @@
 #include "BattleItem.h"
 #include <sstream>
 #include <algorithm>
+#include "../Engine/ObjectPool.h"
 #include "../Engine/Surface.h"
 #include "../Engine/Script.h"
 #include "../Engine/ScriptBind.h"
@@ -32,6 +33,7 @@
 #include "../Battlescape/AIModule.h"
 #include "../Battlescape/Inventory.h"
 #include "../Battlescape/TileEngine.h"
+#include "../Battlescape/UnitGrid.h"
 #include "../Mod/Mod.h"
 #include "../Mod/Armor.h"
 #include "../Mod/Unit.h"
@@ -65,7 +67,7 @@ BattleUnit::BattleUnit(const Mod *mod, Soldier *soldier, int depth) :
 	_verticalDirection(0), _status(STATUS_STANDING), _wantsToSurrender(false), _isSurrendering(false), _walkPhase(0), _fallPhase(0), _kneeled(false), _floating(false),
 	_dontReselect(false), _fire(0), _currentAIState(0), _visible(false),
 	_exp{ }, _expTmp{ },
-	_motionPoints(0), _scannedTurn(-1), _kills(0), _hitByFire(false), _hitByAnything(false), _alreadyExploded(false), _fireMaxHit(0), _smokeMaxHit(0), _moraleRestored(0), _charging(0), _turnsSinceSpotted(255), _turnsLeftSpottedForSnipers(0),
+	_motionPoints(0), _scannedTurn(-1), _kills(0), _hitByFire(false), _hitByAnything(false), _alreadyExploded(false), _fireMaxHit(0), _smokeMaxHit(0), _moraleRestored(0), _charging(ObjectPool<BattleUnit>::INVALID_HANDLE), _turnsSinceSpotted(255), _turnsLeftSpottedForSnipers(0),
 	_statistics(), _murdererId(0), _mindControllerID(0), _fatalShotSide(SIDE_FRONT), _fatalShotBodyPart(BODYPART_HEAD), _armor(0),
 	_geoscapeSoldier(soldier), _unitRules(0), _rankInt(0), _turretType(-1), _hidingForTurn(false), _floorAbove(false), _respawn(false), _alreadyRespawned(false),
 	_isLeeroyJenkins(false), _summonedPlayerUnit(false), _resummonedFakeCivilian(false), _pickUpWeaponsMoreActively(false), _disableIndicators(false), _capturable(true), _vip(false)
@@ -398,7 +400,7 @@ BattleUnit::BattleUnit(const Mod *mod, Unit *unit, UnitFaction faction, int id,
 	_fallPhase(0), _kneeled(false), _floating(false), _dontReselect(false), _fire(0), _currentAIState(0),
 	_visible(false), _exp{ }, _expTmp{ },
 	_motionPoints(0), _scannedTurn(-1), _kills(0), _hitByFire(false), _hitByAnything(false), _alreadyExploded(false), _fireMaxHit(0), _smokeMaxHit(0),
-	_moraleRestored(0), _charging(0), _turnsSinceSpotted(255), _turnsLeftSpottedForSnipers(0),
+	_moraleRestored(0), _charging(ObjectPool<BattleUnit>::INVALID_HANDLE), _turnsSinceSpotted(255), _turnsLeftSpottedForSnipers(0),
 	_statistics(), _murdererId(0), _mindControllerID(0), _fatalShotSide(SIDE_FRONT),
 	_fatalShotBodyPart(BODYPART_HEAD), _armor(armor), _geoscapeSoldier(0),  _unitRules(unit),
 	_rankInt(0), _turretType(-1), _hidingForTurn(false), _respawn(false), _alreadyRespawned(false),
@@ -565,6 +567,67 @@ BattleUnit::~BattleUnit()
 	delete _currentAIState;
 }
 
+/**
+ * Allocates the memory of a new unit in the unit pool,
+ * instead of a separate heap block per unit.
+ * @param size Size of the object.
+ * @return Memory for the unit.
+ */
+void *BattleUnit::operator new(size_t size)
+{
+	if (size != sizeof(BattleUnit))
+	{
+		return ::operator new(size);
+	}
+	return getPool().allocate();
+}
+
+/**
+ * Returns the memory of a deleted unit to the unit pool.
+ * @param p Memory of the unit.
+ * @param size Size of the object.
+ */
+void BattleUnit::operator delete(void *p, size_t size)
+{
+	if (size != sizeof(BattleUnit))
+	{
+		::operator delete(p);
+		return;
+	}
+	getPool().deallocate(p);
+}
+
+/**
+ * Gets the pool holding all units. It's never destroyed, so units
+ * can still be deleted safely while the program exits.
+ * @return The unit pool.
+ */
+ObjectPool<BattleUnit> &BattleUnit::getPool()
+{
+	static ObjectPool<BattleUnit> *pool = new ObjectPool<BattleUnit>();
+	return *pool;
+}
+
+/**
+ * Gets a unit by its handle.
+ * @param handle Handle from getHandle().
+ * @return Pointer to the unit, or null if it was deleted.
+ */
+BattleUnit *BattleUnit::getByHandle(Uint32 handle)
+{
+	return getPool().get(handle);
+}
+
+/**
+ * Gets the handle of the unit. Unlike the pointer, it can be
+ * kept around and checked after the unit gets deleted.
+ * @return Handle of the unit.
+ */
+Uint32 BattleUnit::getHandle() const
+{
+	return ObjectPool<BattleUnit>::getHandle(this);
+}
+
 /**
  * Loads the unit from a YAML file.
  * @param node YAML node.
@@ -611,7 +674,7 @@ void BattleUnit::load(const YAML::Node &node, const Mod *mod, const ScriptGlobal
 	_rankInt = node["rankInt"].as<int>(_rankInt);
 	_kills = node["kills"].as<int>(_kills);
 	_dontReselect = node["dontReselect"].as<bool>(_dontReselect);
-	_charging = 0;
+	_charging = ObjectPool<BattleUnit>::INVALID_HANDLE;
 	if (const YAML::Node& spawn = node["spawnUnit"])
 	{
 		_spawnUnit = mod->getUnit(spawn.as<std::string>(), false); //ignored bugged types
@@ -2978,6 +3041,10 @@ void BattleUnit::setTile(Tile *tile, SavedBattleGame *saveBattleGame)
 	}
 
 	_tile = tile;
+	if (saveBattleGame && saveBattleGame->getUnitGrid())
+	{
+		saveBattleGame->getUnitGrid()->update(this);
+	}
 	if (!_tile)
 	{
 		_floating = false;
@@ -4161,20 +4228,21 @@ void BattleUnit::killedBy(UnitFaction f)
 
 /**
  * Set the units we are charging towards.
+ * The target is kept by handle, as the charge can last for several turns.
  * @param chargeTarget Charge Target
  */
 void BattleUnit::setCharging(BattleUnit *chargeTarget)
 {
-	_charging = chargeTarget;
+	_charging = chargeTarget ? chargeTarget->getHandle() : ObjectPool<BattleUnit>::INVALID_HANDLE;
 }
 
 /**
  * Get the units we are charging towards.
- * @return Charge Target
+ * @return Charge Target, or null if it was deleted in the meantime.
  */
 BattleUnit *BattleUnit::getCharging()
 {
-	return _charging;
+	return getByHandle(_charging);
 }
 
 /**
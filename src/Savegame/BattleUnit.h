@@ -28,6 +28,7 @@
 namespace OpenXcom
 {
 
+template<typename T> class ObjectPool;
 class Tile;
 class BattleItem;
 class Armor;
@@ -120,7 +121,7 @@ private:
 	int _fireMaxHit;
 	int _smokeMaxHit;
 	int _moraleRestored;
-	BattleUnit *_charging;
+	Uint32 _charging;
 	int _turnsSinceSpotted, _turnsLeftSpottedForSnipers, _turnsSinceStunned = 255;
 	const Unit *_spawnUnit = nullptr;
 	std::string _activeHand;
@@ -206,6 +207,16 @@ public:
 	void updateArmorFromSoldier(const Mod *mod, Soldier *soldier, Armor *ruleArmor, int depth);
 	/// Cleans up the BattleUnit.
 	~BattleUnit();
+	/// Allocates a unit in the unit pool.
+	static void *operator new(size_t size);
+	/// Frees a unit from the unit pool.
+	static void operator delete(void *p, size_t size);
+	/// Gets the pool holding all units.
+	static ObjectPool<BattleUnit> &getPool();
+	/// Gets a unit by its handle.
+	static BattleUnit *getByHandle(Uint32 handle);
+	/// Gets the handle of the unit.
+	Uint32 getHandle() const;
 	/// Loads the unit from YAML.
 	void load(const YAML::Node &node, const Mod *mod, const ScriptGlobal *shared);
 	/// Saves the unit to YAML.
@@ -0,0 +1,729 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BinarySave.h"
+#include <string.h>
+#include <SDL.h>
+#include "../Engine/Exception.h"
+#include "../fallthrough.h"
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+const char MAGIC[4] = { 'O', 'X', 'S', 'B' };
+
+/// Tag yaml-cpp uses for base64 encoded binary data.
+const std::string BINARY_TAG = "tag:yaml.org,2002:binary";
+
+/// Types of the tokens starting each node.
+enum Token : Uint8
+{
+	TOKEN_NULL,
+	TOKEN_SCALAR,
+	TOKEN_TAGGED_SCALAR,
+	TOKEN_BINARY,
+	TOKEN_SEQ,
+	TOKEN_MAP,
+	TOKEN_END,
+	TOKEN_KEY_DEF,
+	TOKEN_KEY_REF,
+	// since version 2
+	TOKEN_PLAIN_SCALAR,
+	TOKEN_QUOTED_SCALAR,
+	TOKEN_PLAIN_KEY_DEF,
+	TOKEN_PLAIN_KEY_REF,
+	TOKEN_TAG
+};
+
+/// Tag yaml-cpp gives to plain scalars read from text, nodes made in code have none.
+const std::string PLAIN_TAG = "?";
+/// Tag yaml-cpp gives to quoted scalars read from text.
+const std::string QUOTED_TAG = "!";
+
+/**
+ * Checks if a token starts a key stored by number.
+ * @param token Token to check.
+ * @return True for a key token.
+ */
+bool isKeyToken(Uint8 token)
+{
+	return token == TOKEN_KEY_DEF || token == TOKEN_KEY_REF || token == TOKEN_PLAIN_KEY_DEF || token == TOKEN_PLAIN_KEY_REF;
+}
+
+void writeUint32(Uint8 *w, Uint32 value)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		w[i] = (value >> (i * 8)) & 0xFF;
+	}
+}
+
+Uint32 readUint32(const Uint8 *r)
+{
+	Uint32 value = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		value |= (Uint32)r[i] << (i * 8);
+	}
+	return value;
+}
+
+/**
+ * Checks the header of a binary save.
+ * @param data Save data, at least HEADER_SIZE long.
+ * @return Size of the brief save info.
+ */
+Uint32 checkHeader(const Uint8 *data)
+{
+	if (memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		throw Exception("Not a binary save");
+	}
+	Uint32 version = readUint32(data + 4);
+	if (version > BinarySave::VERSION)
+	{
+		throw Exception("Binary save version " + std::to_string(version) + " is not supported");
+	}
+	return readUint32(data + 8);
+}
+
+}
+
+namespace BinarySave
+{
+
+/**
+ * Checks if some data starts with a binary save header.
+ * @param data Pointer to the data.
+ * @param size Size of the data.
+ * @return True if it's a binary save.
+ */
+bool isBinary(const Uint8 *data, size_t size)
+{
+	return size >= HEADER_SIZE && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/**
+ * Converts a binary save to the YAML text that saving
+ * the same game in YAML would write.
+ * @param data Binary save.
+ * @return YAML save.
+ */
+std::string toYaml(const std::vector<Uint8> &data)
+{
+	BinarySaveReader in(data.data(), data.size());
+	YAML::Emitter out;
+	out << in.node();
+	out << YAML::BeginDoc;
+	out << in.node();
+	return out.c_str();
+}
+
+/**
+ * Converts the YAML text of a save to a binary save.
+ * @param yaml YAML save, with the brief info and game documents.
+ * @return Binary save.
+ */
+std::vector<Uint8> fromYaml(const std::string &yaml)
+{
+	std::vector<YAML::Node> docs = YAML::LoadAll(yaml);
+	if (docs.size() != 2)
+	{
+		throw Exception("Save must have two documents");
+	}
+	BinarySaveWriter out(docs[0]);
+	out.node(docs[1]);
+	return out.getData();
+}
+
+/**
+ * Loads the brief save info from a binary save file,
+ * without reading the rest of it.
+ * @param filename Full path of the save.
+ * @param brief Node to store the brief info in.
+ * @return False if the file isn't a binary save.
+ */
+bool loadBrief(const std::string &filename, YAML::Node &brief)
+{
+	SDL_RWops *rwops = SDL_RWFromFile(filename.c_str(), "rb");
+	if (!rwops)
+	{
+		throw Exception("Failed to read " + filename + ": " + SDL_GetError());
+	}
+	std::vector<Uint8> data(HEADER_SIZE);
+	if (SDL_RWread(rwops, data.data(), HEADER_SIZE, 1) != 1 || !isBinary(data.data(), data.size()))
+	{
+		SDL_RWclose(rwops);
+		return false;
+	}
+	Uint32 briefSize = checkHeader(data.data());
+	data.resize(HEADER_SIZE + briefSize);
+	bool ok = briefSize == 0 || SDL_RWread(rwops, data.data() + HEADER_SIZE, briefSize, 1) == 1;
+	SDL_RWclose(rwops);
+	if (!ok)
+	{
+		throw Exception("Failed to read " + filename);
+	}
+	BinarySaveReader in(data.data(), data.size());
+	brief = in.node();
+	return true;
+}
+
+}
+
+/**
+ * Starts a binary save, writing the header and the brief save info.
+ * The game data needs to be written next as a single node.
+ * @param brief Brief save info, as shown in the saves list.
+ */
+BinarySaveWriter::BinarySaveWriter(const YAML::Node &brief)
+{
+	_data.resize(BinarySave::HEADER_SIZE);
+	memcpy(_data.data(), MAGIC, sizeof(MAGIC));
+	writeUint32(_data.data() + 4, BinarySave::VERSION);
+	node(brief);
+	writeUint32(_data.data() + 8, _data.size() - BinarySave::HEADER_SIZE);
+}
+
+/**
+ * Cleans up the writer.
+ */
+BinarySaveWriter::~BinarySaveWriter()
+{
+
+}
+
+/**
+ * Writes a number using 7 bits per byte, so small numbers take one byte.
+ * @param value Number to write.
+ */
+void BinarySaveWriter::writeSize(size_t value)
+{
+	while (value >= 0x80)
+	{
+		_data.push_back((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	_data.push_back(value);
+}
+
+/**
+ * Writes a string preceded by its length.
+ * @param value String to write.
+ */
+void BinarySaveWriter::writeString(const std::string &value)
+{
+	writeSize(value.size());
+	_data.insert(_data.end(), value.begin(), value.end());
+}
+
+/**
+ * Starts a map, which must be followed by pairs of key() and
+ * a value, and closed with end().
+ */
+void BinarySaveWriter::beginMap()
+{
+	_data.push_back(TOKEN_MAP);
+}
+
+/**
+ * Starts a sequence, which must be followed by its values,
+ * and closed with end().
+ */
+void BinarySaveWriter::beginSeq()
+{
+	_data.push_back(TOKEN_SEQ);
+}
+
+/**
+ * Ends the current map or sequence.
+ */
+void BinarySaveWriter::end()
+{
+	_data.push_back(TOKEN_END);
+}
+
+/**
+ * Writes the key of the next map entry.
+ * @param name Key.
+ */
+void BinarySaveWriter::key(const std::string &name)
+{
+	writeKey(name, false);
+}
+
+/**
+ * Writes a map key. The first time a key is used it gets
+ * a number, which is all that's written after that.
+ * @param name Key.
+ * @param plain Does the key have the tag of plain scalars read from text?
+ */
+void BinarySaveWriter::writeKey(const std::string &name, bool plain)
+{
+	auto it = _keys.find(name);
+	if (it != _keys.end())
+	{
+		_data.push_back(plain ? TOKEN_PLAIN_KEY_REF : TOKEN_KEY_REF);
+		writeSize(it->second);
+	}
+	else
+	{
+		Uint32 id = _keys.size();
+		_keys[name] = id;
+		_data.push_back(plain ? TOKEN_PLAIN_KEY_DEF : TOKEN_KEY_DEF);
+		writeSize(id);
+		writeString(name);
+	}
+}
+
+/**
+ * Writes a whole node with everything in it.
+ * Base64 encoded binary data is stored decoded.
+ * @param value Node to write.
+ */
+void BinarySaveWriter::node(const YAML::Node &value)
+{
+	if (!value.IsScalar() && !value.Tag().empty())
+	{
+		// tag of a map, sequence or null, goes before its token
+		_data.push_back(TOKEN_TAG);
+		writeString(value.Tag());
+	}
+	switch (value.Type())
+	{
+	case YAML::NodeType::Scalar:
+		if (value.Tag() == BINARY_TAG || value.Tag() == "!!binary")
+		{
+			std::vector<unsigned char> decoded = YAML::DecodeBase64(value.Scalar());
+			binary(decoded.data(), decoded.size());
+		}
+		else if (value.Tag().empty())
+		{
+			_data.push_back(TOKEN_SCALAR);
+			writeString(value.Scalar());
+		}
+		else if (value.Tag() == PLAIN_TAG || value.Tag() == QUOTED_TAG)
+		{
+			_data.push_back(value.Tag() == PLAIN_TAG ? TOKEN_PLAIN_SCALAR : TOKEN_QUOTED_SCALAR);
+			writeString(value.Scalar());
+		}
+		else
+		{
+			_data.push_back(TOKEN_TAGGED_SCALAR);
+			writeString(value.Tag());
+			writeString(value.Scalar());
+		}
+		break;
+	case YAML::NodeType::Sequence:
+		beginSeq();
+		for (YAML::const_iterator i = value.begin(); i != value.end(); ++i)
+		{
+			node(*i);
+		}
+		end();
+		break;
+	case YAML::NodeType::Map:
+		beginMap();
+		entries(value);
+		end();
+		break;
+	default:
+		_data.push_back(TOKEN_NULL);
+		break;
+	}
+}
+
+/**
+ * Writes all the entries of a map node into the current map,
+ * so it can be followed by more entries.
+ * @param map Map node.
+ */
+void BinarySaveWriter::entries(const YAML::Node &map)
+{
+	for (YAML::const_iterator i = map.begin(); i != map.end(); ++i)
+	{
+		if (i->first.IsScalar() && (i->first.Tag().empty() || i->first.Tag() == PLAIN_TAG))
+		{
+			writeKey(i->first.Scalar(), !i->first.Tag().empty());
+		}
+		else
+		{
+			node(i->first);
+		}
+		node(i->second);
+	}
+}
+
+/**
+ * Writes a block of raw data, read back as base64 by YAML loaders.
+ * @param data Pointer to the data.
+ * @param size Size of the data.
+ */
+void BinarySaveWriter::binary(const void *data, size_t size)
+{
+	_data.push_back(TOKEN_BINARY);
+	writeSize(size);
+	_data.insert(_data.end(), (const Uint8*)data, (const Uint8*)data + size);
+}
+
+/**
+ * Starts reading a save from memory, right at the brief save info.
+ * The data must stay around while the reader is used.
+ * @param data Pointer to the save data.
+ * @param size Size of the save data.
+ */
+BinarySaveReader::BinarySaveReader(const Uint8 *data, size_t size) : _data(data), _size(size), _pos(BinarySave::HEADER_SIZE)
+{
+	if (!BinarySave::isBinary(data, size))
+	{
+		throw Exception("Not a binary save");
+	}
+	checkHeader(data);
+}
+
+/**
+ * Cleans up the reader.
+ */
+BinarySaveReader::~BinarySaveReader()
+{
+
+}
+
+/**
+ * Reads the next byte.
+ * @return Byte.
+ */
+Uint8 BinarySaveReader::readByte()
+{
+	if (_pos >= _size)
+	{
+		throw Exception("Unexpected end of binary save");
+	}
+	return _data[_pos++];
+}
+
+/**
+ * Reads a number written by BinarySaveWriter::writeSize.
+ * @return Number.
+ */
+size_t BinarySaveReader::readSize()
+{
+	size_t value = 0;
+	for (int shift = 0; ; shift += 7)
+	{
+		Uint8 b = readByte();
+		value |= (size_t)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+		{
+			return value;
+		}
+	}
+}
+
+/**
+ * Reads a string preceded by its length.
+ * @return String.
+ */
+std::string BinarySaveReader::readString()
+{
+	size_t size = readSize();
+	if (size > _size - _pos)
+	{
+		throw Exception("Unexpected end of binary save");
+	}
+	std::string value((const char*)_data + _pos, size);
+	_pos += size;
+	return value;
+}
+
+/**
+ * Reads a key, remembering its number if it's the first time
+ * it's used. Keys are stored by number, so reading the same part
+ * again after seek() works too.
+ * @param token Token of the key.
+ * @return Key.
+ */
+const std::string &BinarySaveReader::readKey(Uint8 token)
+{
+	size_t id = readSize();
+	if (token == TOKEN_KEY_DEF || token == TOKEN_PLAIN_KEY_DEF)
+	{
+		if (id >= _keys.size())
+		{
+			_keys.resize(id + 1);
+		}
+		_keys[id] = readString();
+	}
+	else if (id >= _keys.size())
+	{
+		throw Exception("Invalid key in binary save");
+	}
+	return _keys[id];
+}
+
+/**
+ * Reads the next token and checks it's the expected one.
+ * @param token Expected token.
+ */
+void BinarySaveReader::expect(Uint8 token)
+{
+	if (_pos < _size && _data[_pos] == TOKEN_TAG)
+	{
+		// the objects don't use tags
+		++_pos;
+		readString();
+	}
+	if (readByte() != token)
+	{
+		throw Exception("Unexpected data in binary save");
+	}
+}
+
+/**
+ * Enters a map, its entries are read with next(), key() and
+ * a value until next() returns false.
+ */
+void BinarySaveReader::beginMap()
+{
+	expect(TOKEN_MAP);
+}
+
+/**
+ * Enters a sequence, its values are read while next() returns true.
+ */
+void BinarySaveReader::beginSeq()
+{
+	expect(TOKEN_SEQ);
+}
+
+/**
+ * Checks if the current map or sequence has another entry,
+ * leaving it if not.
+ * @return True if there's another entry.
+ */
+bool BinarySaveReader::next()
+{
+	if (_pos < _size && _data[_pos] == TOKEN_END)
+	{
+		++_pos;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Reads the key of the next map entry.
+ * @return Key.
+ */
+std::string BinarySaveReader::key()
+{
+	Uint8 token = readByte();
+	if (isKeyToken(token))
+	{
+		return readKey(token);
+	}
+	return readNode(token).as<std::string>();
+}
+
+/**
+ * Reads a whole node with everything in it.
+ * @return YAML node.
+ */
+YAML::Node BinarySaveReader::node()
+{
+	return readNode(readByte());
+}
+
+/**
+ * Reads the rest of a node after its token.
+ * Raw data becomes base64 tagged as binary, same as YAML would store it.
+ * @param token Token of the node.
+ * @return YAML node.
+ */
+YAML::Node BinarySaveReader::readNode(Uint8 token)
+{
+	switch (token)
+	{
+	case TOKEN_NULL:
+		return YAML::Node(YAML::NodeType::Null);
+	case TOKEN_SCALAR:
+		return YAML::Node(readString());
+	case TOKEN_PLAIN_SCALAR:
+	case TOKEN_QUOTED_SCALAR:
+	{
+		YAML::Node value(readString());
+		value.SetTag(token == TOKEN_PLAIN_SCALAR ? PLAIN_TAG : QUOTED_TAG);
+		return value;
+	}
+	case TOKEN_TAGGED_SCALAR:
+	{
+		std::string tag = readString();
+		YAML::Node value(readString());
+		value.SetTag(tag);
+		return value;
+	}
+	case TOKEN_TAG:
+	{
+		std::string tag = readString();
+		YAML::Node value = node();
+		value.SetTag(tag);
+		return value;
+	}
+	case TOKEN_BINARY:
+	{
+		size_t size;
+		--_pos;
+		const Uint8 *data = binary(size);
+		YAML::Node value(YAML::EncodeBase64(data, size));
+		value.SetTag(BINARY_TAG);
+		return value;
+	}
+	case TOKEN_SEQ:
+	{
+		YAML::Node value(YAML::NodeType::Sequence);
+		while (next())
+		{
+			value.push_back(node());
+		}
+		return value;
+	}
+	case TOKEN_MAP:
+	{
+		YAML::Node value(YAML::NodeType::Map);
+		while (next())
+		{
+			Uint8 keyToken = readByte();
+			if (isKeyToken(keyToken))
+			{
+				// copied, reading the value can add keys and move the list
+				YAML::Node name(readKey(keyToken));
+				if (keyToken == TOKEN_PLAIN_KEY_DEF || keyToken == TOKEN_PLAIN_KEY_REF)
+				{
+					name.SetTag(PLAIN_TAG);
+				}
+				value.force_insert(name, node());
+			}
+			else
+			{
+				YAML::Node complexKey = readNode(keyToken);
+				value.force_insert(complexKey, node());
+			}
+		}
+		return value;
+	}
+	default:
+		throw Exception("Unexpected data in binary save");
+	}
+}
+
+/**
+ * Skips a whole node without building anything.
+ */
+void BinarySaveReader::skip()
+{
+	skipNode(readByte());
+}
+
+/**
+ * Skips the rest of a node after its token.
+ * Key definitions inside it are still remembered.
+ * @param token Token of the node.
+ */
+void BinarySaveReader::skipNode(Uint8 token)
+{
+	switch (token)
+	{
+	case TOKEN_NULL:
+		break;
+	case TOKEN_TAG:
+		readString();
+		skip();
+		break;
+	case TOKEN_TAGGED_SCALAR:
+		readString();
+		FALLTHROUGH;
+	case TOKEN_SCALAR:
+	case TOKEN_PLAIN_SCALAR:
+	case TOKEN_QUOTED_SCALAR:
+	case TOKEN_BINARY:
+	{
+		size_t size = readSize();
+		if (size > _size - _pos)
+		{
+			throw Exception("Unexpected end of binary save");
+		}
+		_pos += size;
+		break;
+	}
+	case TOKEN_SEQ:
+		while (next())
+		{
+			skip();
+		}
+		break;
+	case TOKEN_MAP:
+		while (next())
+		{
+			Uint8 keyToken = readByte();
+			if (isKeyToken(keyToken))
+			{
+				readKey(keyToken);
+			}
+			else
+			{
+				skipNode(keyToken);
+			}
+			skip();
+		}
+		break;
+	default:
+		throw Exception("Unexpected data in binary save");
+	}
+}
+
+/**
+ * Checks if the next node is a block of raw data.
+ * @return True for raw data.
+ */
+bool BinarySaveReader::isBinary() const
+{
+	return _pos < _size && _data[_pos] == TOKEN_BINARY;
+}
+
+/**
+ * Reads a block of raw data without copying it.
+ * @param size Returns the size of the data.
+ * @return Pointer to the data inside the save buffer.
+ */
+const Uint8 *BinarySaveReader::binary(size_t &size)
+{
+	expect(TOKEN_BINARY);
+	size = readSize();
+	if (size > _size - _pos)
+	{
+		throw Exception("Unexpected end of binary save");
+	}
+	const Uint8 *data = _data + _pos;
+	_pos += size;
+	return data;
+}
+
+}
@@ -0,0 +1,147 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include <SDL_types.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Binary save format, holding the same documents as a YAML save.
+ * The file starts with a header and the brief save info, followed by the
+ * full game data. Every node is written as a token followed by its data,
+ * and map keys are only written in full the first time they're used.
+ * Saves can be converted between both formats without losing anything.
+ */
+namespace BinarySave
+{
+	/// Version of the format, increased on incompatible changes.
+	const Uint32 VERSION = 2;
+	/// Size of the file header.
+	const size_t HEADER_SIZE = 12;
+
+	/// Checks if some data starts with a binary save header.
+	bool isBinary(const Uint8 *data, size_t size);
+	/// Converts a binary save to the YAML text of the same save.
+	std::string toYaml(const std::vector<Uint8> &data);
+	/// Converts the YAML text of a save to a binary save.
+	std::vector<Uint8> fromYaml(const std::string &yaml);
+	/// Loads only the brief save info from a binary save file.
+	bool loadBrief(const std::string &filename, YAML::Node &brief);
+}
+
+/**
+ * Writes a binary save, one node at a time, so the objects
+ * don't need to be gathered into one big YAML tree first.
+ */
+class BinarySaveWriter
+{
+private:
+	std::vector<Uint8> _data;
+	std::unordered_map<std::string, Uint32> _keys;
+
+	/// Writes a number in as few bytes as needed.
+	void writeSize(size_t value);
+	/// Writes a string with its length.
+	void writeString(const std::string &value);
+	/// Writes a map key by number.
+	void writeKey(const std::string &name, bool plain);
+public:
+	/// Starts a save with the brief save info.
+	BinarySaveWriter(const YAML::Node &brief);
+	/// Cleans up the writer.
+	~BinarySaveWriter();
+	/// Starts a map, which is a list of keys and values.
+	void beginMap();
+	/// Starts a sequence.
+	void beginSeq();
+	/// Ends the current map or sequence.
+	void end();
+	/// Writes the key of the next map entry.
+	void key(const std::string &name);
+	/// Writes a whole node.
+	void node(const YAML::Node &value);
+	/// Writes all the entries of a map node into the current map.
+	void entries(const YAML::Node &map);
+	/// Writes a block of raw data.
+	void binary(const void *data, size_t size);
+	/// Gets the written save.
+	const std::vector<Uint8> &getData() const { return _data; }
+	/// Takes the written save out of the writer.
+	std::vector<Uint8> takeData() { return std::move(_data); }
+};
+
+/**
+ * Reads a binary save in the order it was written, only building
+ * YAML nodes for the parts the caller asks for.
+ */
+class BinarySaveReader
+{
+private:
+	const Uint8 *_data;
+	size_t _size, _pos;
+	std::vector<std::string> _keys;
+
+	/// Reads the next byte.
+	Uint8 readByte();
+	/// Reads a number written by writeSize.
+	size_t readSize();
+	/// Reads a string with its length.
+	std::string readString();
+	/// Reads a key definition or reference.
+	const std::string &readKey(Uint8 token);
+	/// Reads the next token and checks it's the expected one.
+	void expect(Uint8 token);
+	/// Reads the rest of a node after its token.
+	YAML::Node readNode(Uint8 token);
+	/// Skips the rest of a node after its token.
+	void skipNode(Uint8 token);
+public:
+	/// Starts reading a save, checking its header.
+	BinarySaveReader(const Uint8 *data, size_t size);
+	/// Cleans up the reader.
+	~BinarySaveReader();
+	/// Enters a map.
+	void beginMap();
+	/// Enters a sequence.
+	void beginSeq();
+	/// Checks if the current map or sequence has another entry.
+	bool next();
+	/// Reads the key of the next map entry.
+	std::string key();
+	/// Reads a whole node.
+	YAML::Node node();
+	/// Skips a whole node.
+	void skip();
+	/// Checks if the next node is a block of raw data.
+	bool isBinary() const;
+	/// Reads a block of raw data, which stays in the save buffer.
+	const Uint8 *binary(size_t &size);
+	/// Gets the current read position.
+	size_t tell() const { return _pos; }
+	/// Goes back to a position returned by tell().
+	void seek(size_t pos) { _pos = pos; }
+};
+
+}
@@ -25,10 +25,12 @@
 #include "Tile.h"
 #include "HitLog.h"
 #include "Node.h"
+#include "BinarySave.h"
 #include "../Mod/MapDataSet.h"
 #include "../Mod/MCDPatch.h"
 #include "../Battlescape/Pathfinding.h"
 #include "../Battlescape/TileEngine.h"
+#include "../Battlescape/UnitGrid.h"
 #include "../Battlescape/BattlescapeState.h"
 #include "../Battlescape/BattlescapeGame.h"
 #include "../Battlescape/Position.h"
@@ -42,6 +44,7 @@
 #include "../Engine/RNG.h"
 #include "../Engine/Options.h"
 #include "../Engine/Logger.h"
+#include "../Engine/ObjectPool.h"
 #include "../Engine/ScriptBind.h"
 #include "SerializationHelper.h"
 #include "../Mod/RuleEnviroEffects.h"
@@ -59,7 +62,7 @@ namespace OpenXcom
  */
 SavedBattleGame::SavedBattleGame(Mod *rule, Language *lang) :
 	_battleState(0), _rule(rule), _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _selectedUnit(0),
-	_lastSelectedUnit(0), _pathfinding(0), _tileEngine(0),
+	_lastSelectedUnit(0), _pathfinding(0), _tileEngine(0), _unitGrid(0),
 	_reinforcementsItemLevel(0), _enviroEffects(nullptr), _ecEnabledFriendly(false), _ecEnabledHostile(false), _ecEnabledNeutral(false),
 	_globalShade(0), _side(FACTION_PLAYER), _turn(0), _bughuntMinTurn(20), _animFrame(0), _nameDisplay(false),
 	_debugMode(false), _bughuntMode(false), _aborted(false), _itemId(0),
@@ -117,9 +120,13 @@ SavedBattleGame::~SavedBattleGame()
 	{
 		delete *i;
 	}
+	// with the battle gone nothing should be left in the pools, drop their memory in one go
+	BattleItem::getPool().release();
+	BattleUnit::getPool().release();
 
 	delete _pathfinding;
 	delete _tileEngine;
+	delete _unitGrid;
 	delete _baseItems;
 	delete _hitLog;
 }
@@ -131,6 +138,162 @@ SavedBattleGame::~SavedBattleGame()
  * @param savedGame Pointer to saved game.
  */
 void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGame)
+{
+	loadSettings(node, mod);
+
+	if (const YAML::Node &tiles = node["binTiles"])
+	{
+		YAML::Binary binTiles = tiles.as<YAML::Binary>();
+		loadTiles(node, binTiles.data(), binTiles.size());
+	}
+	else
+	{
+		loadTiles(node, 0, 0);
+	}
+
+	for (YAML::const_iterator i = node["nodes"].begin(); i != node["nodes"].end(); ++i)
+	{
+		Node *n = new Node();
+		n->load(*i);
+		_nodes.push_back(n);
+	}
+
+	int selectedUnit = node["selectedUnit"].as<int>();
+	for (YAML::const_iterator i = node["units"].begin(); i != node["units"].end(); ++i)
+	{
+		loadUnit(*i, mod, savedGame, selectedUnit);
+	}
+
+	std::vector<LoadedItems> lists = getItemLists();
+	for (auto& list : lists)
+	{
+		list.start = list.items->size();
+		for (YAML::const_iterator i = node[list.name].begin(); i != node[list.name].end(); ++i)
+		{
+			loadItem(*i, mod, list);
+		}
+	}
+
+	finishLoading(node, lists);
+}
+
+/**
+ * Loads the saved battle game from a binary save. The settings are
+ * read first, then the tiles, units and items are loaded one by one
+ * straight from the save, without building YAML nodes for all of them.
+ * @param in Binary save, at the start of the battle.
+ * @param mod for the saved game.
+ * @param savedGame Pointer to saved game.
+ */
+void SavedBattleGame::load(BinarySaveReader &in, Mod *mod, SavedGame* savedGame)
+{
+	std::vector<LoadedItems> lists = getItemLists();
+	auto isList = [&](const std::string &key)
+	{
+		if (key == "binTiles" || key == "nodes" || key == "units")
+			return true;
+		for (auto& list : lists)
+		{
+			if (key == list.name)
+				return true;
+		}
+		return false;
+	};
+
+	// the lists are skipped at first, the settings could be after them
+	YAML::Node node;
+	std::map<std::string, size_t> positions;
+	in.beginMap();
+	while (in.next())
+	{
+		std::string key = in.key();
+		if (isList(key))
+		{
+			positions[key] = in.tell();
+			in.skip();
+		}
+		else
+		{
+			node.force_insert(key, in.node());
+		}
+	}
+	size_t end = in.tell();
+
+	auto seekList = [&](const std::string &key)
+	{
+		auto i = positions.find(key);
+		if (i == positions.end())
+			return false;
+		in.seek(i->second);
+		return true;
+	};
+
+	loadSettings(node, mod);
+
+	if (seekList("binTiles"))
+	{
+		if (in.isBinary())
+		{
+			size_t size;
+			const Uint8 *data = in.binary(size);
+			loadTiles(node, data, size);
+		}
+		else
+		{
+			YAML::Binary binTiles = in.node().as<YAML::Binary>();
+			loadTiles(node, binTiles.data(), binTiles.size());
+		}
+	}
+	else
+	{
+		loadTiles(node, 0, 0);
+	}
+
+	if (seekList("nodes"))
+	{
+		in.beginSeq();
+		while (in.next())
+		{
+			Node *n = new Node();
+			n->load(in.node());
+			_nodes.push_back(n);
+		}
+	}
+
+	int selectedUnit = node["selectedUnit"].as<int>();
+	if (seekList("units"))
+	{
+		in.beginSeq();
+		while (in.next())
+		{
+			loadUnit(in.node(), mod, savedGame, selectedUnit);
+		}
+	}
+
+	for (auto& list : lists)
+	{
+		list.start = list.items->size();
+		if (seekList(list.name))
+		{
+			in.beginSeq();
+			while (in.next())
+			{
+				loadItem(in.node(), mod, list);
+			}
+		}
+	}
+	in.seek(end);
+
+	finishLoading(node, lists);
+}
+
+/**
+ * Loads the settings of the battle, everything but the tiles,
+ * nodes, units and items. Also sets up the map.
+ * @param node YAML node.
+ * @param mod for the saved game.
+ */
+void SavedBattleGame::loadSettings(const YAML::Node &node, Mod *mod)
 {
 	int mapsize_x = node["width"].as<int>(_mapsize_x);
 	int mapsize_y = node["length"].as<int>(_mapsize_y);
@@ -164,7 +327,6 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 	_bughuntMode = node["bughuntMode"].as<bool>(_bughuntMode);
 	_depth = node["depth"].as<int>(_depth);
 	_animFrame = node["animFrame"].as<int>(_animFrame);
-	int selectedUnit = node["selectedUnit"].as<int>();
 
 	for (YAML::const_iterator i = node["mapdatasets"].begin(); i != node["mapdatasets"].end(); ++i)
 	{
@@ -173,6 +335,41 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 		_mapDataSets.push_back(mds);
 	}
 
+	_vipEscapeType = (EscapeType)(node["vipEscapeType"].as<int>(_vipEscapeType));
+	_vipSurvivalPercentage = node["vipSurvivalPercentage"].as<int>(_vipSurvivalPercentage);
+	_vipsSaved = node["vipsSaved"].as<int>(_vipsSaved);
+	_vipsLost = node["vipsLost"].as<int>(_vipsLost);
+	_vipsWaitingOutside = node["vipsWaitingOutside"].as<int>(_vipsWaitingOutside);
+	_vipsSavedScore = node["vipsSavedScore"].as<int>(_vipsSavedScore);
+	_vipsLostScore = node["vipsLostScore"].as<int>(_vipsLostScore);
+	_vipsWaitingOutsideScore = node["vipsWaitingOutsideScore"].as<int>(_vipsWaitingOutsideScore);
+	_objectiveType = node["objectiveType"].as<int>(_objectiveType);
+	_objectivesDestroyed = node["objectivesDestroyed"].as<int>(_objectivesDestroyed);
+	_objectivesNeeded = node["objectivesNeeded"].as<int>(_objectivesNeeded);
+	_tuReserved = (BattleActionType)node["tuReserved"].as<int>(_tuReserved);
+	_kneelReserved = node["kneelReserved"].as<bool>(_kneelReserved);
+	_ambience = node["ambience"].as<int>(_ambience);
+	_ambientVolume = node["ambientVolume"].as<double>(_ambientVolume);
+	_ambienceRandom = node["ambienceRandom"].as<std::vector<int> >(_ambienceRandom);
+	_minAmbienceRandomDelay = node["minAmbienceRandomDelay"].as<int>(_minAmbienceRandomDelay);
+	_maxAmbienceRandomDelay = node["maxAmbienceRandomDelay"].as<int>(_maxAmbienceRandomDelay);
+	_currentAmbienceDelay = node["currentAmbienceDelay"].as<int>(_currentAmbienceDelay);
+	_music = node["music"].as<std::string>(_music);
+	_baseItems->load(node["baseItems"]);
+	_turnLimit = node["turnLimit"].as<int>(_turnLimit);
+	_chronoTrigger = ChronoTrigger(node["chronoTrigger"].as<int>(_chronoTrigger));
+	_cheatTurn = node["cheatTurn"].as<int>(_cheatTurn);
+	_scriptValues.load(node, _rule->getScriptGlobal());
+}
+
+/**
+ * Loads the tiles, from the binary tile data or from old-style text tiles.
+ * @param node YAML node with the tile settings.
+ * @param data Binary tile data, null for text tiles.
+ * @param size Size of the binary tile data.
+ */
+void SavedBattleGame::loadTiles(const YAML::Node &node, const Uint8 *data, size_t size)
+{
 	if (!node["tileTotalBytesPer"])
 	{
 		// binary tile data not found, load old-style text tiles :(
@@ -197,10 +394,13 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 		serKey._mapDataSetID = node["tileSetIDSize"].as<Uint8>(serKey._mapDataSetID);
 		serKey.boolFields = node["tileBoolFieldsSize"].as<Uint8>(1); // boolean flags used to be stored in an unmentioned byte (Uint8) :|
 
-		// load binary tile data!
-		YAML::Binary binTiles = node["binTiles"].as<YAML::Binary>();
+		if (size < totalTiles * serKey.totalBytes)
+		{
+			throw Exception("Binary tile data is too short");
+		}
 
-		Uint8 *r = (Uint8*)binTiles.data();
+		// load binary tile data!
+		Uint8 *r = (Uint8*)data;
 		Uint8 *dataEnd = r + totalTiles * serKey.totalBytes;
 
 		while (r < dataEnd)
@@ -211,151 +411,182 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 			r += serKey.totalBytes-serKey.index; // r is now incremented strictly by totalBytes in case there are obsolete fields present in the data
 		}
 	}
-	if (_missionType == "STR_BASE_DEFENSE")
+}
+
+/**
+ * Loads a unit and its AI.
+ * @param node YAML node of the unit.
+ * @param mod for the saved game.
+ * @param savedGame Pointer to saved game.
+ * @param selectedUnit ID of the unit that was selected.
+ */
+void SavedBattleGame::loadUnit(const YAML::Node &node, Mod *mod, SavedGame* savedGame, int selectedUnit)
+{
+	UnitFaction faction = (UnitFaction)node["faction"].as<int>();
+	UnitFaction originalFaction = (UnitFaction)node["originalFaction"].as<int>(faction);
+	int id = node["id"].as<int>();
+	BattleUnit *unit;
+	if (id < BattleUnit::MAX_SOLDIER_ID) // Unit is linked to a geoscape soldier
 	{
-		if (node["moduleMap"])
-		{
-			_baseModules = node["moduleMap"].as<std::vector< std::vector<std::pair<int, int> > > >();
-		}
-		else
-		{
-			// backwards compatibility: imperfect solution, modules that were completely destroyed
-			// prior to saving and updating builds will be counted as indestructible.
-			calculateModuleMap();
-		}
+		// look up the matching soldier
+		unit = new BattleUnit(mod, savedGame->getSoldier(id), _depth);
 	}
-	for (YAML::const_iterator i = node["nodes"].begin(); i != node["nodes"].end(); ++i)
+	else
 	{
-		Node *n = new Node();
-		n->load(*i);
-		_nodes.push_back(n);
+		std::string type = node["genUnitType"].as<std::string>();
+		std::string armor = node["genUnitArmor"].as<std::string>();
+		// create a new Unit.
+		if(!mod->getUnit(type) || !mod->getArmor(armor)) return;
+		unit = new BattleUnit(mod, mod->getUnit(type), originalFaction, id, nullptr, mod->getArmor(armor), mod->getStatAdjustment(savedGame->getDifficulty()), _depth);
+	}
+	unit->load(node, this->getMod(), this->getMod()->getScriptGlobal());
+	// Handling of special built-in weapons will be done during and after the load of items
+	// unit->setSpecialWeapon(this, true);
+	_units.push_back(unit);
+	invalidateUnitGrid();
+	if (faction == FACTION_PLAYER)
+	{
+		if ((unit->getId() == selectedUnit) || (_selectedUnit == 0 && !unit->isOut()))
+			_selectedUnit = unit;
 	}
-
-	for (YAML::const_iterator i = node["units"].begin(); i != node["units"].end(); ++i)
+	if (unit->getStatus() != STATUS_DEAD && !unit->isIgnored())
 	{
-		UnitFaction faction = (UnitFaction)(*i)["faction"].as<int>();
-		UnitFaction originalFaction = (UnitFaction)(*i)["originalFaction"].as<int>(faction);
-		int id = (*i)["id"].as<int>();
-		BattleUnit *unit;
-		if (id < BattleUnit::MAX_SOLDIER_ID) // Unit is linked to a geoscape soldier
-		{
-			// look up the matching soldier
-			unit = new BattleUnit(mod, savedGame->getSoldier(id), _depth);
-		}
-		else
+		if (const YAML::Node &ai = node["AI"])
 		{
-			std::string type = (*i)["genUnitType"].as<std::string>();
-			std::string armor = (*i)["genUnitArmor"].as<std::string>();
-			// create a new Unit.
-			if(!mod->getUnit(type) || !mod->getArmor(armor)) continue;
-			unit = new BattleUnit(mod, mod->getUnit(type), originalFaction, id, nullptr, mod->getArmor(armor), mod->getStatAdjustment(savedGame->getDifficulty()), _depth);
-		}
-		unit->load(*i, this->getMod(), this->getMod()->getScriptGlobal());
-		// Handling of special built-in weapons will be done during and after the load of items
-		// unit->setSpecialWeapon(this, true);
-		_units.push_back(unit);
-		if (faction == FACTION_PLAYER)
-		{
-			if ((unit->getId() == selectedUnit) || (_selectedUnit == 0 && !unit->isOut()))
-				_selectedUnit = unit;
-		}
-		if (unit->getStatus() != STATUS_DEAD && !unit->isIgnored())
-		{
-			if (const YAML::Node &ai = (*i)["AI"])
+			if (faction == FACTION_PLAYER)
 			{
-				AIModule *aiModule;
-				if (faction != FACTION_PLAYER)
-				{
-					aiModule = new AIModule(this, unit, 0);
-				}
-				else
-				{
-					continue;
-				}
-				aiModule->load(ai);
-				unit->setAIModule(aiModule);
+				return;
 			}
+			AIModule *aiModule = new AIModule(this, unit, 0);
+			aiModule->load(ai);
+			unit->setAIModule(aiModule);
 		}
 	}
+}
 
-	using ItemVec = std::vector<BattleItem*>&;
+/**
+ * Gets the item lists in the order they are loaded,
+ * the ammo of an item is searched in the same list.
+ * @return Empty item lists.
+ */
+std::vector<SavedBattleGame::LoadedItems> SavedBattleGame::getItemLists()
+{
+	std::vector<LoadedItems> lists(4);
+	lists[0].name = "items";
+	lists[0].items = &_items;
+	lists[1].name = "recoverConditional";
+	lists[1].items = &_recoverConditional;
+	lists[2].name = "recoverGuaranteed";
+	lists[2].items = &_recoverGuaranteed;
+	lists[3].name = "itemsSpecial";
+	lists[3].items = &_items;
+	return lists;
+}
 
-	// node to load from, vector to load into, offset for maching ammo
-	std::tuple<YAML::Node, ItemVec, size_t> toContainer[] =
+/**
+ * Loads an item into a list and matches it with its units and tile.
+ * The ammo is matched later, once all the items are loaded.
+ * @param node YAML node of the item.
+ * @param mod for the saved game.
+ * @param list List to add the item to.
+ */
+void SavedBattleGame::loadItem(const YAML::Node &node, Mod *mod, LoadedItems &list)
+{
+	std::string type = node["type"].as<std::string>();
+	if (!mod->getItem(type))
 	{
-		std::make_tuple(node["items"], std::ref(_items), 0u),
-		std::make_tuple(node["recoverConditional"], std::ref(_recoverConditional), 0u),
-		std::make_tuple(node["recoverGuaranteed"], std::ref(_recoverGuaranteed), 0u),
-		std::make_tuple(node["itemsSpecial"], std::ref(_items), 0u),
-	};
+		Log(LOG_ERROR) << "Failed to load item " << type;
+		return;
+	}
+	int id = node["id"].as<int>();
+	_itemId = std::max(_itemId, id);
+	BattleItem *item = new BattleItem(mod->getItem(type), &id);
+	item->load(node, mod, this->getMod()->getScriptGlobal());
+	int owner = node["owner"].as<int>(-1);
+	int prevOwner = node["previousOwner"].as<int>(-1);
+	int unit = node["unit"].as<int>(-1);
 
-	for (auto& pass : toContainer)
+	// match up items and units
+	for (std::vector<BattleUnit*>::iterator bu = _units.begin(); bu != _units.end() && owner != -1; ++bu)
 	{
-		// update start point for maching ammo
-		std::get<size_t>(pass) = std::get<ItemVec>(pass).size();
-
-		for (YAML::const_iterator i = std::get<YAML::Node>(pass).begin(); i != std::get<YAML::Node>(pass).end(); ++i)
+		if ((*bu)->getId() == owner)
 		{
-			std::string type = (*i)["type"].as<std::string>();
-			if (mod->getItem(type))
+			item->setOwner(*bu);
+			if (item->isSpecialWeapon())
 			{
-				int id = (*i)["id"].as<int>();
-				_itemId = std::max(_itemId, id);
-				BattleItem *item = new BattleItem(mod->getItem(type), &id);
-				item->load(*i, mod, this->getMod()->getScriptGlobal());
-				int owner = (*i)["owner"].as<int>(-1);
-				int prevOwner = (*i)["previousOwner"].as<int>(-1);
-				int unit = (*i)["unit"].as<int>(-1);
-
-				// match up items and units
-				for (std::vector<BattleUnit*>::iterator bu = _units.begin(); bu != _units.end() && owner != -1; ++bu)
-				{
-					if ((*bu)->getId() == owner)
-					{
-						item->setOwner(*bu);
-						if (item->isSpecialWeapon())
-						{
-							(*bu)->addLoadedSpecialWeapon(item);
-						}
-						else
-						{
-							(*bu)->getInventory()->push_back(item);
-						}
-						break;
-					}
-				}
-				for (std::vector<BattleUnit*>::iterator bu = _units.begin(); bu != _units.end() && prevOwner != -1; ++bu)
-				{
-					if ((*bu)->getId() == prevOwner)
-					{
-						item->setPreviousOwner(*bu);
-						break;
-					}
-				}
-				for (std::vector<BattleUnit*>::iterator bu = _units.begin(); bu != _units.end() && unit != -1; ++bu)
-				{
-					if ((*bu)->getId() == unit)
-					{
-						item->setUnit(*bu);
-						break;
-					}
-				}
-
-				// match up items and tiles
-				if (item->getSlot() && item->getSlot()->getType() == INV_GROUND)
-				{
-					Position pos = (*i)["position"].as<Position>(Position(-1, -1, -1));
-					if (pos.x != -1)
-						getTile(pos)->addItem(item, item->getSlot());
-				}
-				std::get<ItemVec>(pass).push_back(item);
+				(*bu)->addLoadedSpecialWeapon(item);
 			}
 			else
 			{
-				Log(LOG_ERROR) << "Failed to load item " << type;
+				(*bu)->getInventory()->push_back(item);
 			}
+			break;
 		}
 	}
+	for (std::vector<BattleUnit*>::iterator bu = _units.begin(); bu != _units.end() && prevOwner != -1; ++bu)
+	{
+		if ((*bu)->getId() == prevOwner)
+		{
+			item->setPreviousOwner(*bu);
+			break;
+		}
+	}
+	for (std::vector<BattleUnit*>::iterator bu = _units.begin(); bu != _units.end() && unit != -1; ++bu)
+	{
+		if ((*bu)->getId() == unit)
+		{
+			item->setUnit(*bu);
+			break;
+		}
+	}
+
+	// match up items and tiles
+	if (item->getSlot() && item->getSlot()->getType() == INV_GROUND)
+	{
+		Position pos = node["position"].as<Position>(Position(-1, -1, -1));
+		if (pos.x != -1)
+			getTile(pos)->addItem(item, item->getSlot());
+	}
+	list.items->push_back(item);
+
+	// remember the ammo to tie it to the weapon later
+	std::vector<int> ammo(RuleItem::AmmoSlotMax, -1);
+	if (const YAML::Node& ammoSlots = node["ammoItemSlots"])
+	{
+		for (int slot = 0; slot < RuleItem::AmmoSlotMax; ++slot)
+		{
+			ammo[slot] = ammoSlots[slot].as<int>(-1);
+		}
+	}
+	else
+	{
+		ammo[0] = node["ammoItem"].as<int>(-1);
+	}
+	list.ammo.push_back(ammo);
+}
+
+/**
+ * Finishes loading the battle once all the objects are loaded,
+ * setting up special weapons and tying ammo to its weapons.
+ * @param node YAML node with the settings.
+ * @param lists Loaded item lists.
+ */
+void SavedBattleGame::finishLoading(const YAML::Node &node, std::vector<LoadedItems> &lists)
+{
+	if (_missionType == "STR_BASE_DEFENSE")
+	{
+		if (node["moduleMap"])
+		{
+			_baseModules = node["moduleMap"].as<std::vector< std::vector<std::pair<int, int> > > >();
+		}
+		else
+		{
+			// backwards compatibility: imperfect solution, modules that were completely destroyed
+			// prior to saving and updating builds will be counted as indestructible.
+			calculateModuleMap();
+		}
+	}
+
 	_itemId++;
 
 	// Note: this is for backwards-compatibility with older saves
@@ -370,94 +601,49 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 		unit->setSpecialWeapon(this, true);
 	}
 
-	// tie ammo items to their weapons, running through the items again
-	for (auto& pass : toContainer)
+	// tie ammo items to their weapons
+	for (auto& list : lists)
 	{
-		for (YAML::const_iterator i = std::get<YAML::Node>(pass).begin(); i != std::get<YAML::Node>(pass).end(); ++i)
+		for (size_t i = 0; i < list.ammo.size(); ++i)
 		{
-			if (mod->getItem((*i)["type"].as<std::string>()))
+			auto* weapon = (*list.items)[list.start + i];
+			for (int slot = 0; slot < RuleItem::AmmoSlotMax; ++slot)
 			{
-				// get next weapon to match ammo
-				auto* weapon = std::get<ItemVec>(pass)[std::get<size_t>(pass)++];
-
-				auto setItem = [&](int slot, const YAML::Node& n)
+				int ammoId = list.ammo[i][slot];
+				if (ammoId == -1)
 				{
-					if (n)
-					{
-						int ammoId = n.as<int>(-1);
-						if (ammoId != -1)
-						{
-							if (ammoId == weapon->getId())
-							{
-								weapon->setAmmoForSlot(slot, weapon);
-							}
-							else
-							{
-								for (auto* item : std::get<ItemVec>(pass))
-								{
-									if (item->getId() == ammoId)
-									{
-										weapon->setAmmoForSlot(slot, item);
-										break;
-									}
-								}
-							}
-						}
-					}
-				};
-
-				if (const YAML::Node& ammoSlots = (*i)["ammoItemSlots"])
+					continue;
+				}
+				if (ammoId == weapon->getId())
 				{
-					for (int slot = 0; slot < RuleItem::AmmoSlotMax; ++slot)
-					{
-						setItem(slot, ammoSlots[slot]);
-					}
+					weapon->setAmmoForSlot(slot, weapon);
 				}
 				else
 				{
-					setItem(0, (*i)["ammoItem"]);
+					for (auto* item : *list.items)
+					{
+						if (item->getId() == ammoId)
+						{
+							weapon->setAmmoForSlot(slot, item);
+							break;
+						}
+					}
 				}
 			}
 		}
 	}
 
 	// restore order like before save
-	for (auto& pass : toContainer)
+	for (auto& list : lists)
 	{
 		std::sort(
-			std::get<ItemVec>(pass).begin(), std::get<ItemVec>(pass).end(),
+			list.items->begin(), list.items->end(),
 			[](const BattleItem* itemA, const BattleItem* itemB)
 			{
 				return itemA->getId() < itemB->getId();
 			}
 		);
 	}
-
-	_vipEscapeType = (EscapeType)(node["vipEscapeType"].as<int>(_vipEscapeType));
-	_vipSurvivalPercentage = node["vipSurvivalPercentage"].as<int>(_vipSurvivalPercentage);
-	_vipsSaved = node["vipsSaved"].as<int>(_vipsSaved);
-	_vipsLost = node["vipsLost"].as<int>(_vipsLost);
-	_vipsWaitingOutside = node["vipsWaitingOutside"].as<int>(_vipsWaitingOutside);
-	_vipsSavedScore = node["vipsSavedScore"].as<int>(_vipsSavedScore);
-	_vipsLostScore = node["vipsLostScore"].as<int>(_vipsLostScore);
-	_vipsWaitingOutsideScore = node["vipsWaitingOutsideScore"].as<int>(_vipsWaitingOutsideScore);
-	_objectiveType = node["objectiveType"].as<int>(_objectiveType);
-	_objectivesDestroyed = node["objectivesDestroyed"].as<int>(_objectivesDestroyed);
-	_objectivesNeeded = node["objectivesNeeded"].as<int>(_objectivesNeeded);
-	_tuReserved = (BattleActionType)node["tuReserved"].as<int>(_tuReserved);
-	_kneelReserved = node["kneelReserved"].as<bool>(_kneelReserved);
-	_ambience = node["ambience"].as<int>(_ambience);
-	_ambientVolume = node["ambientVolume"].as<double>(_ambientVolume);
-	_ambienceRandom = node["ambienceRandom"].as<std::vector<int> >(_ambienceRandom);
-	_minAmbienceRandomDelay = node["minAmbienceRandomDelay"].as<int>(_minAmbienceRandomDelay);
-	_maxAmbienceRandomDelay = node["maxAmbienceRandomDelay"].as<int>(_maxAmbienceRandomDelay);
-	_currentAmbienceDelay = node["currentAmbienceDelay"].as<int>(_currentAmbienceDelay);
-	_music = node["music"].as<std::string>(_music);
-	_baseItems->load(node["baseItems"]);
-	_turnLimit = node["turnLimit"].as<int>(_turnLimit);
-	_chronoTrigger = ChronoTrigger(node["chronoTrigger"].as<int>(_chronoTrigger));
-	_cheatTurn = node["cheatTurn"].as<int>(_cheatTurn);
-	_scriptValues.load(node, _rule->getScriptGlobal());
 }
 
 /**
@@ -502,6 +688,100 @@ void SavedBattleGame::loadMapResources(Mod *mod)
  * @return YAML node.
  */
 YAML::Node SavedBattleGame::save() const
+{
+	YAML::Node node = saveSettings();
+	std::vector<Uint8> tileData = saveTiles();
+	node["totalTiles"] = tileData.size() / Tile::serializationKey.totalBytes; // not strictly necessary, just convenient
+	node["binTiles"] = YAML::Binary(tileData.data(), tileData.size());
+	for (std::vector<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+	{
+		node["nodes"].push_back((*i)->save());
+	}
+	for (std::vector<BattleUnit*>::const_iterator i = _units.begin(); i != _units.end(); ++i)
+	{
+		node["units"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
+	}
+	for (std::vector<BattleItem*>::const_iterator i = _items.begin(); i != _items.end(); ++i)
+	{
+		if ((*i)->isSpecialWeapon())
+		{
+			node["itemsSpecial"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
+		}
+		else
+		{
+			node["items"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
+		}
+	}
+	for (std::vector<BattleItem*>::const_iterator i = _recoverGuaranteed.begin(); i != _recoverGuaranteed.end(); ++i)
+	{
+		node["recoverGuaranteed"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
+	}
+	for (std::vector<BattleItem*>::const_iterator i = _recoverConditional.begin(); i != _recoverConditional.end(); ++i)
+	{
+		node["recoverConditional"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
+	}
+	return node;
+}
+
+/**
+ * Saves the saved battle game to a binary save. The settings go first,
+ * then every node, unit and item is written as soon as it's saved,
+ * so there's never more than one of them in memory as YAML.
+ * @param out Binary save.
+ */
+void SavedBattleGame::save(BinarySaveWriter &out) const
+{
+	YAML::Node node = saveSettings();
+	std::vector<Uint8> tileData = saveTiles();
+	node["totalTiles"] = tileData.size() / Tile::serializationKey.totalBytes;
+
+	out.beginMap();
+	out.entries(node);
+	out.key("binTiles");
+	out.binary(tileData.data(), tileData.size());
+
+	out.key("nodes");
+	out.beginSeq();
+	for (std::vector<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+	{
+		out.node((*i)->save());
+	}
+	out.end();
+
+	out.key("units");
+	out.beginSeq();
+	for (std::vector<BattleUnit*>::const_iterator i = _units.begin(); i != _units.end(); ++i)
+	{
+		out.node((*i)->save(this->getMod()->getScriptGlobal()));
+	}
+	out.end();
+
+	auto saveItems = [&](const std::string &key, const std::vector<BattleItem*> &items, int special)
+	{
+		out.key(key);
+		out.beginSeq();
+		for (std::vector<BattleItem*>::const_iterator i = items.begin(); i != items.end(); ++i)
+		{
+			if (special == -1 || (*i)->isSpecialWeapon() == (special == 1))
+			{
+				out.node((*i)->save(this->getMod()->getScriptGlobal()));
+			}
+		}
+		out.end();
+	};
+	saveItems("items", _items, 0);
+	saveItems("itemsSpecial", _items, 1);
+	saveItems("recoverGuaranteed", _recoverGuaranteed, -1);
+	saveItems("recoverConditional", _recoverConditional, -1);
+	out.end();
+}
+
+/**
+ * Saves the settings of the battle, everything but the tiles,
+ * nodes, units and items.
+ * @return YAML node.
+ */
+YAML::Node SavedBattleGame::saveSettings() const
 {
 	YAML::Node node;
 	if (_vipSurvivalPercentage > 0)
@@ -554,16 +834,7 @@ YAML::Node SavedBattleGame::save() const
 	{
 		node["mapdatasets"].push_back((*i)->getName());
 	}
-#if 0
-	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
-	{
-		if (!_tiles[i].isVoid())
-		{
-			node["tiles"].push_back(_tiles[i].save());
-		}
-	}
-#else
-	// first, write out the field sizes we're going to use to write the tile data
+	// write out the field sizes we're going to use to write the tile data
 	node["tileIndexSize"] = Tile::serializationKey.index;
 	node["tileTotalBytesPer"] = Tile::serializationKey.totalBytes;
 	node["tileFireSize"] = Tile::serializationKey._fire;
@@ -571,50 +842,10 @@ YAML::Node SavedBattleGame::save() const
 	node["tileIDSize"] = Tile::serializationKey._mapDataID;
 	node["tileSetIDSize"] = Tile::serializationKey._mapDataSetID;
 	node["tileBoolFieldsSize"] = Tile::serializationKey.boolFields;
-
-	size_t tileDataSize = Tile::serializationKey.totalBytes * _mapsize_z * _mapsize_y * _mapsize_x;
-	Uint8* tileData = (Uint8*) calloc(tileDataSize, 1);
-	Uint8* w = tileData;
-
-	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
-	{
-		if (!_tiles[i].isVoid())
-		{
-			serializeInt(&w, Tile::serializationKey.index, i);
-			_tiles[i].saveBinary(&w);
-		}
-		else
-		{
-			tileDataSize -= Tile::serializationKey.totalBytes;
-		}
-	}
-	node["totalTiles"] = tileDataSize / Tile::serializationKey.totalBytes; // not strictly necessary, just convenient
-	node["binTiles"] = YAML::Binary(tileData, tileDataSize);
-	free(tileData);
-#endif
-	for (std::vector<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
-	{
-		node["nodes"].push_back((*i)->save());
-	}
 	if (_missionType == "STR_BASE_DEFENSE")
 	{
 		node["moduleMap"] = _baseModules;
 	}
-	for (std::vector<BattleUnit*>::const_iterator i = _units.begin(); i != _units.end(); ++i)
-	{
-		node["units"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
-	}
-	for (std::vector<BattleItem*>::const_iterator i = _items.begin(); i != _items.end(); ++i)
-	{
-		if ((*i)->isSpecialWeapon())
-		{
-			node["itemsSpecial"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
-		}
-		else
-		{
-			node["items"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
-		}
-	}
 	node["tuReserved"] = (int)_tuReserved;
 	node["kneelReserved"] = _kneelReserved;
 	node["depth"] = _depth;
@@ -624,24 +855,36 @@ YAML::Node SavedBattleGame::save() const
 	node["minAmbienceRandomDelay"] = _minAmbienceRandomDelay;
 	node["maxAmbienceRandomDelay"] = _maxAmbienceRandomDelay;
 	node["currentAmbienceDelay"] = _currentAmbienceDelay;
-	for (std::vector<BattleItem*>::const_iterator i = _recoverGuaranteed.begin(); i != _recoverGuaranteed.end(); ++i)
-	{
-		node["recoverGuaranteed"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
-	}
-	for (std::vector<BattleItem*>::const_iterator i = _recoverConditional.begin(); i != _recoverConditional.end(); ++i)
-	{
-		node["recoverConditional"].push_back((*i)->save(this->getMod()->getScriptGlobal()));
-	}
 	node["music"] = _music;
 	node["baseItems"] = _baseItems->save();
 	node["turnLimit"] = _turnLimit;
 	node["chronoTrigger"] = int(_chronoTrigger);
 	node["cheatTurn"] = _cheatTurn;
 	_scriptValues.save(node, _rule->getScriptGlobal());
-
 	return node;
 }
 
+/**
+ * Saves the tiles that aren't void into binary tile data.
+ * @return Binary tile data.
+ */
+std::vector<Uint8> SavedBattleGame::saveTiles() const
+{
+	std::vector<Uint8> tileData(Tile::serializationKey.totalBytes * _mapsize_z * _mapsize_y * _mapsize_x);
+	Uint8* w = tileData.data();
+
+	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
+	{
+		if (!_tiles[i].isVoid())
+		{
+			serializeInt(&w, Tile::serializationKey.index, i);
+			_tiles[i].saveBinary(&w);
+		}
+	}
+	tileData.resize(w - tileData.data());
+	return tileData;
+}
+
 /**
  * Initializes the array of tiles and creates a pathfinding object.
  * @param mapsize_x
@@ -670,9 +913,10 @@ void SavedBattleGame::initMap(int mapsize_x, int mapsize_y, int mapsize_z, bool
 
 	_tiles.clear();
 	_tiles.reserve(_mapsize_z * _mapsize_y * _mapsize_x);
+	_tileStore.resize(_mapsize_z * _mapsize_y * _mapsize_x);
 	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
 	{
-		_tiles.push_back(Tile(getTileCoords(i)));
+		_tiles.push_back(Tile(getTileCoords(i), &_tileStore, i));
 	}
 
 }
@@ -685,9 +929,11 @@ void SavedBattleGame::initUtilities(Mod *mod, bool craftInventory)
 {
 	delete _pathfinding;
 	delete _tileEngine;
+	delete _unitGrid;
 	_baseCraftInventory = craftInventory;
 	_pathfinding = craftInventory ? nullptr : new Pathfinding(this);
 	_tileEngine = new TileEngine(this, mod);
+	_unitGrid = new UnitGrid(this);
 }
 
 /**
@@ -1013,7 +1259,8 @@ std::vector<Node*> *SavedBattleGame::getNodes()
 }
 
 /**
- * Gets the list of units.
+ * Gets the list of units. Adding or removing units
+ * needs a call to invalidateUnitGrid() afterwards.
  * @return Pointer to the list of units.
  */
 std::vector<BattleUnit*> *SavedBattleGame::getUnits()
@@ -1021,6 +1268,19 @@ std::vector<BattleUnit*> *SavedBattleGame::getUnits()
 	return &_units;
 }
 
+/**
+ * Marks the unit grid to be rebuilt on the next query. Has to be called
+ * after every change to the unit list, a new unit can even reuse the
+ * memory of a deleted one.
+ */
+void SavedBattleGame::invalidateUnitGrid()
+{
+	if (_unitGrid)
+	{
+		_unitGrid->invalidate();
+	}
+}
+
 /**
  * Gets the list of items.
  * @return Pointer to the list of items.
@@ -1953,9 +2213,10 @@ void SavedBattleGame::prepareNewTurn()
 	std::vector<Tile*> tilesOnSmoke;
 
 	// prepare a list of tiles on fire
+	const Uint8 *fire = _tileStore.getFire();
 	for (int i = 0; i < _mapsize_x * _mapsize_y * _mapsize_z; ++i)
 	{
-		if (getTile(i)->getFire() > 0)
+		if (fire[i] > 0)
 		{
 			tilesOnFire.push_back(getTile(i));
 		}
@@ -2016,20 +2277,22 @@ void SavedBattleGame::prepareNewTurn()
 						}
 					}
 				}
+				getTileEngine()->updateTerrainVoxels(*i);
 				getTileEngine()->applyGravity(*i);
 			}
 		}
 	}
 
 	// prepare a list of tiles on fire/with smoke in them (smoke acts as fire intensity)
+	const Uint8 *smoke = _tileStore.getSmoke();
 	for (int i = 0; i < _mapsize_x * _mapsize_y * _mapsize_z; ++i)
 	{
-		if (getTile(i)->getSmoke() > 0)
+		if (smoke[i] > 0)
 		{
 			tilesOnSmoke.push_back(getTile(i));
 		}
-		getTile(i)->setDangerous(false);
 	}
+	_tileStore.resetDanger();
 
 	// now make the smoke spread.
 	for (std::vector<Tile*>::iterator i = tilesOnSmoke.begin(); i != tilesOnSmoke.end(); ++i)
@@ -2088,7 +2351,7 @@ void SavedBattleGame::prepareNewTurn()
 		// do damage to units, average out the smoke, etc.
 		for (int i = 0; i < _mapsize_x * _mapsize_y * _mapsize_z; ++i)
 		{
-			if (getTile(i)->getSmoke() != 0)
+			if (smoke[i] != 0)
 				getTile(i)->prepareNewTurn(getDepth() == 0);
 		}
 	}
@@ -35,6 +35,7 @@ class BattlescapeGame;
 class Position;
 class Pathfinding;
 class TileEngine;
+class UnitGrid;
 class RuleEnviroEffects;
 class BattleItem;
 class BattleUnit;
@@ -43,6 +44,8 @@ class State;
 class ItemContainer;
 class RuleItem;
 class HitLog;
+class BinarySaveReader;
+class BinarySaveWriter;
 enum HitLogEntryType : int;
 
 /**
@@ -64,12 +67,14 @@ private:
 	int _mapsize_x, _mapsize_y, _mapsize_z;
 	std::vector<MapDataSet*> _mapDataSets;
 	std::vector<Tile> _tiles;
+	TileStore _tileStore;
 	BattleUnit *_selectedUnit, *_lastSelectedUnit;
 	std::vector<Node*> _nodes;
 	std::vector<BattleUnit*> _units;
 	std::vector<BattleItem*> _items, _deleted;
 	Pathfinding *_pathfinding;
 	TileEngine *_tileEngine;
+	UnitGrid *_unitGrid;
 	std::string _missionType, _strTarget, _strCraftOrBase, _alienCustomDeploy, _alienCustomMission;
 	std::string _reinforcementsDeployment, _reinforcementsRace;
 	int _reinforcementsItemLevel;
@@ -115,6 +120,30 @@ private:
 	BattleUnit *selectPlayerUnit(int dir, bool checkReselect = false, bool setReselect = false, bool checkInventory = false);
 	/// Run newTurnUnit and newTurnItem scripts
 	void newTurnUpdateScripts();
+	/// Items of one list being loaded, with the IDs of their ammo.
+	struct LoadedItems
+	{
+		std::string name;
+		std::vector<BattleItem*> *items = nullptr;
+		size_t start = 0;
+		std::vector<std::vector<int> > ammo;
+	};
+	/// Loads the settings of the battle.
+	void loadSettings(const YAML::Node &node, Mod *mod);
+	/// Loads the tiles.
+	void loadTiles(const YAML::Node &node, const Uint8 *data, size_t size);
+	/// Loads a unit.
+	void loadUnit(const YAML::Node &node, Mod *mod, SavedGame* savedGame, int selectedUnit);
+	/// Gets the item lists to load.
+	std::vector<LoadedItems> getItemLists();
+	/// Loads an item into a list.
+	void loadItem(const YAML::Node &node, Mod *mod, LoadedItems &list);
+	/// Finishes loading once all the objects are loaded.
+	void finishLoading(const YAML::Node &node, std::vector<LoadedItems> &lists);
+	/// Saves the settings of the battle.
+	YAML::Node saveSettings() const;
+	/// Saves the tiles into binary data.
+	std::vector<Uint8> saveTiles() const;
 public:
 	/// Creates a new battle save, based on the current generic save.
 	SavedBattleGame(Mod *rule, Language *lang);
@@ -122,8 +151,12 @@ public:
 	~SavedBattleGame();
 	/// Loads a saved battle game from YAML.
 	void load(const YAML::Node& node, Mod *mod, SavedGame* savedGame);
+	/// Loads a saved battle game from a binary save.
+	void load(BinarySaveReader &in, Mod *mod, SavedGame* savedGame);
 	/// Saves a saved battle game to YAML.
 	YAML::Node save() const;
+	/// Saves a saved battle game to a binary save.
+	void save(BinarySaveWriter &out) const;
 	/// Sets the dimensions of the map and initializes it.
 	void initMap(int mapsize_x, int mapsize_y, int mapsize_z, bool resetTerrain = true);
 	/// Initialises the pathfinding and tile engine.
@@ -256,6 +289,11 @@ public:
 		return &_tiles[i];
 	}
 
+	/// Gets the dense arrays of the tile values, indexed like the tiles.
+	TileStore *getTileStore() { return &_tileStore; }
+	/// Gets the dense arrays of the tile values, indexed like the tiles.
+	const TileStore *getTileStore() const { return &_tileStore; }
+
 	/**
 	 * Get tile that is below current one (const version).
 	 * @param tile
@@ -334,6 +372,10 @@ public:
 	Pathfinding *getPathfinding() const;
 	/// Gets a pointer to the tile engine.
 	TileEngine *getTileEngine() const;
+	/// Gets the grid of units by map area.
+	UnitGrid *getUnitGrid() const { return _unitGrid; }
+	/// Makes the unit grid pick up units added to or removed from the list.
+	void invalidateUnitGrid();
 	/// Gets the playing side.
 	UnitFaction getSide() const;
 	/// Can unit use that weapon?
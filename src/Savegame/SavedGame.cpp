@@ -33,6 +33,8 @@
 #include "../Engine/CrossPlatform.h"
 #include "../Engine/ScriptBind.h"
 #include "SavedBattleGame.h"
+#include "BackgroundSave.h"
+#include "BinarySave.h"
 #include "SerializationHelper.h"
 #include "GameTime.h"
 #include "Country.h"
@@ -328,7 +330,11 @@ std::vector<SaveInfo> SavedGame::getList(Language *lang, bool autoquick)
 SaveInfo SavedGame::getSaveInfo(const std::string &file, Language *lang)
 {
 	std::string fullname = Options::getMasterUserFolder() + file;
-	YAML::Node doc = YAML::Load(*CrossPlatform::getYamlSaveHeader(fullname));
+	YAML::Node doc;
+	if (!BinarySave::loadBrief(fullname, doc))
+	{
+		doc = YAML::Load(*CrossPlatform::getYamlSaveHeader(fullname));
+	}
 	SaveInfo save;
 
 	save.fileName = file;
@@ -401,18 +407,62 @@ SaveInfo SavedGame::getSaveInfo(const std::string &file, Language *lang)
 }
 
 /**
- * Loads a saved game's contents from a YAML file.
+ * Loads a saved game's contents from a YAML file or a binary save.
  * @note Assumes the saved game is blank.
- * @param filename YAML filename.
+ * @param filename Save filename.
  * @param mod Mod for the saved game.
  * @param lang Loaded language.
  */
 void SavedGame::load(const std::string &filename, Mod *mod, Language *lang)
 {
+	BackgroundSave::wait();
 	std::string filepath = Options::getMasterUserFolder() + filename;
-	std::vector<YAML::Node> file = YAML::LoadAll(*CrossPlatform::readFile(filepath));
-	// Get brief save info
-	YAML::Node brief = file[0];
+	std::vector<unsigned char> data = CrossPlatform::readFileRaw(filepath);
+	if (BinarySave::isBinary(data.data(), data.size()))
+	{
+		BinarySaveReader in(data.data(), data.size());
+		loadBrief(in.node(), filename);
+
+		// the battle needs the soldiers, so it's loaded after everything else
+		YAML::Node doc;
+		size_t battle = 0;
+		in.beginMap();
+		while (in.next())
+		{
+			std::string key = in.key();
+			if (key == "battleGame")
+			{
+				battle = in.tell();
+				in.skip();
+			}
+			else
+			{
+				doc.force_insert(key, in.node());
+			}
+		}
+		loadContents(doc, mod, lang);
+		if (battle != 0)
+		{
+			in.seek(battle);
+			_battleGame = new SavedBattleGame(mod, lang);
+			_battleGame->load(in, mod, this);
+		}
+	}
+	else
+	{
+		std::vector<YAML::Node> file = YAML::LoadAll(std::string((const char*)data.data(), data.size()));
+		loadBrief(file[0], filename);
+		loadContents(file[1], mod, lang);
+	}
+}
+
+/**
+ * Loads the brief save info, shown in the saves list.
+ * @param brief YAML node.
+ * @param filename Save filename, used if the save has no name.
+ */
+void SavedGame::loadBrief(const YAML::Node &brief, const std::string &filename)
+{
 	_time->load(brief["time"]);
 	if (brief["name"])
 	{
@@ -423,9 +473,16 @@ void SavedGame::load(const std::string &filename, Mod *mod, Language *lang)
 		_name = filename;
 	}
 	_ironman = brief["ironman"].as<bool>(_ironman);
+}
 
-	// Get full save data
-	YAML::Node doc = file[1];
+/**
+ * Loads the full game data of a save.
+ * @param doc YAML node.
+ * @param mod Mod for the saved game.
+ * @param lang Loaded language.
+ */
+void SavedGame::loadContents(const YAML::Node &doc, Mod *mod, Language *lang)
+{
 	_difficulty = (GameDifficulty)doc["difficulty"].as<int>(_difficulty);
 	_end = (GameEnding)doc["end"].as<int>(_end);
 	if (doc["rng"] && (_ironman || !Options::newSeedOnLoad))
@@ -791,15 +848,29 @@ void SavedGame::load(const std::string &filename, Mod *mod, Language *lang)
 }
 
 /**
- * Saves a saved game's contents to a YAML file.
- * @param filename YAML filename.
+ * Saves a saved game's contents to a YAML file, or to a binary save
+ * with the "oxceBinarySaves" option.
+ * @param filename Save filename.
  */
 void SavedGame::save(const std::string &filename, Mod *mod) const
 {
-	YAML::Emitter out;
+	BackgroundSave::wait();
+	writeSnapshot(takeSnapshot(mod), filename);
+}
+
+/**
+ * Copies the saved game's contents into a snapshot, which doesn't
+ * depend on the game anymore and can be written on any thread.
+ * In binary it's already the whole save, in YAML it still needs emitting.
+ * @param mod Mod for the saved game.
+ * @return Snapshot of the save.
+ */
+SaveSnapshot SavedGame::takeSnapshot(Mod *mod) const
+{
+	SaveSnapshot snapshot;
 
 	// Saves the brief game info used in the saves list
-	YAML::Node brief;
+	YAML::Node &brief = snapshot.brief;
 	brief["name"] = _name;
 	brief["version"] = OPENXCOM_VERSION_SHORT;
 	std::string git_sha = OPENXCOM_VERSION_GIT;
@@ -827,10 +898,8 @@ void SavedGame::save(const std::string &filename, Mod *mod) const
 	brief["mods"] = modsList;
 	if (_ironman)
 		brief["ironman"] = _ironman;
-	out << brief;
 	// Saves the full game data to the save
-	out << YAML::BeginDoc;
-	YAML::Node node;
+	YAML::Node &node = snapshot.contents;
 	node["difficulty"] = (int)_difficulty;
 	node["end"] = (int)_end;
 	node["monthsPassed"] = _monthsPassed;
@@ -959,17 +1028,52 @@ void SavedGame::save(const std::string &filename, Mod *mod) const
 	{
 		node["autoSales"].push_back((*i)->getName());
 	}
-	if (_battleGame != 0)
+	if (_battleGame != 0 && !Options::oxceBinarySaves)
 	{
 		node["battleGame"] = _battleGame->save();
 	}
 	_scriptValues.save(node, mod->getScriptGlobal());
 
-	out << node;
-
+	if (Options::oxceBinarySaves)
+	{
+		// the battle is the biggest part, so it's written straight to the save
+		BinarySaveWriter out(brief);
+		out.beginMap();
+		out.entries(node);
+		if (_battleGame != 0)
+		{
+			out.key("battleGame");
+			_battleGame->save(out);
+		}
+		out.end();
+		snapshot.binary = out.takeData();
+	}
+	return snapshot;
+}
 
+/**
+ * Writes a snapshot of a saved game to a file.
+ * Doesn't touch any game state, so it's safe to call on a worker thread.
+ * @param snapshot Snapshot of the save.
+ * @param filename Save filename.
+ */
+void SavedGame::writeSnapshot(const SaveSnapshot &snapshot, const std::string &filename)
+{
 	std::string filepath = Options::getMasterUserFolder() + filename;
-	if (!CrossPlatform::writeFile(filepath, out.c_str()))
+	bool written;
+	if (!snapshot.binary.empty())
+	{
+		written = CrossPlatform::writeFile(filepath, snapshot.binary);
+	}
+	else
+	{
+		YAML::Emitter out;
+		out << snapshot.brief;
+		out << YAML::BeginDoc;
+		out << snapshot.contents;
+		written = CrossPlatform::writeFile(filepath, out.c_str());
+	}
+	if (!written)
 	{
 		throw Exception("Failed to save " + filepath);
 	}
@@ -23,6 +23,7 @@
 #include <string>
 #include <time.h>
 #include <stdint.h>
+#include <yaml-cpp/yaml.h>
 #include "GameTime.h"
 #include "../Mod/RuleAlienMission.h"
 #include "../Mod/RuleEvent.h"
@@ -94,6 +95,16 @@ struct SaveInfo
 	bool reserved;
 };
 
+/**
+ * Copy of a saved game's contents, ready to be written to a file.
+ * Binary saves are fully serialized, YAML ones are kept as nodes.
+ */
+struct SaveSnapshot
+{
+	YAML::Node brief, contents;
+	std::vector<unsigned char> binary;
+};
+
 struct PromotionInfo
 {
 	int totalSoldiers;
@@ -176,6 +187,10 @@ private:
 	ScriptValues<SavedGame> _scriptValues;
 
 	static SaveInfo getSaveInfo(const std::string &file, Language *lang);
+	/// Loads the brief save info.
+	void loadBrief(const YAML::Node &brief, const std::string &filename);
+	/// Loads the full game data.
+	void loadContents(const YAML::Node &doc, Mod *mod, Language *lang);
 public:
 	static const std::string AUTOSAVE_GEOSCAPE, AUTOSAVE_BATTLESCAPE, QUICKSAVE;
 	/// Creates a new saved game.
@@ -186,10 +201,14 @@ public:
 	static std::string sanitizeModName(const std::string &name);
 	/// Gets list of saves in the user directory.
 	static std::vector<SaveInfo> getList(Language *lang, bool autoquick);
-	/// Loads a saved game from YAML.
+	/// Loads a saved game from YAML or a binary save.
 	void load(const std::string &filename, Mod *mod, Language *lang);
-	/// Saves a saved game to YAML.
+	/// Saves a saved game to YAML or a binary save.
 	void save(const std::string &filename, Mod *mod) const;
+	/// Copies the saved game into a snapshot that can be written later.
+	SaveSnapshot takeSnapshot(Mod *mod) const;
+	/// Writes a snapshot to a save file.
+	static void writeSnapshot(const SaveSnapshot &snapshot, const std::string &filename);
 	/// Gets the game name.
 	std::string getName() const;
 	/// Sets the game name.
@@ -51,8 +51,10 @@ Tile::SerializationKey Tile::serializationKey =
 /**
  * constructor
  * @param pos Position.
+ * @param store Store of the battle, holding the light, fire and smoke of the tile.
+ * @param index Index of the tile in the store.
  */
-Tile::Tile(Position pos): _pos(pos), _unit(0), _visible(false), _preview(-1), _TUMarker(-1), _overlaps(0)
+Tile::Tile(Position pos, TileStore *store, int index): _store(store), _index(index), _pos(pos), _unit(0), _preview(-1), _TUMarker(-1), _overlaps(0)
 {
 	for (int i = 0; i < O_MAX; ++i)
 	{
@@ -61,10 +63,6 @@ Tile::Tile(Position pos): _pos(pos), _unit(0), _visible(false), _preview(-1), _T
 		_mapData->SetID[i] = -1;
 		_objectsCache[i].currentFrame = 0;
 	}
-	for (int layer = 0; layer < LL_MAX; layer++)
-	{
-		_light[layer] = 0;
-	}
 	for (int i = 0; i < O_MAX; ++i)
 	{
 		_objectsCache[i].discovered = 0;
@@ -92,8 +90,8 @@ void Tile::load(const YAML::Node &node)
 		_mapData->ID[i] = node["mapDataID"][i].as<int>(_mapData->ID[i]);
 		_mapData->SetID[i] = node["mapDataSetID"][i].as<int>(_mapData->SetID[i]);
 	}
-	_fire = node["fire"].as<int>(_fire);
-	_smoke = node["smoke"].as<int>(_smoke);
+	_store->getFire()[_index] = node["fire"].as<int>(getFire());
+	_store->getSmoke()[_index] = node["smoke"].as<int>(getSmoke());
 	if (node["discovered"])
 	{
 		for (int i = 0; i < 3; i++)
@@ -110,7 +108,7 @@ void Tile::load(const YAML::Node &node)
 	{
 		_objectsCache[2].currentFrame = 7;
 	}
-	if (_fire || _smoke)
+	if (getFire() || getSmoke())
 	{
 		_animationOffset = RNG::seedless(0, 3);
 	}
@@ -132,8 +130,8 @@ void Tile::loadBinary(Uint8 *buffer, Tile::SerializationKey& serKey)
 	_mapData->SetID[2] = unserializeInt(&buffer, serKey._mapDataSetID);
 	_mapData->SetID[3] = unserializeInt(&buffer, serKey._mapDataSetID);
 
-	_smoke = unserializeInt(&buffer, serKey._smoke);
-	_fire = unserializeInt(&buffer, serKey._fire);
+	_store->getSmoke()[_index] = unserializeInt(&buffer, serKey._smoke);
+	_store->getFire()[_index] = unserializeInt(&buffer, serKey._fire);
 
 	Uint8 boolFields = unserializeInt(&buffer, serKey.boolFields);
 	_objectsCache[O_WESTWALL].discovered = (boolFields & 1) ? 1 : 0;
@@ -141,7 +139,7 @@ void Tile::loadBinary(Uint8 *buffer, Tile::SerializationKey& serKey)
 	_objectsCache[O_FLOOR].discovered = (boolFields & 4) ? 1 : 0;
 	_objectsCache[O_WESTWALL].currentFrame = (boolFields & 8) ? 7 : 0;
 	_objectsCache[O_NORTHWALL].currentFrame = (boolFields & 0x10) ? 7 : 0;
-	if (_fire || _smoke)
+	if (getFire() || getSmoke())
 	{
 		_animationOffset = RNG::seedless(0, 3);
 	}
@@ -161,10 +159,10 @@ YAML::Node Tile::save() const
 		node["mapDataID"].push_back(_mapData->ID[i]);
 		node["mapDataSetID"].push_back(_mapData->SetID[i]);
 	}
-	if (_smoke)
-		node["smoke"] = _smoke;
-	if (_fire)
-		node["fire"] = _fire;
+	if (getSmoke())
+		node["smoke"] = getSmoke();
+	if (getFire())
+		node["fire"] = getFire();
 	if (_objectsCache[O_FLOOR].discovered || _objectsCache[O_WESTWALL].discovered || _objectsCache[O_NORTHWALL].discovered)
 	{
 		throw Exception("Obsolete code");
@@ -199,8 +197,8 @@ void Tile::saveBinary(Uint8** buffer) const
 	serializeInt(buffer, serializationKey._mapDataSetID, _mapData->SetID[2]);
 	serializeInt(buffer, serializationKey._mapDataSetID, _mapData->SetID[3]);
 
-	serializeInt(buffer, serializationKey._smoke, _smoke);
-	serializeInt(buffer, serializationKey._fire, _fire);
+	serializeInt(buffer, serializationKey._smoke, getSmoke());
+	serializeInt(buffer, serializationKey._fire, getFire());
 
 	Uint8 boolFields = (_objectsCache[O_WESTWALL].discovered?1:0) + (_objectsCache[O_NORTHWALL].discovered?2:0) + (_objectsCache[O_FLOOR].discovered?4:0);
 	boolFields |= isUfoDoorOpen(O_WESTWALL) ? 8 : 0; // west
@@ -247,7 +245,7 @@ void Tile::setMapData(MapData *dat, int mapDataID, int mapDataSetID, TilePart pa
 		{
 			_cache.bigWall = 0;
 		}
-		_cache.terrainLevel = level;
+		_store->getTerrainLevel()[_index] = level;
 	}
 	updateSprite(part);
 }
@@ -271,7 +269,7 @@ void Tile::getMapData(int *mapDataID, int *mapDataSetID, TilePart part) const
  */
 bool Tile::isVoid() const
 {
-	return _objects[0] == 0 && _objects[1] == 0 && _objects[2] == 0 && _objects[3] == 0 && _smoke == 0 && _inventory.empty();
+	return _objects[0] == 0 && _objects[1] == 0 && _objects[2] == 0 && _objects[3] == 0 && getSmoke() == 0 && _inventory.empty();
 }
 
 /**
@@ -439,7 +437,7 @@ bool Tile::isDiscovered(TilePart part) const
  */
 void Tile::resetLight(LightLayers layer)
 {
-	_light[layer] = 0;
+	_store->getLight(layer)[_index] = 0;
 }
 
 /**
@@ -450,7 +448,7 @@ void Tile::resetLightMulti(LightLayers layer)
 {
 	for (int l = layer; l < LL_MAX; l++)
 	{
-		_light[l] = 0;
+		_store->getLight((LightLayers)l)[_index] = 0;
 	}
 }
 
@@ -461,8 +459,9 @@ void Tile::resetLightMulti(LightLayers layer)
  */
 void Tile::addLight(int light, LightLayers layer)
 {
-	if (_light[layer] < light)
-		_light[layer] = light;
+	Uint8 &current = _store->getLight(layer)[_index];
+	if (current < light)
+		current = light;
 }
 
 /**
@@ -472,7 +471,7 @@ void Tile::addLight(int light, LightLayers layer)
  */
 int Tile::getLight(LightLayers layer) const
 {
-	return _light[layer];
+	return _store->getLight(layer)[_index];
 }
 
 int Tile::getLightMulti(LightLayers layer) const
@@ -481,8 +480,9 @@ int Tile::getLightMulti(LightLayers layer) const
 
 	for (int l = layer; l >= 0; --l)
 	{
-		if (_light[l] > light)
-			light = _light[l];
+		const int current = _store->getLight((LightLayers)l)[_index];
+		if (current > light)
+			light = current;
 	}
 
 	return light;
@@ -500,8 +500,9 @@ int Tile::getShade() const
 
 	for (int layer = 0; layer < LL_MAX; layer++)
 	{
-		if (_light[layer] > light)
-			light = _light[layer];
+		const int current = _store->getLight((LightLayers)layer)[_index];
+		if (current > light)
+			light = current;
 	}
 
 	return std::max(0, 15 - light);
@@ -659,11 +660,12 @@ void Tile::ignite(int power)
 		}
 		if (RNG::percent(power) && getFuel())
 		{
-			if (_fire == 0)
+			if (getFire() == 0)
 			{
-				_smoke = 15 - Clamp(getFlammability() / 10, 1, 12);
+				_store->getSmoke()[_index] = 15 - Clamp(getFlammability() / 10, 1, 12);
 				_overlaps = 1;
-				_fire = getFuel() + 1;
+				_store->getFire()[_index] = getFuel() + 1;
+				_store->changeHazard();
 				_animationOffset = RNG::generate(0,3);
 			}
 		}
@@ -742,7 +744,8 @@ BattleUnit *Tile::getOverlappingUnit(const SavedBattleGame *saveBattleGame, Tile
  */
 void Tile::setFire(int fire)
 {
-	_fire = Clamp(fire, 0, 255);
+	_store->getFire()[_index] = Clamp(fire, 0, 255);
+	_store->changeHazard();
 	_animationOffset = RNG::generate(0,3);
 }
 
@@ -752,7 +755,7 @@ void Tile::setFire(int fire)
  */
 int Tile::getFire() const
 {
-	return _fire;
+	return _store->getFire()[_index];
 }
 
 /**
@@ -761,16 +764,18 @@ int Tile::getFire() const
  */
 void Tile::addSmoke(int smoke)
 {
-	if (_fire == 0)
+	if (getFire() == 0)
 	{
+		Uint8 &current = _store->getSmoke()[_index];
 		if (_overlaps == 0)
 		{
-			_smoke = Clamp(_smoke + smoke, 1, 15);
+			current = Clamp(current + smoke, 1, 15);
 		}
 		else
 		{
-			_smoke += smoke;
+			current += smoke;
 		}
+		_store->changeHazard();
 		_animationOffset = RNG::generate(0,3);
 		addOverlap();
 	}
@@ -782,7 +787,8 @@ void Tile::addSmoke(int smoke)
  */
 void Tile::setSmoke(int smoke)
 {
-	_smoke = Clamp(smoke, 0, 255);
+	_store->getSmoke()[_index] = Clamp(smoke, 0, 255);
+	_store->changeHazard();
 	_animationOffset = RNG::generate(0,3);
 }
 
@@ -793,7 +799,7 @@ void Tile::setSmoke(int smoke)
  */
 int Tile::getSmoke() const
 {
-	return _smoke;
+	return _store->getSmoke()[_index];
 }
 
 /**
@@ -909,18 +915,21 @@ static inline void applyEnvi(BattleUnit* unit, int smoke, int fire, bool smokeDa
  */
 void Tile::prepareNewTurn(bool smokeDamage)
 {
+	Uint8 &smoke = _store->getSmoke()[_index];
+	const int fire = getFire();
 	// we've received new smoke in this turn, but we're not on fire, average out the smoke.
-	if ( _overlaps != 0 && _smoke != 0 && _fire == 0)
+	if ( _overlaps != 0 && smoke != 0 && fire == 0)
 	{
-		_smoke = Clamp((_smoke / _overlaps) - 1, 0, 15);
+		smoke = Clamp((smoke / _overlaps) - 1, 0, 15);
+		_store->changeHazard();
 	}
 	// if we still have smoke/fire
-	if (_smoke)
+	if (smoke)
 	{
-		applyEnvi(_unit, _smoke, _fire, smokeDamage);
+		applyEnvi(_unit, smoke, fire, smokeDamage);
 		for (std::vector<BattleItem*>::iterator i = _inventory.begin(); i != _inventory.end(); ++i)
 		{
-			applyEnvi((*i)->getUnit(), _smoke, _fire, smokeDamage);
+			applyEnvi((*i)->getUnit(), smoke, fire, smokeDamage);
 		}
 	}
 	_overlaps = 0;
@@ -960,7 +969,7 @@ int Tile::getMarkerColor() const
  */
 void Tile::setVisible(int visibility)
 {
-	_visible += visibility;
+	_store->getVisible()[_index] += visibility;
 }
 
 /**
@@ -969,7 +978,7 @@ void Tile::setVisible(int visibility)
  */
 int Tile::getVisible() const
 {
-	return _visible;
+	return _store->getVisible()[_index];
 }
 
 /**
@@ -1030,7 +1039,7 @@ void Tile::addOverlap()
  */
 void Tile::setDangerous(bool danger)
 {
-	_cache.danger = danger;
+	_store->getDanger()[_index] = danger;
 }
 
 /**
@@ -1039,7 +1048,7 @@ void Tile::setDangerous(bool danger)
  */
 bool Tile::getDangerous() const
 {
-	return _cache.danger;
+	return _store->getDanger()[_index];
 }
 
 /**
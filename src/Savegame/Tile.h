@@ -23,6 +23,7 @@
 #include "../Engine/Surface.h"
 #include "../Battlescape/Position.h"
 #include "../Mod/MapData.h"
+#include "TileStore.h"
 
 #include <SDL_types.h> // for Uint8
 
@@ -36,8 +37,6 @@ class RuleInventory;
 class Particle;
 class ScriptParserBase;
 
-enum LightLayers : Uint8 { LL_AMBIENT, LL_FIRE, LL_ITEMS, LL_UNITS, LL_MAX };
-
 enum TileUnitOverlapping : int
 {
 	/// Any unit overlapping tile will be returned
@@ -100,10 +99,8 @@ public:
 	 */
 	struct TileCache
 	{
-		Sint8 terrainLevel = 0;
 		Uint8 isNoFloor:1;
 		Uint8 bigWall:1;
-		Uint8 danger:1;
 	};
 
 protected:
@@ -112,9 +109,8 @@ protected:
 	SurfaceRaw<const Uint8> _currentSurface[O_MAX] = { };
 	TileObjectCache _objectsCache[O_MAX] = { };
 	TileCache _cache = { };
-	Uint8 _light[LL_MAX];
-	Uint8 _fire = 0;
-	Uint8 _smoke = 0;
+	TileStore *_store;
+	int _index;
 	Uint8 _markerColor = 0;
 	Uint8 _animationOffset = 0;
 	Uint8 _obstacle = 0;
@@ -123,7 +119,6 @@ protected:
 	Position _pos;
 	BattleUnit *_unit;
 	std::vector<BattleItem *> _inventory;
-	int _visible;
 	int _preview;
 	int _TUMarker;
 	int _overlaps;
@@ -131,7 +126,7 @@ protected:
 
 public:
 	/// Creates a tile.
-	Tile(Position pos);
+	Tile(Position pos, TileStore *store, int index);
 	/// Copy constructor.
 	Tile(Tile&&) = default;
 	/// Cleans up a tile.
@@ -199,7 +194,7 @@ public:
 	 */
 	int getTerrainLevel() const
 	{
-		return _cache.terrainLevel;
+		return _store->getTerrainLevel()[_index];
 	}
 
 	/**
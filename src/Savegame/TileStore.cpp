@@ -0,0 +1,80 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "TileStore.h"
+#include <algorithm>
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a store without any tiles.
+ */
+TileStore::TileStore() : _size(0), _hazardVersion(0)
+{
+
+}
+
+/**
+ * Cleans up the store.
+ */
+TileStore::~TileStore()
+{
+
+}
+
+/**
+ * Sets the number of tiles in the store. All the values
+ * go back to the ones of a new tile.
+ * @param size Number of tiles.
+ */
+void TileStore::resize(int size)
+{
+	_size = size;
+	_light.assign(LL_MAX * size, 0);
+	_fire.assign(size, 0);
+	_smoke.assign(size, 0);
+	_danger.assign(size, 0);
+	_terrainLevel.assign(size, 0);
+	_visible.assign(size, 0);
+	changeHazard();
+}
+
+/**
+ * Clears the light of a range of tiles in a layer and all the layers above it.
+ * @param layer First layer to clear.
+ * @param begin Index of the first tile.
+ * @param count Number of tiles.
+ */
+void TileStore::resetLight(LightLayers layer, int begin, int count)
+{
+	for (int l = layer; l < LL_MAX; ++l)
+	{
+		std::fill_n(_light.data() + l * _size + begin, count, 0);
+	}
+}
+
+/**
+ * Clears the danger flag of all the tiles.
+ */
+void TileStore::resetDanger()
+{
+	std::fill(_danger.begin(), _danger.end(), 0);
+}
+
+}
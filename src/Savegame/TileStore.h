@@ -0,0 +1,88 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vector>
+#include <SDL_types.h>
+
+namespace OpenXcom
+{
+
+enum LightLayers : Uint8 { LL_AMBIENT, LL_FIRE, LL_ITEMS, LL_UNITS, LL_MAX };
+
+/**
+ * Dense arrays of the tile values that get scanned over the whole map,
+ * like light, fire and smoke, indexed the same as the tiles of the battle.
+ * The tiles keep their getters and setters, they just read and write
+ * here, while the loops over big parts of the map can go through these
+ * arrays without touching the tile objects.
+ */
+class TileStore
+{
+private:
+	int _size;
+	std::vector<Uint8> _light;
+	std::vector<Uint8> _fire, _smoke, _danger;
+	std::vector<Sint8> _terrainLevel;
+	std::vector<int> _visible;
+	unsigned _hazardVersion;
+public:
+	/// Creates an empty store.
+	TileStore();
+	/// Cleans up the store.
+	~TileStore();
+	/// Sets the number of tiles, clearing all the values.
+	void resize(int size);
+	/// Gets the number of tiles.
+	int getSize() const { return _size; }
+	/// Clears the light of a range of tiles, from a layer up.
+	void resetLight(LightLayers layer, int begin, int count);
+	/// Clears the danger flag of all tiles.
+	void resetDanger();
+	/// Gets a counter that changes with every change of fire or smoke.
+	unsigned getHazardVersion() const { return _hazardVersion; }
+	/// Marks that the fire or smoke of some tile changed.
+	void changeHazard() { ++_hazardVersion; }
+
+	/// Gets the light of all tiles in a layer.
+	Uint8 *getLight(LightLayers layer) { return _light.data() + layer * _size; }
+	/// Gets the light of all tiles in a layer.
+	const Uint8 *getLight(LightLayers layer) const { return _light.data() + layer * _size; }
+	/// Gets the fire of all tiles.
+	Uint8 *getFire() { return _fire.data(); }
+	/// Gets the fire of all tiles.
+	const Uint8 *getFire() const { return _fire.data(); }
+	/// Gets the smoke of all tiles.
+	Uint8 *getSmoke() { return _smoke.data(); }
+	/// Gets the smoke of all tiles.
+	const Uint8 *getSmoke() const { return _smoke.data(); }
+	/// Gets the danger flag of all tiles.
+	Uint8 *getDanger() { return _danger.data(); }
+	/// Gets the danger flag of all tiles.
+	const Uint8 *getDanger() const { return _danger.data(); }
+	/// Gets the terrain level of all tiles.
+	Sint8 *getTerrainLevel() { return _terrainLevel.data(); }
+	/// Gets the terrain level of all tiles.
+	const Sint8 *getTerrainLevel() const { return _terrainLevel.data(); }
+	/// Gets the visibility counter of all tiles.
+	int *getVisible() { return _visible.data(); }
+	/// Gets the visibility counter of all tiles.
+	const int *getVisible() const { return _visible.data(); }
+};
+
+}
@@ -26,6 +26,7 @@
 #include "Engine/Options.h"
 #include "Engine/FileMap.h"
 #include "Menu/StartState.h"
+#include "Battlescape/BattlescapeBenchmark.h"
 
 /** @mainpage
  * @author OpenXcom Developers
@@ -117,6 +118,23 @@ int main(int argc, char *argv[])
 	Options::baseXResolution = Options::displayWidth;
 	Options::baseYResolution = Options::displayHeight;
 
+	if (!Options::getBenchmark().empty())
+	{
+		// no window or sound needed, just the game logic
+		SDL_putenv((char*)"SDL_VIDEODRIVER=dummy");
+		SDL_putenv((char*)"SDL_AUDIODRIVER=dummy");
+		game = new Game(title.str());
+		State::setGamePtr(game);
+		bool success;
+		{
+			BattlescapeBenchmark benchmark(game);
+			success = benchmark.run();
+		}
+		delete game;
+		FileMap::clear(true, false);
+		return success ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	game = new Game(title.str());
 	State::setGamePtr(game);
 	game->setState(new StartState);